@@ -0,0 +1,93 @@
+#version 440
+
+in vec3 Position;
+in vec3 Normal;
+flat in uint MaterialIndex;
+
+struct PointLight {
+    vec4 Position;
+    vec4 Color;
+};
+
+layout (std140, binding = 1) uniform Frame {
+    mat4 View;
+    mat4 Projection;
+    mat4 ViewProjection;
+    vec4 CamPos;
+    vec4 AmbientColor;
+    ivec4 PointLightCount;
+    PointLight PointLights[8];
+};
+
+struct MaterialInfo {
+    vec4 Ka;  // Ambient reflectivity
+    vec4 Kd;  // Diffuse reflectivity
+    vec4 Ks;  // Specular reflectivity, w is the specular exponent (phong)
+};
+
+layout (std140, binding = 2) uniform Materials {
+    MaterialInfo materials[256];
+};
+
+layout (std140, binding = 3) uniform Shadows {
+    mat4 CascadeViewProjection[4];
+    mat4 CascadeAtlas[4];      // World to atlas texture coordinates and depth
+    vec4 CascadeSplits;        // View distance each cascade ends at
+    vec4 SunDirection;         // Towards the sun
+    vec4 SunColor;
+    vec4 ShadowParams;         // x: atlas texel size, y: depth bias
+};
+
+layout (binding = 5) uniform sampler2DShadow ShadowAtlas;
+
+// Lit fraction, 3x3 PCF in the nearest cascade covering the fragment
+float SunVisibility(vec3 position)
+{
+    float viewDistance = -(View * vec4(position, 1.0)).z;
+    int cascade = 0;
+    while (cascade < 3 && viewDistance > CascadeSplits[cascade])
+        cascade++;
+    if (viewDistance > CascadeSplits[3])
+        return 1.0;
+
+    vec4 atlas = CascadeAtlas[cascade] * vec4(position, 1.0);
+    float reference = atlas.z - ShadowParams.y;
+    float lit = 0.0;
+    for (int y = -1; y <= 1; ++y)
+        for (int x = -1; x <= 1; ++x)
+            lit += texture(ShadowAtlas, vec3(atlas.xy + vec2(x, y) * ShadowParams.x, reference));
+    return lit / 9.0;
+}
+
+out vec4 FragColor;
+
+void main() {
+    MaterialInfo material = materials[MaterialIndex];
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(CamPos.xyz - Position);
+
+    vec3 result = AmbientColor.rgb * material.Ka.rgb;
+    for (int i = 0; i < PointLightCount.x; ++i)
+    {
+        vec3 lightDir = normalize(PointLights[i].Position.xyz - Position);
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 diffuse = diff * material.Kd.rgb;
+
+        vec3 reflectDir = reflect(-lightDir, norm);
+        float spec = 0.0;
+        if(diff > 0.0)
+            spec = pow(max(dot(viewDir, reflectDir), 0.0), material.Ks.w);
+        vec3 specular = spec * material.Ks.rgb;
+
+        result += PointLights[i].Color.rgb * (diffuse + specular);
+    }
+
+    float sunDiff = max(dot(norm, SunDirection.xyz), 0.0);
+    if (sunDiff > 0.0)
+    {
+        float sunSpec = pow(max(dot(viewDir, reflect(-SunDirection.xyz, norm)), 0.0), material.Ks.w);
+        result += SunColor.rgb * (sunDiff * material.Kd.rgb + sunSpec * material.Ks.rgb) * SunVisibility(Position);
+    }
+
+    FragColor = vec4(result, 1.0);
+}
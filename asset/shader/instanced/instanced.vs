@@ -0,0 +1,44 @@
+#version 440
+
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 1) in vec3 VertexNormal;
+layout (location = 2) in uint InstanceIndex; // Instance of the draw command in the buffer
+
+out vec3 Position;
+out vec3 Normal;
+flat out uint MaterialIndex;
+
+struct PointLight {
+    vec4 Position;
+    vec4 Color;
+};
+
+layout (std140, binding = 1) uniform Frame {
+    mat4 View;
+    mat4 Projection;
+    mat4 ViewProjection;
+    vec4 CamPos;
+    vec4 AmbientColor;
+    ivec4 PointLightCount;
+    PointLight PointLights[8];
+};
+
+struct InstanceData {
+    mat4 ModelMatrix;
+    mat4 NormalMatrix; // mat3 padded to mat4 for std430
+    uvec4 Params;      // x: index in the material table
+};
+
+layout (std430, binding = 0) readonly buffer Instances {
+    InstanceData instances[];
+};
+
+void main()
+{
+    InstanceData instance = instances[InstanceIndex];
+    vec4 worldPosition = instance.ModelMatrix * vec4(VertexPosition, 1.0);
+    Normal = normalize(mat3(instance.NormalMatrix) * VertexNormal);
+    Position = worldPosition.xyz;
+    MaterialIndex = instance.Params.x;
+    gl_Position = ViewProjection * worldPosition;
+}
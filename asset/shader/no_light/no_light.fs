@@ -11,8 +11,21 @@ struct MaterialInfo {
 };
 uniform MaterialInfo Material;
 
-// Light properties
-uniform vec3 CamPos;    // Camera position in world space
+struct PointLight {
+    vec4 Position;
+    vec4 Color;
+};
+
+// Per-frame data shared by every program, CamPos is the camera position in world space
+layout (std140, binding = 1) uniform Frame {
+    mat4 View;
+    mat4 Projection;
+    mat4 ViewProjection;
+    vec4 CamPos;
+    vec4 AmbientColor;
+    ivec4 PointLightCount;
+    PointLight PointLights[8];
+};
 
 out vec4 FragColor;
 
@@ -29,7 +42,7 @@ void main() {
     vec3 diffuse = diff * Material.Kd;
 
     // Specular term (Phong)
-    vec3 viewDir = normalize(CamPos - Position);
+    vec3 viewDir = normalize(CamPos.xyz - Position);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = 0.0;
     if(diff > 0.0)
@@ -0,0 +1,23 @@
+#version 440
+
+in vec2 Corner;
+in float Alpha;
+in float Life;
+
+uniform vec3 Tint;
+
+out vec4 FragColor;
+
+void main() {
+    // Soft round puff
+    float falloff = 1.0 - smoothstep(0.3, 1.0, length(Corner));
+    float alpha = Alpha * falloff;
+    if (alpha <= 0.002)
+        discard;
+
+    // Fresh particles are a little darker, they thin out as they spread
+    vec3 color = Tint * mix(0.8, 1.0, Life);
+
+    // Premultiplied alpha
+    FragColor = vec4(color * alpha, alpha);
+}
@@ -0,0 +1,42 @@
+#version 440
+
+out vec2 Corner;
+out float Alpha;
+out float Life;
+
+layout (std140, binding = 1) uniform Frame {
+    mat4 View;
+    mat4 Projection;
+    mat4 ViewProjection;
+    vec4 CamPos;
+};
+
+struct Particle {
+    vec4 PositionSize; // xyz: world position, w: size
+    vec4 Params;       // x: alpha, y: age over lifetime, z: random in [0, 1)
+};
+
+layout (std430, binding = 3) readonly buffer Particles {
+    Particle particles[];
+};
+
+uniform int ParticleOffset; // First particle of the current material in the buffer
+
+void main()
+{
+    Particle particle = particles[ParticleOffset + gl_InstanceID];
+
+    // Triangle strip corners, rotated by the particle's random so the quads do not line up
+    Corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    float angle = particle.Params.z * 6.2831853;
+    vec2 rotated = mat2(cos(angle), sin(angle), -sin(angle), cos(angle)) * Corner;
+
+    // Camera right and up are the first two rows of the view matrix
+    vec3 right = vec3(View[0][0], View[1][0], View[2][0]);
+    vec3 up = vec3(View[0][1], View[1][1], View[2][1]);
+    vec3 worldPosition = particle.PositionSize.xyz + (right * rotated.x + up * rotated.y) * particle.PositionSize.w;
+
+    Alpha = particle.Params.x;
+    Life = particle.Params.y;
+    gl_Position = ViewProjection * vec4(worldPosition, 1.0);
+}
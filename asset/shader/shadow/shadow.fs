@@ -0,0 +1,6 @@
+#version 440
+
+// Depth only
+void main()
+{
+}
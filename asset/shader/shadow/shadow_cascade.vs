@@ -0,0 +1,40 @@
+#version 440
+
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 2) in uint InstanceIndex; // Same for the 4 copies of an instance, one per cascade
+
+struct InstanceData {
+    mat4 ModelMatrix;
+    mat4 NormalMatrix;
+    uvec4 Params;
+};
+
+layout (std430, binding = 0) readonly buffer Instances {
+    InstanceData instances[];
+};
+
+layout (std140, binding = 3) uniform Shadows {
+    mat4 CascadeViewProjection[4];
+    mat4 CascadeAtlas[4];
+    vec4 CascadeSplits;
+    vec4 SunDirection;
+    vec4 SunColor;
+    vec4 ShadowParams;
+};
+
+out float gl_ClipDistance[4];
+
+void main()
+{
+    int cascade = gl_InstanceID % 4;
+    InstanceData instance = instances[InstanceIndex];
+    vec4 position = CascadeViewProjection[cascade] * instance.ModelMatrix * vec4(VertexPosition, 1.0);
+
+    // Clipped to the cascade's own bounds, then moved into its quarter of the atlas
+    gl_ClipDistance[0] = 1.0 + position.x;
+    gl_ClipDistance[1] = 1.0 - position.x;
+    gl_ClipDistance[2] = 1.0 + position.y;
+    gl_ClipDistance[3] = 1.0 - position.y;
+    vec2 tile = vec2(cascade % 2, cascade / 2);
+    gl_Position = vec4(position.xy * 0.5 + tile - 0.5, position.z, 1.0);
+}
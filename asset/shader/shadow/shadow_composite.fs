@@ -0,0 +1,29 @@
+#version 440
+
+layout (binding = 6) uniform sampler2D StaticDepth;
+
+uniform vec4 TileRect;          // Viewport of the cascade in the atlas: x, y, size
+uniform vec4 CascadeBounds;     // Light view space: min x, min y, max x, max y
+uniform vec4 CacheBounds;
+uniform vec4 DepthRanges;       // Near and far of the cascade, near and far of the cache
+
+void main()
+{
+    vec2 uv = (gl_FragCoord.xy - TileRect.xy) / TileRect.z;
+    vec2 light = mix(CascadeBounds.xy, CascadeBounds.zw, uv);
+    vec2 cacheUv = (light - CacheBounds.xy) / (CacheBounds.zw - CacheBounds.xy);
+    if (any(lessThan(cacheUv, vec2(0.0))) || any(greaterThan(cacheUv, vec2(1.0))))
+    {
+        gl_FragDepth = 1.0;
+        return;
+    }
+    float depth = texture(StaticDepth, cacheUv).r;
+    if (depth >= 1.0)
+    {
+        gl_FragDepth = 1.0;
+        return;
+    }
+    // Same light direction, different depth range
+    float lightDistance = mix(DepthRanges.z, DepthRanges.w, depth);
+    gl_FragDepth = clamp((lightDistance - DepthRanges.x) / (DepthRanges.y - DepthRanges.x), 0.0, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 440
+
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 2) in uint InstanceIndex;
+
+struct InstanceData {
+    mat4 ModelMatrix;
+    mat4 NormalMatrix;
+    uvec4 Params;
+};
+
+layout (std430, binding = 0) readonly buffer Instances {
+    InstanceData instances[];
+};
+
+uniform mat4 LightViewProjection; // Bounds of the static cache
+
+void main()
+{
+    InstanceData instance = instances[InstanceIndex];
+    gl_Position = LightViewProjection * instance.ModelMatrix * vec4(VertexPosition, 1.0);
+}
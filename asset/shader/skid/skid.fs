@@ -0,0 +1,11 @@
+#version 440
+
+in float Alpha;
+
+out vec4 FragColor;
+
+void main() {
+    // Premultiplied alpha: dark rubber over the track
+    const vec3 rubber = vec3(0.04, 0.04, 0.045);
+    FragColor = vec4(rubber * Alpha, Alpha);
+}
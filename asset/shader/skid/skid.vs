@@ -0,0 +1,26 @@
+#version 440
+
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 1) in float VertexAlpha;
+
+out float Alpha;
+
+layout (std140, binding = 1) uniform Frame {
+    mat4 View;
+    mat4 Projection;
+    mat4 ViewProjection;
+    vec4 CamPos;
+};
+
+uniform int HeadSlot; // Ring slot the next quad will be written to
+uniform int Capacity; // Quads in the ring
+uniform int Drawable; // Quads drawn, the rest is the guard ahead of the head
+
+void main()
+{
+    // Quads fade out over the last quarter of the ring before being overwritten
+    int slot = gl_VertexID / 4;
+    int age = (HeadSlot - slot + Capacity) % Capacity;
+    Alpha = VertexAlpha * (1.0 - smoothstep(0.75 * Drawable, float(Drawable), float(age)));
+    gl_Position = ViewProjection * vec4(VertexPosition, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 440
+
+in vec2 UV;
+in vec3 Color;
+
+out vec4 FragColor;
+
+layout (binding = 0) uniform sampler2D Atlas; // Signed distance field, 0.5 on the glyph edge
+
+void main()
+{
+    float fieldDistance = texture(Atlas, UV).r;
+    // About one screen pixel of anti-aliasing at any text size
+    float edgeWidth = max(fwidth(fieldDistance), 1e-4);
+    float alpha = smoothstep(0.5 - edgeWidth, 0.5 + edgeWidth, fieldDistance);
+    FragColor = vec4(Color, alpha);
+}
@@ -0,0 +1,17 @@
+#version 440
+
+layout (location = 0) in vec2 VertexPosition;
+layout (location = 1) in vec2 VertexUV;
+layout (location = 2) in vec3 VertexColor;
+
+out vec2 UV;
+out vec3 Color;
+
+uniform mat4 Projection; // Window pixels, origin at the bottom left
+
+void main()
+{
+    UV = VertexUV;
+    Color = VertexColor;
+    gl_Position = Projection * vec4(VertexPosition, 0.0, 1.0);
+}
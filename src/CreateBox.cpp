@@ -125,13 +125,15 @@ ES::Engine::Entity CreateBox(
 	ES::Engine::Core &core,
 	const glm::vec3 &position,
 	const glm::quat &rotation,
-	const glm::vec3 &size)
+	const glm::vec3 &size,
+	const JPH::PhysicsMaterial *material)
 {
 	using namespace JPH;
 
 	glm::vec3 box_scale = glm::vec3(1.0f, 1.0f, 1.0f);
 
 	std::shared_ptr<BoxShapeSettings> box_shape_settings = std::make_shared<BoxShapeSettings>(JPH::Vec3(size.x, size.y, size.z));
+	box_shape_settings->mMaterial = material;
 	ES::Engine::Entity box = core.CreateEntity();
 
 	box.AddComponent<ES::Plugin::Object::Component::Transform>(core, position, box_scale, rotation);
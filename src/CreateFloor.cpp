@@ -4,13 +4,19 @@
 #include "JoltPhysics.hpp"
 #include "Object.hpp"
 #include "OpenGL.hpp"
+#include "render/InstancedModel.hpp"
 
-ES::Engine::Entity CreateFloor(ES::Engine::Core &core)
+#include <Jolt/Physics/Collision/PhysicsMaterialSimple.h>
+
+// Width of the run-off strip on each side
+static constexpr float RUNOFF_WIDTH = 6.0f;
+
+ES::Engine::Entity CreateFloor(ES::Engine::Core &core, float halfExtent)
 {
 	using namespace JPH;
 
 	glm::vec3 floor_position(0.0f, 0.0f, 0.0f);
-	glm::vec3 floor_size(20.0f, 1.0f, 20.0f);
+	glm::vec3 floor_size(halfExtent, 1.0f, halfExtent);
 
 	ES::Engine::Entity floor = CreateBox(
 		core,
@@ -19,9 +25,25 @@ ES::Engine::Entity CreateFloor(ES::Engine::Core &core)
 		floor_size
 	);
 
-	floor.AddComponent<ES::Plugin::OpenGL::Component::ShaderHandle>(core, "noTextureLightShadow");
-    floor.AddComponent<ES::Plugin::OpenGL::Component::MaterialHandle>(core, "floor");
-    floor.AddComponent<ES::Plugin::OpenGL::Component::ModelHandle>(core, "floor");
+	floor.AddComponent<InstancedModel>(core, "floor", "instanced", "floor");
+
+	// ParticleSystem tells loose surfaces apart by their material's name
+	static const RefConst<PhysicsMaterial> gravel = new PhysicsMaterialSimple("Gravel", Color(140, 115, 80));
+
+	// North and south strips cover the corners, east and west ones fill in between
+	const float offset = halfExtent + RUNOFF_WIDTH * 0.5f;
+	const glm::vec3 ns_size(halfExtent + RUNOFF_WIDTH, 1.0f, RUNOFF_WIDTH * 0.5f);
+	const glm::vec3 ew_size(RUNOFF_WIDTH * 0.5f, 1.0f, halfExtent);
+	for (const float side : {-1.0f, 1.0f})
+	{
+		ES::Engine::Entity ns = CreateBox(core, glm::vec3(0.0f, 0.0f, side * offset),
+			glm::quat(1.0f, 0.0f, 0.0f, 0.0f), ns_size, gravel);
+		ns.AddComponent<InstancedModel>(core, "runoff_ns", "instanced", "gravel");
+
+		ES::Engine::Entity ew = CreateBox(core, glm::vec3(side * offset, 0.0f, 0.0f),
+			glm::quat(1.0f, 0.0f, 0.0f, 0.0f), ew_size, gravel);
+		ew.AddComponent<InstancedModel>(core, "runoff_ew", "instanced", "gravel");
+	}
 
 	return floor;
 }
\ No newline at end of file
@@ -2,4 +2,6 @@
 
 #include "Engine.hpp"
 
-ES::Engine::Entity CreateFloor(ES::Engine::Core&);
+// Square floor whose top face is at y = 1, halfExtent meters from the origin on each side.
+// A gravel run-off, level with it, borders the paved part: cars sliding onto it throw dust.
+ES::Engine::Entity CreateFloor(ES::Engine::Core&, float halfExtent = 20.0f);
@@ -3,7 +3,9 @@
 #include "CreateBox.hpp"
 #include "CreateCylinder.hpp"
 #include "JoltPhysics.hpp"
+#include "Logger.hpp"
 #include "OpenGL.hpp"
+#include "render/InstancedModel.hpp"
 #include "WheeledVehicleKeyboardMovement.hpp"
 #include "WheeledVehicleControllerMovement.hpp"
 #include "WheeledVehicleCameraSync.hpp"
@@ -21,6 +23,8 @@
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/OffsetCenterOfMassShape.h>
 
+#include <cstdlib>
+
 static ES::Engine::Entity CreateVehicleBody(
     ES::Engine::Core &core,
     const glm::vec3 &position,
@@ -42,9 +46,7 @@ static ES::Engine::Entity CreateVehicleBody(
         JPH::EMotionType::Dynamic,
         ES::Plugin::Physics::Utils::Layers::MOVING);
 
-    vehicleBody.AddComponent<ES::Plugin::OpenGL::Component::ShaderHandle>(core, "noTextureLightShadow");
-    vehicleBody.AddComponent<ES::Plugin::OpenGL::Component::MaterialHandle>(core, "car_body");
-    vehicleBody.AddComponent<ES::Plugin::OpenGL::Component::ModelHandle>(core, "car_body");
+    vehicleBody.AddComponent<InstancedModel>(core, "car_body", "instanced", "car_body");
     vehicleBody.AddComponent<ES::Plugin::Object::Component::Mesh>(core, CreateBoxMesh(
         glm::vec3(halfVehicleWidth, halfVehicleHeight, halfVehicleLength)
     ));
@@ -68,9 +70,7 @@ static ES::Engine::Entity CreateVehicleWheel(
         16,
         glm::vec3(1.0f, 0.0f, 0.0f)
     ));
-    wheel.AddComponent<ES::Plugin::OpenGL::Component::ShaderHandle>(core, "noTextureLightShadow");
-    wheel.AddComponent<ES::Plugin::OpenGL::Component::MaterialHandle>(core, "car_wheel");
-    wheel.AddComponent<ES::Plugin::OpenGL::Component::ModelHandle>(core, "car_wheel");
+    wheel.AddComponent<InstancedModel>(core, "car_wheel", "instanced", "car_wheel");
 
     return wheel;
 }
@@ -104,34 +104,63 @@ static void RotateMesh(
     }
 }
 
-ES::Engine::Entity CreateVehicle(ES::Engine::Core &core)
+// The body model is parsed once and shared by every vehicle and vehicle visual
+static const ES::Plugin::Object::Component::Mesh &GetVehicleBodyMesh()
+{
+    static const ES::Plugin::Object::Component::Mesh vehicleBodyMesh = [] {
+        const std::string modelPath = "asset/Porsche_911_GT3_992_reduced.obj";
+        ES::Plugin::Object::Component::Mesh mesh;
+
+        if (!ES::Plugin::Object::Resource::OBJLoader::loadModel(
+            modelPath,
+            mesh.vertices,
+            mesh.normals,
+            mesh.texCoords,
+            mesh.indices
+        )) {
+            throw std::runtime_error("Failed to load vehicle model from " + modelPath);
+        }
+
+        // Model exported from Blender is wrongly oriented, so we need to rotate it
+        RotateMesh(mesh, glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(90.0f));
+        return mesh;
+    }();
+    return vehicleBodyMesh;
+}
+
+// Kept in sync with the wheel settings used by CreateVehicle
+constexpr float VEHICLE_WHEEL_RADIUS = 0.689f / 2.0f;
+constexpr float VEHICLE_WHEEL_WIDTH = 0.285f;
+
+VehicleVisual CreateVehicleVisual(ES::Engine::Core &core)
 {
-    const std::string modelPath = "asset/Porsche_911_GT3_992_reduced.obj";
-    ES::Plugin::Object::Component::Mesh vehicleBodyMesh;
-
-    if (!ES::Plugin::Object::Resource::OBJLoader::loadModel(
-        modelPath,
-        vehicleBodyMesh.vertices,
-        vehicleBodyMesh.normals,
-        vehicleBodyMesh.texCoords,
-        vehicleBodyMesh.indices
-    )) {
-        throw std::runtime_error("Failed to load vehicle model from " + modelPath);
+    VehicleVisual visual;
+    visual.body = core.CreateEntity();
+    visual.body.AddComponent<ES::Plugin::Object::Component::Transform>(core, glm::vec3(0.0f));
+    visual.body.AddComponent<ES::Plugin::Object::Component::Mesh>(core, GetVehicleBodyMesh());
+    visual.body.AddComponent<InstancedModel>(core, "car_body", "instanced", "car_body");
+
+    auto wheelMesh = CreateCylinderMesh(
+        glm::vec3(VEHICLE_WHEEL_RADIUS, VEHICLE_WHEEL_WIDTH, VEHICLE_WHEEL_RADIUS), 16, glm::vec3(1.0f, 0.0f, 0.0f));
+    for (auto &wheel : visual.wheels) {
+        wheel = core.CreateEntity();
+        wheel.AddComponent<ES::Plugin::Object::Component::Transform>(core, glm::vec3(0.0f));
+        wheel.AddComponent<ES::Plugin::Object::Component::Mesh>(core, wheelMesh);
+        wheel.AddComponent<InstancedModel>(core, "car_wheel", "instanced", "car_wheel");
     }
+    return visual;
+}
 
-    // Model exported from Blender is wrongly oriented, so we need to rotate it
-    RotateMesh(vehicleBodyMesh, glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(90.0f));
+ES::Engine::Entity BuildVehicle(ES::Engine::Core &core, const glm::vec3 &bodyPosition,
+                                const std::optional<WheelCollisionTesterSettings> &wheelTester)
+{
+    const ES::Plugin::Object::Component::Mesh &vehicleBodyMesh = GetVehicleBodyMesh();
 
     glm::vec3 boundingBoxSize = GetMeshBoundingBoxSize(vehicleBodyMesh);
 
-    printf("Vehicle body bounding box size: %.2f x %.2f x %.2f\n",
-           boundingBoxSize.x, boundingBoxSize.y, boundingBoxSize.z);
-
     // consts
-    glm::vec3 bodyPosition(0.0f, 30.0f, 0.0f);
-
-    float wheelRadius = 0.689 / 2.0f;
-    float wheelWidth = 0.285f;
+    float wheelRadius = VEHICLE_WHEEL_RADIUS;
+    float wheelWidth = VEHICLE_WHEEL_WIDTH;
     float halfVehicleLength = boundingBoxSize.z / 2.0f;
     float halfVehicleWidth = boundingBoxSize.x / 2.0f;
     float halfVehicleHeight = boundingBoxSize.y / 2.0f;
@@ -160,21 +189,17 @@ ES::Engine::Entity CreateVehicle(ES::Engine::Core &core)
         vehicleBuilder.SetWheelMesh(
             CreateCylinderMesh(glm::vec3(wheelRadius, wheelWidth, wheelRadius), 16, glm::vec3(1.0f, 0.0f, 0.0f))
         );
+        // Wheels and bodies are drawn by the InstanceBatcher: one draw per (mesh, shader, material)
         vehicleBuilder.SetWheelCallbackFn([](ES::Engine::Core &c, ES::Engine::Entity &entity) {
-            entity.AddComponent<ES::Plugin::OpenGL::Component::ShaderHandle>(c, "noTextureLightShadow");
-            entity.AddComponent<ES::Plugin::OpenGL::Component::MaterialHandle>(c, "car_wheel");
-            entity.AddComponent<ES::Plugin::OpenGL::Component::ModelHandle>(c, "car_wheel");
+            entity.AddComponent<InstancedModel>(c, "car_wheel", "instanced", "car_wheel");
         });
         vehicleBuilder.SetVehicleCallbackFn([](ES::Engine::Core &c, ES::Engine::Entity &entity) {
-            entity.AddComponent<ES::Plugin::OpenGL::Component::ShaderHandle>(c, "noTextureLightShadow");
-            entity.AddComponent<ES::Plugin::OpenGL::Component::MaterialHandle>(c, "car_body");
-            entity.AddComponent<ES::Plugin::OpenGL::Component::ModelHandle>(c, "car_body");
+            entity.AddComponent<InstancedModel>(c, "car_body", "instanced", "car_body");
         });
         vehicleBuilder.SetOffsetCenterOfMass(glm::vec3(0.0f, -halfVehicleHeight, 0.0f));
-        vehicleBuilder.SetWheelOffset(0, glm::vec3(0.92, 0.667, 1.24));
-        vehicleBuilder.SetWheelOffset(1, glm::vec3(-0.92, 0.667, 1.24));
-        vehicleBuilder.SetWheelOffset(2, glm::vec3(0.92, 0.667, -1.21));
-        vehicleBuilder.SetWheelOffset(3, glm::vec3(-0.92, 0.667, -1.21));
+        for (uint32_t i = 0; i < VEHICLE_WHEEL_OFFSETS.size(); ++i) {
+            vehicleBuilder.SetWheelOffset(i, VEHICLE_WHEEL_OFFSETS[i]);
+        }
         vehicleBuilder.EditWheel(0, [&](JPH::WheelSettingsWV &wheel) {
             wheel.mRadius = wheelRadius;
             wheel.mWidth = wheelWidth;
@@ -238,6 +263,33 @@ ES::Engine::Entity CreateVehicle(ES::Engine::Core &core)
         vehicleEntity = vehicleBuilder.Build();
     }
 
+    // The builder has no tester option, swap it on the constraint it created
+    if (wheelTester.has_value()) {
+        SetWheelCollisionTester(core, vehicleEntity, *wheelTester);
+    }
+
+    return vehicleEntity;
+}
+
+ES::Engine::Entity CreateVehicle(ES::Engine::Core &core)
+{
+    glm::vec3 boundingBoxSize = GetMeshBoundingBoxSize(GetVehicleBodyMesh());
+
+    printf("Vehicle body bounding box size: %.2f x %.2f x %.2f\n",
+           boundingBoxSize.x, boundingBoxSize.y, boundingBoxSize.z);
+
+    std::optional<WheelCollisionTesterSettings> wheelTester;
+    if (const char *value = std::getenv("ES_WHEEL_TESTER")) {
+        if (auto type = ParseWheelCollisionTesterType(value)) {
+            wheelTester = WheelCollisionTesterSettings();
+            wheelTester->type = *type;
+        } else {
+            ES::Utils::Log::Warn(fmt::format("ES_WHEEL_TESTER: unknown tester \"{}\"", value));
+        }
+    }
+
+    ES::Engine::Entity vehicleEntity = BuildVehicle(core, glm::vec3(0.0f, 30.0f, 0.0f), wheelTester);
+
     // This system is a class, which is why it is added here instead of being integrated into ESQ
     auto movementSystem = WheeledVehicleKeyboardMovement(vehicleEntity);
     core.RegisterSystem<ES::Engine::Scheduler::FixedTimeUpdate>(movementSystem);
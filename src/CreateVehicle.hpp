@@ -1,5 +1,35 @@
 #pragma once
 
 #include "Core.hpp"
+#include "Engine.hpp"
+#include "physics/WheelCollisionTester.hpp"
 
+#include <glm/glm.hpp>
+
+#include <array>
+#include <optional>
+
+// Wheel attachment points of the demo car, relative to the body
+constexpr std::array<glm::vec3, 4> VEHICLE_WHEEL_OFFSETS = {
+    glm::vec3(0.92f, 0.667f, 1.24f),
+    glm::vec3(-0.92f, 0.667f, 1.24f),
+    glm::vec3(0.92f, 0.667f, -1.21f),
+    glm::vec3(-0.92f, 0.667f, -1.21f),
+};
+
+// Render-only copy of the demo car: body and wheel entities with the "car_body" and
+// "car_wheel" models, but no rigid body or vehicle constraint
+struct VehicleVisual {
+    ES::Engine::Entity body;
+    std::array<ES::Engine::Entity, 4> wheels;
+};
+
+// Builds the demo car at the given position, without any input or camera system.
+// Without wheelTester the car keeps the tester WheeledVehicleBuilder sets up.
+ES::Engine::Entity BuildVehicle(ES::Engine::Core &core, const glm::vec3 &bodyPosition,
+                                const std::optional<WheelCollisionTesterSettings> &wheelTester = std::nullopt);
+
+// Player car, its wheel tester can be picked with ES_WHEEL_TESTER=ray|cast_sphere|cast_cylinder
 ES::Engine::Entity CreateVehicle(ES::Engine::Core &core);
+
+VehicleVisual CreateVehicleVisual(ES::Engine::Core &core);
@@ -18,6 +18,13 @@ void LoadMaterials(ES::Engine::Core &core)
 
 	materialManager.Add("floor"_hs, material);
 
+    // gravel run-off: sandy brown, dull
+    material.Ka = glm::vec3(0.45f, 0.37f, 0.25f);
+    material.Kd = glm::vec3(0.55f, 0.45f, 0.3f);
+    material.Ks = glm::vec3(0.1f, 0.1f, 0.1f);
+    material.Shiness = 8.0f;
+    materialManager.Add("gravel"_hs, material);
+
     // car body: red
     material.Ka = glm::vec3(0.8f, 0.0f, 0.0f);
     material.Kd = glm::vec3(0.8f, 0.0f, 0.0f);
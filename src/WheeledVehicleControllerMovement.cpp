@@ -3,6 +3,7 @@
 #include "WheeledVehicle3D.hpp"
 #include "Logger.hpp"
 #include "JoltPhysics.hpp"
+#include "input/InputService.hpp"
 
 constexpr int JOYSTICK_ID = 0;
 constexpr int PS5_L3_LR_AXIS = 0;
@@ -31,15 +32,15 @@ void WheeledVehicleControllerMovement::operator()(ES::Engine::Core &core) const
     auto &wheeledVehicle = entity.template GetComponents<ES::Plugin::Physics::Component::WheeledVehicle3D>(core);
     auto &rigidBody = entity.template GetComponents<ES::Plugin::Physics::Component::RigidBody3D>(core);
 
-    auto joystickAxes = ES::Plugin::Input::Utils::GetJoystickAxes(JOYSTICK_ID);
-    auto joystickButtons = ES::Plugin::Input::Utils::GetJoystickButtons(JOYSTICK_ID);
+    // Sampled at the start of every tick by the InputService, averaged over the tick
+    auto &input = core.GetResource<InputService>();
 
-    if (joystickAxes.size() < 6)
+    if (input.GetJoystickAxisCount() < 6)
     {
         return;
     }
 
-    if (joystickButtons.size() < 1)
+    if (input.GetJoystickButtonCount() <= PS5_CIRCLE_BUTTON)
     {
         return;
     }
@@ -62,8 +63,8 @@ void WheeledVehicleControllerMovement::operator()(ES::Engine::Core &core) const
 
     // L2 is throttle and R2 is brake
     // Automatic gearbox : if the car speed is very slow, the brake key is used as reverse, like in most games
-    auto throttle = (joystickAxes[PS5_R2_TRIGGER_AXIS] + 1.0f) / 2.0f;
-    auto brakeForce = (joystickAxes[PS5_L2_TRIGGER_AXIS] + 1.0f) / 2.0f;
+    auto throttle = (input.GetJoystickAxis(PS5_R2_TRIGGER_AXIS) + 1.0f) / 2.0f;
+    auto brakeForce = (input.GetJoystickAxis(PS5_L2_TRIGGER_AXIS) + 1.0f) / 2.0f;
     if (shouldReverse)
     {
         throttle -= brakeForce;
@@ -71,18 +72,10 @@ void WheeledVehicleControllerMovement::operator()(ES::Engine::Core &core) const
     }
 
     // L3 is left/right steering
-    auto steering = joystickAxes[PS5_L3_LR_AXIS];
+    auto steering = input.GetJoystickAxis(PS5_L3_LR_AXIS);
 
     // Circle is handbrake
-    auto handbrakeForce = (joystickButtons[PS5_CIRCLE_BUTTON] + 1.0f) / 2.0f;
-    if (handbrakeForce > 0.51f)
-    {
-        handbrakeForce = 1.0f;
-    }
-    else
-    {
-        handbrakeForce = 0.0f;
-    }
+    auto handbrakeForce = input.GetJoystickButton(PS5_CIRCLE_BUTTON);
 
     wheeledVehicle.SetDriverInput(throttle, steering, brakeForce, handbrakeForce);
 
@@ -3,6 +3,7 @@
 #include "WheeledVehicle3D.hpp"
 #include "Logger.hpp"
 #include "JoltPhysics.hpp"
+#include "input/InputService.hpp"
 
 void WheeledVehicleKeyboardMovement::operator()(ES::Engine::Core &core) const
 {
@@ -15,12 +16,14 @@ void WheeledVehicleKeyboardMovement::operator()(ES::Engine::Core &core) const
 
     auto &wheeledVehicle = entity.template GetComponents<ES::Plugin::Physics::Component::WheeledVehicle3D>(core);
 
-    auto forwardForce = ES::Plugin::Input::Utils::IsKeyPressed(forwardKey) ? 1.0f : 0.0f;
-    auto reverseForce = ES::Plugin::Input::Utils::IsKeyPressed(reverseKey) ? -1.0f : 0.0f;
-    auto leftForce = ES::Plugin::Input::Utils::IsKeyPressed(leftKey) ? -1.0f : 0.0f;
-    auto rightForce = ES::Plugin::Input::Utils::IsKeyPressed(rightKey) ? 1.0f : 0.0f;
-    auto brakeForce = ES::Plugin::Input::Utils::IsKeyPressed(brakeKey) ? 1.0f : 0.0f;
-    auto handbrakeForce = ES::Plugin::Input::Utils::IsKeyPressed(handbrakeKey) ? 1.0f : 0.0f;
+    // Fraction of the tick each key was held, taps count as held for InputService::MIN_PRESS_SECONDS
+    auto &input = core.GetResource<InputService>();
+    auto forwardForce = input.GetKey(forwardKey);
+    auto reverseForce = -input.GetKey(reverseKey);
+    auto leftForce = -input.GetKey(leftKey);
+    auto rightForce = input.GetKey(rightKey);
+    auto brakeForce = input.GetKey(brakeKey);
+    auto handbrakeForce = input.GetKey(handbrakeKey);
 
     auto throttle = forwardForce + reverseForce;
     auto steering = leftForce + rightForce;
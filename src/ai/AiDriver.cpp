@@ -0,0 +1,227 @@
+#include "AiDriver.hpp"
+
+#include "CreateVehicle.hpp"
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "WheeledVehicle3D.hpp"
+#include "physics/JoltGlm.hpp"
+#include "memory/LinearArena.hpp"
+#include "physics/VehicleSimulationLod.hpp"
+#include "task/TaskScheduler.hpp"
+
+#include <Jolt/Core/JobSystem.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+// Ray origin relative to the body: in front of the bumper, above the ground
+constexpr glm::vec3 AI_RAY_ORIGIN(0.0f, 0.5f, 2.5f);
+// Lateral shift towards the freer side when something blocks the line ahead
+constexpr float AI_AVOID_OFFSET = 2.0f;
+constexpr float AI_SPEED_INTEGRAL_LIMIT = 10.0f;
+
+void AiDriverSystem::Drive(const Input &input, const PhysicsQueryService &queries, Output &output,
+                           float deltaTime) const
+{
+    AiDriver &driver = *input.driver;
+    const glm::vec3 forward = input.rotation * glm::vec3(0.0f, 0.0f, 1.0f);
+    const float speed = glm::dot(input.velocity, forward);
+    driver.lineIndex = line.FindClosest(input.position, driver.lineIndex);
+
+    // Free distance ahead, from the rays cast on the previous AI tick. Ray 0 is the
+    // leftmost one, the last is the rightmost.
+    float freeDistance = settings.rayLength;
+    float leftFree = settings.rayLength;
+    float rightFree = settings.rayLength;
+    if (driver.hasRays && queries.IsReady(driver.rays[0]))
+    {
+        const auto &fraction = queries.GetResults().fraction;
+        for (uint32_t i = 0; i < AI_RAY_COUNT; ++i)
+        {
+            const float distance = fraction[driver.rays[i].index] * settings.rayLength;
+            if (i == 0)
+                leftFree = distance;
+            else if (i == AI_RAY_COUNT - 1)
+                rightFree = distance;
+            else
+                freeDistance = std::min(freeDistance, distance);
+        }
+    }
+    float avoid = 0.0f;
+    if (freeDistance < settings.rayLength)
+        avoid = leftFree >= rightFree ? AI_AVOID_OFFSET : -AI_AVOID_OFFSET;
+
+    // Pure pursuit towards a point ahead on the line, shifted to the car's lane
+    const float lookAhead = settings.lookAheadBase + std::max(0.0f, speed) * settings.lookAheadTime;
+    const uint32_t targetIndex = line.Advance(driver.lineIndex, lookAhead);
+    const glm::vec3 &tangent = line.GetTangent(targetIndex);
+    const glm::vec3 left(tangent.z, 0.0f, -tangent.x);
+    const glm::vec3 target = line.GetPosition(targetIndex) + left * (driver.laneOffset + avoid);
+
+    glm::vec3 local = glm::inverse(input.rotation) * (target - input.position);
+    local.y = 0.0f;
+    const float distance = std::max(glm::length(local), 0.1f);
+    // Forward is +Z and right is -X in the car frame
+    const float alpha = std::atan2(-local.x, local.z);
+    const float steerAngle = std::atan(2.0f * settings.wheelBase * std::sin(alpha) / distance);
+    output.right = std::clamp(steerAngle / settings.maxSteerAngle, -1.0f, 1.0f);
+
+    // Speed profile a little ahead of the car, capped to stop short of obstacles
+    float targetSpeed = line.GetTargetSpeed(line.Advance(driver.lineIndex, speed * 0.5f));
+    if (freeDistance < settings.rayLength)
+    {
+        const float clearance = std::max(0.0f, freeDistance - settings.followDistance);
+        targetSpeed = std::min(targetSpeed, std::sqrt(2.0f * settings.obstacleDeceleration * clearance));
+    }
+
+    const float error = targetSpeed - speed;
+    driver.speedIntegral =
+        std::clamp(driver.speedIntegral + error * deltaTime, -AI_SPEED_INTEGRAL_LIMIT, AI_SPEED_INTEGRAL_LIMIT);
+    const float derivative = (error - driver.previousSpeedError) / deltaTime;
+    driver.previousSpeedError = error;
+    const float command = settings.speedKp * error + settings.speedKi * driver.speedIntegral +
+                          settings.speedKd * derivative;
+    output.forward = std::clamp(command, 0.0f, 1.0f);
+    output.brake = std::clamp(-command, 0.0f, 1.0f);
+}
+
+void AiDriverSystem::Update(ES::Engine::Core &core)
+{
+    if (line.IsEmpty() || tick++ % settings.tickInterval != 0)
+        return;
+
+    auto &registry = core.GetRegistry();
+    if (settings.parked)
+    {
+        registry.view<AiDriver, ES::Plugin::Physics::Component::WheeledVehicle3D>().each(
+            [](auto &, auto &vehicle) { vehicle.SetDriverInput(0.0f, 0.0f, 1.0f, 1.0f); });
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    auto &physicsManager = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>();
+    auto &queries = core.GetResource<PhysicsQueryService>();
+    const float deltaTime =
+        settings.tickInterval * core.GetScheduler<ES::Engine::Scheduler::FixedTimeUpdate>().GetTickRate();
+
+    // Gather on this thread: the parallel part reads plain data only. The scratch lives
+    // in the tick arena, released by ResetTickArena.
+    auto &arena = core.GetResource<FrameArenas>().tick;
+    const std::size_t driverCount = registry.view<AiDriver>().size();
+    ArenaVector<entt::entity> entities(&arena);
+    ArenaVector<Input> inputs(&arena);
+    entities.reserve(driverCount);
+    inputs.reserve(driverCount);
+    registry
+        .view<AiDriver, ES::Plugin::Physics::Component::WheeledVehicle3D, ES::Plugin::Physics::Component::RigidBody3D>()
+        .each([&entities, &inputs](entt::entity entity, AiDriver &driver, auto &, auto &rigidBody) {
+            if (rigidBody.body == nullptr)
+                return;
+            entities.push_back(entity);
+            inputs.push_back(Input{&driver, ToGlm(rigidBody.body->GetPosition()),
+                                   ToGlm(rigidBody.body->GetRotation()), ToGlm(rigidBody.body->GetLinearVelocity())});
+        });
+    const auto count = static_cast<uint32_t>(inputs.size());
+    ArenaVector<Output> outputs(count, Output(), &arena);
+
+    auto &jobSystem = core.GetResource<TaskScheduler>().GetJobSystem();
+    JPH::JobSystem::Barrier *barrier = jobSystem.CreateBarrier();
+    for (uint32_t first = 0; first < count; first += CHUNK_SIZE)
+    {
+        const uint32_t last = std::min(first + CHUNK_SIZE, count);
+        JPH::JobSystem::JobHandle job =
+            jobSystem.CreateJob("AiDriverChunk", JPH::Color::sOrange,
+                                [this, &inputs, &outputs, &queries, first, last, deltaTime] {
+                for (uint32_t i = first; i < last; ++i)
+                    Drive(inputs[i], queries, outputs[i], deltaTime);
+            });
+        barrier->AddJob(job);
+    }
+    jobSystem.WaitForJobs(barrier);
+    jobSystem.DestroyBarrier(barrier);
+
+    // Apply the inputs and queue next tick's rays, both touch shared state
+    auto &bodyInterface = physicsManager.GetPhysicsSystem().GetBodyInterface();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto &vehicle = registry.get<ES::Plugin::Physics::Component::WheeledVehicle3D>(entities[i]);
+        const JPH::BodyID bodyId = registry.get<ES::Plugin::Physics::Component::RigidBody3D>(entities[i]).body->GetID();
+        vehicle.SetDriverInput(outputs[i].forward, outputs[i].right, outputs[i].brake, 0.0f);
+        if (outputs[i].forward > 0.0f)
+            bodyInterface.ActivateBody(bodyId);
+
+        const Input &input = inputs[i];
+        const glm::vec3 origin = input.position + input.rotation * AI_RAY_ORIGIN;
+        for (uint32_t ray = 0; ray < AI_RAY_COUNT; ++ray)
+        {
+            const float angle = settings.raySpread * (1.0f - 2.0f * ray / (AI_RAY_COUNT - 1));
+            const glm::vec3 direction = input.rotation * glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f)) *
+                                        glm::vec3(0.0f, 0.0f, settings.rayLength);
+            input.driver->rays[ray] = queries.Cast(origin, direction, 0.0f, bodyId);
+        }
+        input.driver->hasRays = true;
+    }
+
+    const float elapsed = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+    stats.drivers = count;
+    stats.microsecondsPerCar = count > 0 ? elapsed / count : 0.0f;
+    if (count > 0 && stats.microsecondsPerCar > settings.budgetMicroseconds && !overBudget)
+    {
+        ES::Utils::Log::Warn(fmt::format("AI update took {:.1f}us per car for {} cars, budget is {:.1f}us",
+                                         stats.microsecondsPerCar, count, settings.budgetMicroseconds));
+    }
+    overBudget = stats.microsecondsPerCar > settings.budgetMicroseconds;
+}
+
+void AiDriverSystem::Spawn(ES::Engine::Core &core, uint32_t count)
+{
+    if (line.IsEmpty() || count == 0)
+        return;
+
+    auto &bodyInterface =
+        core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem().GetBodyInterface();
+    const float spacing = line.GetLength() / count;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t index = line.Advance(0, i * spacing);
+        const glm::vec3 &tangent = line.GetTangent(index);
+        const glm::vec3 left(tangent.z, 0.0f, -tangent.x);
+        // Two lanes, 1.5 m either side of the line
+        const float laneOffset = (i % 2 == 0) ? 1.5f : -1.5f;
+
+        ES::Engine::Entity vehicle = BuildVehicle(
+            core, line.GetPosition(index) + left * laneOffset + glm::vec3(0.0f, 1.0f, 0.0f), settings.wheelTester);
+        const glm::quat heading = glm::angleAxis(std::atan2(tangent.x, tangent.z), glm::vec3(0.0f, 1.0f, 0.0f));
+        const auto &rigidBody = vehicle.GetComponents<ES::Plugin::Physics::Component::RigidBody3D>(core);
+        bodyInterface.SetRotation(rigidBody.body->GetID(), ToJolt(heading), JPH::EActivation::Activate);
+
+        AiDriver driver;
+        driver.laneOffset = laneOffset;
+        driver.lineIndex = index;
+        vehicle.AddComponent<AiDriver>(core, driver);
+        vehicle.AddComponent<SimulationLod>(core);
+    }
+    ES::Utils::Log::Info(fmt::format("Spawned {} AI cars on a {:.0f} m racing line", count, line.GetLength()));
+}
+
+AiDriverSystem CreateAiDriverSystemFromEnvironment()
+{
+    AiDriverSystem::Settings settings;
+    if (const char *value = std::getenv("ES_AI_CARS"))
+        settings.carCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+
+    // About 10 m of line per car, never smaller than the oval that fits the demo floor
+    constexpr float MIN_RADIUS = 15.0f;
+    constexpr float METERS_PER_CAR = 10.0f;
+    const float radius = std::max(MIN_RADIUS, settings.carCount * METERS_PER_CAR / (2.0f * glm::pi<float>() * 0.8f));
+    return AiDriverSystem(RacingLine::CreateOval(radius, radius * 0.6f, 1.0f), settings);
+}
+
+void UpdateAiDrivers(ES::Engine::Core &core)
+{
+    core.GetResource<AiDriverSystem>().Update(core);
+}
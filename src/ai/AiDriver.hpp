@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Core.hpp"
+#include "RacingLine.hpp"
+#include "physics/PhysicsQueryService.hpp"
+#include "physics/WheelCollisionTester.hpp"
+
+#include <entt/entt.hpp>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+// Look-ahead rays cast by each AI car, fanned around its heading
+constexpr uint32_t AI_RAY_COUNT = 5;
+
+// Drives a WheeledVehicle3D along the AiDriverSystem racing line
+struct AiDriver {
+    // Lane offset from the racing line, positive to the left, spreads traffic out
+    float laneOffset = 0.0f;
+    uint32_t lineIndex = RacingLine::NO_SAMPLE;
+    float speedIntegral = 0.0f;
+    float previousSpeedError = 0.0f;
+    std::array<PhysicsQueryService::Ticket, AI_RAY_COUNT> rays = {};
+    bool hasRays = false;
+};
+
+// Updates every AiDriver at its own rate, in parallel chunks on the TaskScheduler.
+// Steering is pure pursuit on a look-ahead point of the line, throttle and brake come
+// from a PID on the line's speed profile, capped by the free distance the rays report.
+class AiDriverSystem {
+  public:
+    struct Settings {
+        // Fixed ticks between two AI updates: 4 at 240 Hz is 60 Hz
+        uint32_t tickInterval = 4;
+        // Look-ahead distance is lookAheadBase + speed * lookAheadTime
+        float lookAheadBase = 4.0f;
+        float lookAheadTime = 0.4f;
+        float speedKp = 0.4f;
+        float speedKi = 0.05f;
+        float speedKd = 0.02f;
+        float rayLength = 25.0f;
+        float raySpread = 0.35f;
+        // Distance kept to whatever the rays hit, and deceleration used to keep it
+        float followDistance = 6.0f;
+        float obstacleDeceleration = 8.0f;
+        // Vehicle geometry used by pure pursuit
+        float wheelBase = 2.45f;
+        float maxSteerAngle = 0.52f;
+        // Average cost per car per AI tick above which a warning is logged
+        float budgetMicroseconds = 20.0f;
+        // AI cars the game scene spawns
+        uint32_t carCount = 0;
+        // Brakes on and no rays: the cars settle where they spawned, for the render benchmark
+        bool parked = false;
+        // AI cars stay on the flat track, where a single ray per wheel is enough
+        WheelCollisionTesterSettings wheelTester;
+    };
+
+    struct Stats {
+        uint32_t drivers = 0;
+        float microsecondsPerCar = 0.0f;
+    };
+
+    // Cars updated by one job
+    static constexpr uint32_t CHUNK_SIZE = 32;
+
+    AiDriverSystem() = default;
+    AiDriverSystem(RacingLine line, const Settings &settings) : line(std::move(line)), settings(settings) {}
+
+    AiDriverSystem(AiDriverSystem &&) = default;
+    AiDriverSystem &operator=(AiDriverSystem &&) = default;
+
+    void Update(ES::Engine::Core &core);
+
+    // Creates count AI cars spread along the line, alternating lanes
+    void Spawn(ES::Engine::Core &core, uint32_t count);
+
+    inline void SetLine(RacingLine newLine) { line = std::move(newLine); }
+    inline const RacingLine &GetLine() const { return line; }
+    inline Settings &GetSettings() { return settings; }
+    inline const Stats &GetStats() const { return stats; }
+
+  private:
+    // Snapshot of one car taken before the parallel part
+    struct Input {
+        AiDriver *driver;
+        glm::vec3 position;
+        glm::quat rotation;
+        glm::vec3 velocity;
+    };
+
+    struct Output {
+        float forward = 0.0f;
+        float right = 0.0f;
+        float brake = 0.0f;
+    };
+
+    void Drive(const Input &input, const PhysicsQueryService &queries, Output &output, float deltaTime) const;
+
+    RacingLine line;
+    Settings settings;
+    Stats stats;
+    uint32_t tick = 0;
+    bool overBudget = false;
+};
+
+// Reads the number of AI cars from ES_AI_CARS (0 when unset) and lays out an oval
+// racing line long enough to fit them
+AiDriverSystem CreateAiDriverSystemFromEnvironment();
+
+void UpdateAiDrivers(ES::Engine::Core &core);
@@ -0,0 +1,167 @@
+#include "RacingLine.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Spline evaluations per control point segment used to measure arc length
+constexpr uint32_t ARC_LENGTH_STEPS = 64;
+// Samples the hinted search may walk before falling back to a full scan
+constexpr uint32_t MAX_HINT_STEPS = 64;
+
+static glm::vec3 CatmullRom(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, float t)
+{
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (-p0 + p2) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                   (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+RacingLine::RacingLine(const std::vector<glm::vec3> &controlPoints, const RacingLineSettings &settings)
+    : spacing(settings.sampleSpacing)
+{
+    const auto count = static_cast<uint32_t>(controlPoints.size());
+    if (count < 3 || spacing <= 0.0f)
+        return;
+
+    // Dense polyline along the closed spline, then resampled at equal arc length
+    std::vector<glm::vec3> dense;
+    dense.reserve(count * ARC_LENGTH_STEPS + 1);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const glm::vec3 &p0 = controlPoints[(i + count - 1) % count];
+        const glm::vec3 &p1 = controlPoints[i];
+        const glm::vec3 &p2 = controlPoints[(i + 1) % count];
+        const glm::vec3 &p3 = controlPoints[(i + 2) % count];
+        for (uint32_t step = 0; step < ARC_LENGTH_STEPS; ++step)
+            dense.push_back(CatmullRom(p0, p1, p2, p3, static_cast<float>(step) / ARC_LENGTH_STEPS));
+    }
+    dense.push_back(dense.front());
+
+    float total = 0.0f;
+    for (std::size_t i = 1; i < dense.size(); ++i)
+        total += glm::distance(dense[i - 1], dense[i]);
+    const auto sampleCount = std::max<uint32_t>(3, static_cast<uint32_t>(total / spacing));
+    // Stretch the spacing slightly so the loop closes on a whole number of samples
+    spacing = total / sampleCount;
+
+    positions.reserve(sampleCount);
+    float travelled = 0.0f;
+    std::size_t segment = 1;
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        const float target = i * spacing;
+        while (segment < dense.size() - 1 && travelled + glm::distance(dense[segment - 1], dense[segment]) < target)
+        {
+            travelled += glm::distance(dense[segment - 1], dense[segment]);
+            segment++;
+        }
+        const float length = glm::distance(dense[segment - 1], dense[segment]);
+        const float t = length > 0.0f ? (target - travelled) / length : 0.0f;
+        positions.push_back(glm::mix(dense[segment - 1], dense[segment], std::clamp(t, 0.0f, 1.0f)));
+        extent = std::max({extent, std::abs(positions.back().x), std::abs(positions.back().z)});
+    }
+
+    tangents.resize(sampleCount);
+    curvature.resize(sampleCount);
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        const glm::vec3 &previous = positions[(i + sampleCount - 1) % sampleCount];
+        const glm::vec3 &next = positions[(i + 1) % sampleCount];
+        tangents[i] = glm::normalize(next - previous);
+    }
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        // Heading change per meter, measured in the ground plane
+        const glm::vec3 &a = tangents[(i + sampleCount - 1) % sampleCount];
+        const glm::vec3 &b = tangents[(i + 1) % sampleCount];
+        const float turn = std::atan2(a.z * b.x - a.x * b.z, a.x * b.x + a.z * b.z);
+        curvature[i] = turn / (2.0f * spacing);
+    }
+    BuildSpeedProfile(settings);
+}
+
+void RacingLine::BuildSpeedProfile(const RacingLineSettings &settings)
+{
+    const auto count = static_cast<uint32_t>(positions.size());
+    targetSpeed.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const float k = std::abs(curvature[i]);
+        targetSpeed[i] =
+            k > 1e-4f ? std::min(settings.maxSpeed, std::sqrt(settings.maxLateralAcceleration / k)) : settings.maxSpeed;
+    }
+
+    // Braking then acceleration limits, each swept twice so they carry across the start line
+    for (uint32_t pass = 0; pass < 2 * count; ++pass)
+    {
+        uint32_t i = count - 1 - pass % count;
+        float next = targetSpeed[(i + 1) % count];
+        targetSpeed[i] = std::min(targetSpeed[i], std::sqrt(next * next + 2.0f * settings.maxDeceleration * spacing));
+    }
+    for (uint32_t pass = 0; pass < 2 * count; ++pass)
+    {
+        uint32_t i = pass % count;
+        float previous = targetSpeed[(i + count - 1) % count];
+        targetSpeed[i] =
+            std::min(targetSpeed[i], std::sqrt(previous * previous + 2.0f * settings.maxAcceleration * spacing));
+    }
+}
+
+RacingLine RacingLine::CreateOval(float radiusX, float radiusZ, float height, const RacingLineSettings &settings)
+{
+    constexpr uint32_t CONTROL_POINTS = 16;
+    std::vector<glm::vec3> points;
+    points.reserve(CONTROL_POINTS);
+    for (uint32_t i = 0; i < CONTROL_POINTS; ++i)
+    {
+        float angle = 2.0f * glm::pi<float>() * i / CONTROL_POINTS;
+        points.emplace_back(radiusX * std::cos(angle), height, radiusZ * std::sin(angle));
+    }
+    return RacingLine(points, settings);
+}
+
+uint32_t RacingLine::FindClosest(const glm::vec3 &position, uint32_t hint) const
+{
+    const auto count = static_cast<uint32_t>(positions.size());
+    auto distance2 = [&](uint32_t i) {
+        glm::vec3 d = positions[i] - position;
+        return glm::dot(d, d);
+    };
+
+    if (hint < count)
+    {
+        // Walk downhill from the hint in whichever direction gets closer
+        uint32_t best = hint;
+        float bestDistance = distance2(best);
+        for (int32_t direction : {1, -1})
+        {
+            for (uint32_t step = 0; step < MAX_HINT_STEPS; ++step)
+            {
+                uint32_t next = (best + count + direction) % count;
+                float nextDistance = distance2(next);
+                if (nextDistance >= bestDistance)
+                    break;
+                best = next;
+                bestDistance = nextDistance;
+            }
+        }
+        // A car far from where the hint left it (respawned, rewound) gets a full scan
+        if (glm::sqrt(bestDistance) < MAX_HINT_STEPS * spacing)
+            return best;
+    }
+
+    uint32_t best = 0;
+    float bestDistance = distance2(0);
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        float d = distance2(i);
+        if (d < bestDistance)
+        {
+            best = i;
+            bestDistance = d;
+        }
+    }
+    return best;
+}
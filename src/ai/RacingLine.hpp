@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct RacingLineSettings {
+    // Distance between two samples, in meters
+    float sampleSpacing = 1.0f;
+    float maxSpeed = 40.0f;
+    // Limits the speed profile is built from, in m/s^2
+    float maxLateralAcceleration = 9.0f;
+    float maxAcceleration = 6.0f;
+    float maxDeceleration = 10.0f;
+};
+
+// Closed racing line: a Catmull-Rom spline through the control points, resampled at
+// a fixed spacing with the curvature and target speed of every sample precomputed,
+// so drivers only ever read arrays at run time.
+class RacingLine {
+  public:
+    static constexpr uint32_t NO_SAMPLE = UINT32_MAX;
+
+    RacingLine() = default;
+    explicit RacingLine(const std::vector<glm::vec3> &controlPoints,
+                        const RacingLineSettings &settings = RacingLineSettings());
+
+    // Ellipse centered on the origin, in the XZ plane
+    static RacingLine CreateOval(float radiusX, float radiusZ, float height,
+                                 const RacingLineSettings &settings = RacingLineSettings());
+
+    // Closest sample to position. With a hint the search only walks from there, which
+    // is constant time for a driver that moves a few samples between two calls.
+    uint32_t FindClosest(const glm::vec3 &position, uint32_t hint = NO_SAMPLE) const;
+
+    // Sample reached after moving distance meters forward along the line
+    inline uint32_t Advance(uint32_t index, float distance) const
+    {
+        auto steps = static_cast<uint32_t>(std::max(0.0f, distance) / spacing);
+        return (index + steps) % static_cast<uint32_t>(positions.size());
+    }
+
+    inline const glm::vec3 &GetPosition(uint32_t index) const { return positions[index]; }
+    inline const glm::vec3 &GetTangent(uint32_t index) const { return tangents[index]; }
+    // Signed, positive when the line turns left
+    inline float GetCurvature(uint32_t index) const { return curvature[index]; }
+    inline float GetTargetSpeed(uint32_t index) const { return targetSpeed[index]; }
+    inline uint32_t GetSampleCount() const { return static_cast<uint32_t>(positions.size()); }
+    inline float GetLength() const { return spacing * positions.size(); }
+    inline bool IsEmpty() const { return positions.empty(); }
+    // Largest absolute X or Z coordinate of the line
+    inline float GetExtent() const { return extent; }
+
+  private:
+    void BuildSpeedProfile(const RacingLineSettings &settings);
+
+    float spacing = 1.0f;
+    float extent = 0.0f;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> tangents;
+    std::vector<float> curvature;
+    std::vector<float> targetSpeed;
+};
@@ -0,0 +1,132 @@
+#include "EngineAudio.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "OpenGL.hpp"
+#include "WheeledVehicle3D.hpp"
+#include "physics/JoltGlm.hpp"
+
+#include <Jolt/Physics/Vehicle/VehicleConstraint.h>
+#include <Jolt/Physics/Vehicle/WheeledVehicleController.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string_view>
+
+EngineAudio::EngineAudio(const Settings &settings_) : settings(settings_)
+{
+    if (settings.backend == Backend::NONE)
+        return;
+
+    auto newMixer = std::make_unique<EngineMixer>(settings.sampleRate, settings.masterGain);
+    const auto backend = settings.backend == Backend::NULL_DEVICE ? EngineMixer::Backend::NULL_DEVICE
+                                                                  : EngineMixer::Backend::DEVICE;
+    if (!newMixer->Start(backend))
+    {
+        ES::Utils::Log::Warn("EngineAudio: no playback device, engine sound disabled");
+        return;
+    }
+    ES::Utils::Log::Info(
+        fmt::format("EngineAudio: playing on {} at {} Hz", newMixer->GetDeviceName(), settings.sampleRate));
+    mixer = std::move(newMixer);
+}
+
+EngineAudio::~EngineAudio() = default;
+EngineAudio::EngineAudio(EngineAudio &&) noexcept = default;
+EngineAudio &EngineAudio::operator=(EngineAudio &&) noexcept = default;
+
+void EngineAudio::Update(ES::Engine::Core &core)
+{
+    if (mixer == nullptr)
+        return;
+
+    auto &camera = core.GetResource<ES::Plugin::OpenGL::Resource::Camera>();
+    const glm::vec3 listener = camera.viewer.getViewPoint();
+    const glm::vec3 right(camera.view[0][0], camera.view[1][0], camera.view[2][0]);
+
+    candidates.clear();
+    core.GetRegistry()
+        .view<ES::Plugin::Physics::Component::WheeledVehicle3D, ES::Plugin::Physics::Component::RigidBody3D>()
+        .each([&](entt::entity entity, auto &vehicle, auto &rigidBody) {
+            if (vehicle.vehicleConstraint == nullptr || rigidBody.body == nullptr)
+                return;
+            const glm::vec3 offset = ToGlm(rigidBody.body->GetPosition()) - listener;
+            const float distance = glm::length(offset);
+            if (distance > settings.maxDistance)
+                return;
+
+            const auto *controller =
+                static_cast<const JPH::WheeledVehicleController *>(vehicle.vehicleConstraint->GetController());
+            Voice voice;
+            voice.id = entt::to_integral(entity) + 1;
+            voice.rpm = controller->GetEngine().GetCurrentRPM();
+            voice.load = std::abs(controller->GetForwardInput());
+            voice.gear = controller->GetTransmission().GetCurrentGear();
+            voice.gain = settings.halfGainDistance / (settings.halfGainDistance + distance);
+            voice.pan = distance > 0.1f ? std::clamp(glm::dot(offset / distance, right), -1.0f, 1.0f) : 0.0f;
+            candidates.push_back(voice);
+        });
+
+    // Voice limit: the loudest cars win
+    if (candidates.size() > EngineMixer::MAX_VOICES)
+    {
+        std::nth_element(candidates.begin(), candidates.begin() + EngineMixer::MAX_VOICES, candidates.end(),
+                         [](const Voice &a, const Voice &b) { return a.gain > b.gain; });
+        candidates.resize(EngineMixer::MAX_VOICES);
+    }
+
+    // Cars keep their slot, the others take the slots left free
+    EngineMixer::Frame &frame = mixer->GetWriteFrame();
+    std::array<bool, EngineMixer::MAX_VOICES> placed = {};
+    for (uint32_t slot = 0; slot < EngineMixer::MAX_VOICES; ++slot)
+    {
+        frame.voices[slot] = Voice();
+        for (std::size_t i = 0; i < candidates.size(); ++i)
+        {
+            if (!placed[i] && owners[slot] != 0 && candidates[i].id == owners[slot])
+            {
+                frame.voices[slot] = candidates[i];
+                placed[i] = true;
+                break;
+            }
+        }
+        if (frame.voices[slot].id == 0)
+            owners[slot] = 0;
+    }
+    for (std::size_t i = 0; i < candidates.size(); ++i)
+    {
+        if (placed[i])
+            continue;
+        for (uint32_t slot = 0; slot < EngineMixer::MAX_VOICES; ++slot)
+        {
+            if (owners[slot] == 0)
+            {
+                owners[slot] = candidates[i].id;
+                frame.voices[slot] = candidates[i];
+                break;
+            }
+        }
+    }
+    activeVoices = static_cast<uint32_t>(candidates.size());
+    mixer->Publish();
+}
+
+EngineAudio CreateEngineAudioFromEnvironment()
+{
+    EngineAudio::Settings settings;
+    if (const char *value = std::getenv("ES_AUDIO"))
+    {
+        const std::string_view mode(value);
+        if (mode == "off")
+            settings.backend = EngineAudio::Backend::NONE;
+        else if (mode == "null")
+            settings.backend = EngineAudio::Backend::NULL_DEVICE;
+    }
+    return EngineAudio(settings);
+}
+
+void UpdateEngineAudio(ES::Engine::Core &core)
+{
+    core.GetResource<EngineAudio>().Update(core);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Engine.hpp"
+#include "EngineMixer.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Engine sound of every car, synthesized on the miniaudio callback thread.
+//
+// Each tick, the cars closest to the camera get a voice: their RPM, throttle, gear,
+// gain and pan are published to the EngineMixer, which plays them.
+class EngineAudio
+{
+  public:
+    enum class Backend {
+        NONE,
+        DEVICE,
+        // miniaudio's null backend: the callback runs on a timer, nothing is played
+        NULL_DEVICE,
+    };
+
+    struct Settings {
+        Backend backend = Backend::DEVICE;
+        uint32_t sampleRate = 48000;
+        // Cars further than this from the camera get no voice
+        float maxDistance = 120.0f;
+        // Distance at which a car plays at half gain
+        float halfGainDistance = 15.0f;
+        float masterGain = 0.5f;
+    };
+
+    using Voice = EngineMixer::Voice;
+
+    EngineAudio() = default;
+    explicit EngineAudio(const Settings &settings);
+    ~EngineAudio();
+
+    EngineAudio(EngineAudio &&) noexcept;
+    EngineAudio &operator=(EngineAudio &&) noexcept;
+
+    // Picks the voices and publishes them to the callback
+    void Update(ES::Engine::Core &core);
+
+    inline bool IsRunning() const { return mixer != nullptr; }
+    // Frames the callback has produced, for checking it runs on the null backend
+    inline uint64_t GetFramesRendered() const { return mixer != nullptr ? mixer->GetFramesRendered() : 0; }
+    inline uint32_t GetActiveVoices() const { return activeVoices; }
+
+  private:
+    std::unique_ptr<EngineMixer> mixer;
+    Settings settings;
+    std::vector<Voice> candidates;
+    // Voice id each slot belongs to, 0 when free. Kept stable so a car keeps its slot.
+    std::array<uint32_t, EngineMixer::MAX_VOICES> owners = {};
+    uint32_t activeVoices = 0;
+};
+
+// Reads ES_AUDIO: "off" disables audio, "null" runs on miniaudio's null backend,
+// anything else (or unset) plays on the default device
+EngineAudio CreateEngineAudioFromEnvironment();
+
+void UpdateEngineAudio(ES::Engine::Core &core);
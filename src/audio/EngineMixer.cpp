@@ -0,0 +1,255 @@
+#include "EngineMixer.hpp"
+
+// The implementation is compiled by the engine's sound plugin
+#include <miniaudio.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Loops are recorded for a flat-six: three firings per crank revolution
+constexpr float CYLINDERS = 6.0f;
+constexpr float BANK_MIN_RPM = 800.0f;
+constexpr float BANK_MAX_RPM = 8000.0f;
+// Each loop holds whole engine cycles and lasts about this long
+constexpr float BANK_SECONDS = 0.2f;
+// Parameter smoothing time, long enough to hide the tick rate, short enough to follow shifts
+constexpr float SMOOTHING_SECONDS = 0.02f;
+// Gain dip while the clutch is out during a shift
+constexpr float SHIFT_SECONDS = 0.08f;
+// Fade out of a car whose slot was given to another one
+constexpr float RELEASE_SECONDS = 0.01f;
+
+struct EngineMixer::Device {
+    ma_context context;
+    ma_device device;
+};
+
+EngineMixer::Bank EngineMixer::GenerateBank(float rpm, bool onLoad, uint32_t sampleRate, uint32_t seed)
+{
+    // A whole number of two-revolution cycles, the bank RPM is adjusted so the loop closes
+    const float cycleSamples = sampleRate * 120.0f / rpm;
+    const auto cycles = std::max(1u, static_cast<uint32_t>(std::lround(BANK_SECONDS * sampleRate / cycleSamples)));
+    const auto length = static_cast<uint32_t>(std::lround(cycles * cycleSamples));
+
+    Bank bank;
+    bank.rpm = 120.0f * cycles * sampleRate / length;
+    bank.samples.assign(length, 0.0f);
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // Each firing is a decaying resonance, cylinders differ a little in strength
+    const auto firings = static_cast<uint32_t>(cycles * CYLINDERS);
+    const float interval = static_cast<float>(length) / firings;
+    const float resonance = 90.0f + bank.rpm * 0.02f;
+    const float decay = interval * (onLoad ? 0.45f : 0.3f);
+    const float strength = onLoad ? 1.0f : 0.45f;
+    for (uint32_t firing = 0; firing < firings; ++firing)
+    {
+        const float amplitude = strength * (0.85f + 0.3f * unit(random));
+        const auto start = static_cast<uint32_t>(firing * interval);
+        const auto span = static_cast<uint32_t>(2.0f * interval);
+        for (uint32_t n = 0; n < span; ++n)
+        {
+            const float t = static_cast<float>(n);
+            bank.samples[(start + n) % length] += amplitude * std::exp(-t / decay) *
+                                                  std::sin(2.0f * glm::pi<float>() * resonance * t / sampleRate);
+        }
+    }
+
+    // Intake and exhaust hiss, low-passed
+    const float noise = onLoad ? 0.08f : 0.03f;
+    float filtered = 0.0f;
+    for (float &sample : bank.samples)
+    {
+        filtered += 0.2f * ((unit(random) * 2.0f - 1.0f) - filtered);
+        sample += noise * filtered;
+    }
+
+    float peak = 0.0f;
+    for (float sample : bank.samples)
+        peak = std::max(peak, std::abs(sample));
+    if (peak > 0.0f)
+    {
+        for (float &sample : bank.samples)
+            sample *= 0.8f / peak;
+    }
+    return bank;
+}
+
+float EngineMixer::ReadBank(const Bank &bank, double &position, float rpm)
+{
+    const auto length = static_cast<uint32_t>(bank.samples.size());
+    const auto index = static_cast<uint32_t>(position);
+    const auto fraction = static_cast<float>(position - index);
+    const float a = bank.samples[index];
+    const float b = bank.samples[(index + 1) % length];
+    position += rpm / bank.rpm;
+    if (position >= length)
+        position = std::fmod(position, static_cast<double>(length));
+    return a + (b - a) * fraction;
+}
+
+EngineMixer::EngineMixer(uint32_t sampleRate_, float masterGain_) : sampleRate(sampleRate_), masterGain(masterGain_)
+{
+    for (uint32_t load = 0; load < 2; ++load)
+    {
+        for (uint32_t i = 0; i < BANK_COUNT; ++i)
+        {
+            const float rpm =
+                BANK_MIN_RPM * std::pow(BANK_MAX_RPM / BANK_MIN_RPM, static_cast<float>(i) / (BANK_COUNT - 1));
+            banks[load][i] = GenerateBank(rpm, load == 1, sampleRate, load * BANK_COUNT + i);
+        }
+    }
+}
+
+EngineMixer::~EngineMixer()
+{
+    Stop();
+}
+
+// Audio thread: everything it touches was built before the device started
+static void DataCallback(ma_device *device, void *output, const void *, ma_uint32 frameCount)
+{
+    static_cast<EngineMixer *>(device->pUserData)->Mix(static_cast<float *>(output), frameCount);
+}
+
+bool EngineMixer::Start(Backend backend)
+{
+    if (device != nullptr)
+        return true;
+
+    auto newDevice = std::make_unique<Device>();
+    const ma_backend nullBackend = ma_backend_null;
+    const bool useNull = backend == Backend::NULL_DEVICE;
+    if (ma_context_init(useNull ? &nullBackend : nullptr, useNull ? 1 : 0, nullptr, &newDevice->context) !=
+        MA_SUCCESS)
+        return false;
+
+    ma_device_config config = ma_device_config_init(ma_device_type_playback);
+    config.playback.format = ma_format_f32;
+    config.playback.channels = 2;
+    config.sampleRate = sampleRate;
+    config.dataCallback = DataCallback;
+    config.pUserData = this;
+    if (ma_device_init(&newDevice->context, &config, &newDevice->device) != MA_SUCCESS)
+    {
+        ma_context_uninit(&newDevice->context);
+        return false;
+    }
+    if (ma_device_start(&newDevice->device) != MA_SUCCESS)
+    {
+        ma_device_uninit(&newDevice->device);
+        ma_context_uninit(&newDevice->context);
+        return false;
+    }
+    device = std::move(newDevice);
+    return true;
+}
+
+void EngineMixer::Stop()
+{
+    if (device == nullptr)
+        return;
+    ma_device_uninit(&device->device);
+    ma_context_uninit(&device->context);
+    device.reset();
+}
+
+const char *EngineMixer::GetDeviceName() const
+{
+    return device != nullptr ? device->device.playback.name : "";
+}
+
+void EngineMixer::Mix(float *output, uint32_t frameCount)
+{
+    const auto rate = static_cast<float>(sampleRate);
+    const float smoothing = 1.0f - std::exp(-1.0f / (SMOOTHING_SECONDS * rate));
+    const float release = 1.0f - std::exp(-1.0f / (RELEASE_SECONDS * rate));
+    const float shiftRate = 1.0f / (SHIFT_SECONDS * rate);
+
+    frames.Update();
+    const Frame &frame = frames.GetReadBuffer();
+    const auto &lowBanks = banks[0];
+
+    for (uint32_t v = 0; v < MAX_VOICES; ++v)
+    {
+        const Voice *target = &frame.voices[v];
+        Playback &voice = playback[v];
+        Voice fadeOut;
+        if (voice.id != target->id)
+        {
+            if (voice.id != 0 && voice.gain >= SILENT_GAIN)
+            {
+                // Another car took the slot: cutting the previous one would click, it
+                // fades out first and the new car starts on a later buffer
+                fadeOut.id = voice.id;
+                fadeOut.rpm = voice.rpm;
+                fadeOut.load = voice.load;
+                fadeOut.gear = voice.gear;
+                fadeOut.pan = voice.pan;
+                target = &fadeOut;
+            }
+            else
+            {
+                // New car in this slot: start from its parameters, fade in from silence
+                voice = Playback();
+                voice.id = target->id;
+                voice.rpm = target->rpm;
+                voice.load = target->load;
+                voice.pan = target->pan;
+                voice.gear = target->gear;
+            }
+        }
+        if (target->gear != voice.gear)
+        {
+            voice.gear = target->gear;
+            voice.shift = 0.0f;
+        }
+        if (target->gain <= 0.0f && voice.gain < SILENT_GAIN)
+            continue;
+        const float gainSmoothing = target == &fadeOut ? release : smoothing;
+
+        for (uint32_t i = 0; i < frameCount; ++i)
+        {
+            voice.rpm += smoothing * (target->rpm - voice.rpm);
+            voice.load += smoothing * (target->load - voice.load);
+            voice.gain += gainSmoothing * (target->gain - voice.gain);
+            voice.pan += smoothing * (target->pan - voice.pan);
+            voice.shift = std::min(1.0f, voice.shift + shiftRate);
+
+            // The two banks around the current RPM, on both load levels
+            const float rpm = std::clamp(voice.rpm, lowBanks.front().rpm, lowBanks.back().rpm);
+            uint32_t bank = 0;
+            while (bank + 2 < BANK_COUNT && lowBanks[bank + 1].rpm <= rpm)
+                bank++;
+            const float t = std::clamp((rpm - lowBanks[bank].rpm) / (lowBanks[bank + 1].rpm - lowBanks[bank].rpm),
+                                       0.0f, 1.0f);
+
+            float sample = 0.0f;
+            for (uint32_t load = 0; load < 2; ++load)
+            {
+                const float loadWeight = load == 0 ? 1.0f - voice.load : voice.load;
+                if (loadWeight < 1e-3f)
+                    continue;
+                auto &positions = voice.positions[load];
+                sample += loadWeight * (1.0f - t) * ReadBank(banks[load][bank], positions[bank], rpm);
+                sample += loadWeight * t * ReadBank(banks[load][bank + 1], positions[bank + 1], rpm);
+            }
+
+            // Equal power pan
+            const float gain = voice.gain * (0.4f + 0.6f * voice.shift) * masterGain;
+            const float angle = (voice.pan + 1.0f) * glm::pi<float>() * 0.25f;
+            output[2 * i] += sample * gain * std::cos(angle);
+            output[2 * i + 1] += sample * gain * std::sin(angle);
+        }
+    }
+
+    // Soft clip the mix, many cars at once would otherwise wrap around
+    for (uint32_t i = 0; i < frameCount * 2; ++i)
+        output[i] = std::tanh(output[i]);
+    framesRendered.fetch_add(frameCount, std::memory_order_relaxed);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "TripleBuffer.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The audio-thread half of EngineAudio, free of the engine.
+//
+// Plays up to MAX_VOICES engines from a bank of loops recorded at fixed RPMs,
+// pitching the two loops around each voice's RPM and crossfading between them, on
+// throttle and off throttle alike. Voices arrive through a TripleBuffer; Mix, which
+// the miniaudio callback runs, never locks or allocates. The banks are generated
+// once, in the constructor.
+class EngineMixer
+{
+  public:
+    static constexpr uint32_t MAX_VOICES = 8;
+    static constexpr uint32_t BANK_COUNT = 8;
+    // Below this a voice is silent, and a reused slot switches to its new car
+    static constexpr float SILENT_GAIN = 1e-4f;
+
+    enum class Backend {
+        DEVICE,
+        // miniaudio's null backend: the callback runs on a timer, nothing is played
+        NULL_DEVICE,
+    };
+
+    struct Voice {
+        // Entity of the car plus one, 0 for a silent slot. The mixer restarts the
+        // voice when it changes, once the previous car has faded out.
+        uint32_t id = 0;
+        float rpm = 0.0f;
+        // Throttle, 0 is coasting and 1 full load
+        float load = 0.0f;
+        int32_t gear = 0;
+        float gain = 0.0f;
+        // -1 is left, 1 is right
+        float pan = 0.0f;
+    };
+
+    struct Frame {
+        std::array<Voice, MAX_VOICES> voices = {};
+    };
+
+    EngineMixer(uint32_t sampleRate, float masterGain);
+    ~EngineMixer();
+
+    // The callback keeps a pointer to the mixer
+    EngineMixer(const EngineMixer &) = delete;
+    EngineMixer &operator=(const EngineMixer &) = delete;
+
+    // Opens a playback device and starts calling Mix on it, false if there is none
+    bool Start(Backend backend);
+    void Stop();
+    inline bool IsRunning() const { return device != nullptr; }
+    const char *GetDeviceName() const;
+
+    // Writer side, one thread only
+    inline Frame &GetWriteFrame() { return frames.GetWriteBuffer(); }
+    inline void Publish() { frames.Publish(); }
+
+    // Adds frameCount interleaved stereo frames of the latest published voices to
+    // output, then soft clips it. Runs on the device's thread once started: call it
+    // directly only while no device runs.
+    void Mix(float *output, uint32_t frameCount);
+
+    // Frames Mix has produced
+    inline uint64_t GetFramesRendered() const { return framesRendered.load(std::memory_order_relaxed); }
+
+    // miniaudio's context and device, defined in EngineMixer.cpp
+    struct Device;
+
+  private:
+    struct Bank {
+        float rpm = 0.0f;
+        std::vector<float> samples;
+    };
+
+    // What the mixer keeps per voice between two buffers
+    struct Playback {
+        uint32_t id = 0;
+        float rpm = 0.0f;
+        float load = 0.0f;
+        float gain = 0.0f;
+        float pan = 0.0f;
+        int32_t gear = 0;
+        float shift = 1.0f;
+        std::array<std::array<double, BANK_COUNT>, 2> positions = {};
+    };
+
+    static Bank GenerateBank(float rpm, bool onLoad, uint32_t sampleRate, uint32_t seed);
+    static float ReadBank(const Bank &bank, double &position, float rpm);
+
+    uint32_t sampleRate;
+    float masterGain;
+    // Off throttle, then on throttle
+    std::array<std::array<Bank, BANK_COUNT>, 2> banks;
+    TripleBuffer<Frame> frames;
+    std::array<Playback, MAX_VOICES> playback;
+    std::atomic<uint64_t> framesRendered = 0;
+    std::unique_ptr<Device> device;
+};
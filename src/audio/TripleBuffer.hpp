@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single-producer single-consumer handoff of the latest value. The writer fills its
+// own slot and publishes it with one atomic exchange, the reader picks the newest
+// published slot the same way: neither side ever waits for the other, and the
+// reader always gets a complete value.
+template <typename T> class TripleBuffer {
+  public:
+    // Writer side
+    inline T &GetWriteBuffer() { return slots[writeIndex]; }
+    void Publish()
+    {
+        writeIndex = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Reader side: switches to the newest published value if there is one, returns
+    // whether it did
+    bool Update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+            return false;
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    inline const T &GetReadBuffer() const { return slots[readIndex]; }
+
+  private:
+    static constexpr uint32_t INDEX_MASK = 0x3;
+    static constexpr uint32_t FRESH = 0x4;
+
+    std::array<T, 3> slots = {};
+    uint32_t writeIndex = 0;
+    uint32_t readIndex = 1;
+    std::atomic<uint32_t> middle = 2;
+};
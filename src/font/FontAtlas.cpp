@@ -0,0 +1,328 @@
+#include "FontAtlas.hpp"
+
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#define STB_TRUETYPE_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+constexpr uint32_t FIRST_CODEPOINT = 32;
+constexpr uint32_t LAST_CODEPOINT = 126;
+constexpr uint32_t GLYPH_PADDING = 2;
+constexpr uint32_t ATLAS_WIDTH = 512;
+// Spread of the distance field, in pixels at the baked size
+constexpr uint32_t SDF_SPREAD = 6;
+constexpr unsigned char SDF_ON_EDGE = 128;
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this == &other)
+        return *this;
+    Close();
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+#ifdef _WIN32
+    std::swap(fileHandle, other.fileHandle);
+    std::swap(mappingHandle, other.mappingHandle);
+#endif
+    return *this;
+}
+
+bool MappedFile::Open(const std::string &path)
+{
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const uint8_t *>(view);
+    size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *view = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+    data = static_cast<const uint8_t *>(view);
+    size = static_cast<std::size_t>(st.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data == nullptr)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t *>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+static bool IsHeaderValid(const FontAtlasHeader &header, std::size_t fileSize)
+{
+    if (header.magic != FONT_ATLAS_MAGIC || header.version != FONT_ATLAS_VERSION)
+        return false;
+    std::size_t expected = sizeof(FontAtlasHeader) + header.glyphCount * sizeof(FontAtlasGlyph) +
+                           static_cast<std::size_t>(header.width) * header.height;
+    return fileSize == expected;
+}
+
+bool FontAtlas::Load(const std::string &cachePath)
+{
+    if (!file.Open(cachePath))
+        return false;
+    if (file.Size() < sizeof(FontAtlasHeader))
+    {
+        file.Close();
+        return false;
+    }
+    auto candidate = reinterpret_cast<const FontAtlasHeader *>(file.Data());
+    if (!IsHeaderValid(*candidate, file.Size()))
+    {
+        file.Close();
+        return false;
+    }
+    header = candidate;
+    glyphs = reinterpret_cast<const FontAtlasGlyph *>(file.Data() + sizeof(FontAtlasHeader));
+    pixels = file.Data() + sizeof(FontAtlasHeader) + header->glyphCount * sizeof(FontAtlasGlyph);
+    return true;
+}
+
+const FontAtlasGlyph *FontAtlas::GetGlyph(uint32_t codepoint) const
+{
+    if (codepoint < header->firstCodepoint || codepoint >= header->firstCodepoint + header->glyphCount)
+        return nullptr;
+    return &glyphs[codepoint - header->firstCodepoint];
+}
+
+static void GetSourceStamp(const std::string &ttfPath, uint64_t &size, int64_t &writeTime)
+{
+    std::error_code ec;
+    size = static_cast<uint64_t>(std::filesystem::file_size(ttfPath, ec));
+    if (ec)
+        size = 0;
+    auto time = std::filesystem::last_write_time(ttfPath, ec);
+    writeTime = ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+bool IsFontAtlasUpToDate(const std::string &ttfPath, uint32_t pixelSize, bool sdf, const std::string &cachePath)
+{
+    std::ifstream in(cachePath, std::ios::binary);
+    if (!in)
+        return false;
+    FontAtlasHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        return false;
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(cachePath, ec);
+    if (ec || !IsHeaderValid(header, static_cast<std::size_t>(fileSize)))
+        return false;
+
+    uint64_t sourceSize;
+    int64_t sourceWriteTime;
+    GetSourceStamp(ttfPath, sourceSize, sourceWriteTime);
+    return header.pixelSize == pixelSize && header.sdf == (sdf ? 1u : 0u) && header.sourceSize == sourceSize &&
+           header.sourceWriteTime == sourceWriteTime;
+}
+
+bool BakeFontAtlas(const std::string &ttfPath, uint32_t pixelSize, bool sdf, const std::string &cachePath)
+{
+    std::ifstream in(ttfPath, std::ios::binary);
+    if (!in)
+    {
+        ES::Utils::Log::Error(fmt::format("Failed to open font {}", ttfPath));
+        return false;
+    }
+    std::vector<unsigned char> ttf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    stbtt_fontinfo info;
+    if (!stbtt_InitFont(&info, ttf.data(), stbtt_GetFontOffsetForIndex(ttf.data(), 0)))
+    {
+        ES::Utils::Log::Error(fmt::format("Failed to parse font {}", ttfPath));
+        return false;
+    }
+
+    float scale = stbtt_ScaleForPixelHeight(&info, static_cast<float>(pixelSize));
+    int ascent, descent, lineGap;
+    stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+
+    FontAtlasHeader header;
+    header.pixelSize = pixelSize;
+    header.sdf = sdf ? 1 : 0;
+    header.width = ATLAS_WIDTH;
+    header.firstCodepoint = FIRST_CODEPOINT;
+    header.glyphCount = LAST_CODEPOINT - FIRST_CODEPOINT + 1;
+    header.ascent = ascent * scale;
+    header.descent = descent * scale;
+    header.lineGap = lineGap * scale;
+    header.sdfSpread = sdf ? static_cast<float>(SDF_SPREAD) : 0.0f;
+    GetSourceStamp(ttfPath, header.sourceSize, header.sourceWriteTime);
+
+    struct Bitmap {
+        unsigned char *data = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+    std::vector<Bitmap> bitmaps(header.glyphCount);
+    std::vector<FontAtlasGlyph> glyphs(header.glyphCount);
+
+    // Rasterize every glyph, then shelf-pack them in codepoint order
+    uint32_t penX = GLYPH_PADDING;
+    uint32_t penY = GLYPH_PADDING;
+    uint32_t shelfHeight = 0;
+    for (uint32_t i = 0; i < header.glyphCount; ++i)
+    {
+        int codepoint = static_cast<int>(FIRST_CODEPOINT + i);
+        int advance, leftSideBearing, xoff = 0, yoff = 0;
+        stbtt_GetCodepointHMetrics(&info, codepoint, &advance, &leftSideBearing);
+
+        Bitmap &bitmap = bitmaps[i];
+        if (sdf)
+        {
+            bitmap.data = stbtt_GetCodepointSDF(&info, scale, codepoint, SDF_SPREAD, SDF_ON_EDGE,
+                                                static_cast<float>(SDF_ON_EDGE) / SDF_SPREAD, &bitmap.width,
+                                                &bitmap.height, &xoff, &yoff);
+        }
+        else
+        {
+            bitmap.data = stbtt_GetCodepointBitmap(&info, scale, scale, codepoint, &bitmap.width, &bitmap.height,
+                                                   &xoff, &yoff);
+        }
+
+        FontAtlasGlyph &glyph = glyphs[i];
+        glyph.advance = advance * scale;
+        glyph.bearingX = static_cast<float>(xoff);
+        glyph.bearingY = static_cast<float>(-yoff);
+        if (bitmap.data == nullptr)
+            continue;
+
+        if (penX + bitmap.width + GLYPH_PADDING > ATLAS_WIDTH)
+        {
+            penX = GLYPH_PADDING;
+            penY += shelfHeight + GLYPH_PADDING;
+            shelfHeight = 0;
+        }
+        glyph.x = static_cast<uint16_t>(penX);
+        glyph.y = static_cast<uint16_t>(penY);
+        glyph.width = static_cast<uint16_t>(bitmap.width);
+        glyph.height = static_cast<uint16_t>(bitmap.height);
+        penX += bitmap.width + GLYPH_PADDING;
+        shelfHeight = std::max(shelfHeight, static_cast<uint32_t>(bitmap.height));
+    }
+    header.height = penY + shelfHeight + GLYPH_PADDING;
+
+    std::vector<uint8_t> pixels(static_cast<std::size_t>(header.width) * header.height, 0);
+    for (uint32_t i = 0; i < header.glyphCount; ++i)
+    {
+        const Bitmap &bitmap = bitmaps[i];
+        if (bitmap.data == nullptr)
+            continue;
+        for (int row = 0; row < bitmap.height; ++row)
+        {
+            std::copy_n(bitmap.data + row * bitmap.width, bitmap.width,
+                        pixels.begin() + (glyphs[i].y + row) * header.width + glyphs[i].x);
+        }
+        if (sdf)
+            stbtt_FreeSDF(bitmap.data, nullptr);
+        else
+            stbtt_FreeBitmap(bitmap.data, nullptr);
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), ec);
+
+    // Write to a temporary file first so a crash never leaves a truncated atlas behind
+    const std::string tmpPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            ES::Utils::Log::Error(fmt::format("Failed to write font atlas {}", cachePath));
+            return false;
+        }
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(glyphs.data()), glyphs.size() * sizeof(FontAtlasGlyph));
+        out.write(reinterpret_cast<const char *>(pixels.data()), pixels.size());
+        // A short write, on a full disk for instance, must not replace the cache
+        out.close();
+        if (!out)
+        {
+            ES::Utils::Log::Error(fmt::format("Failed to write font atlas {}", cachePath));
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    if (ec)
+    {
+        ES::Utils::Log::Error(fmt::format("Failed to write font atlas {}: {}", cachePath, ec.message()));
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Binary layout of a baked glyph atlas, as written to the cache file:
+// [FontAtlasHeader][FontAtlasGlyph * glyphCount][uint8_t pixels * width * height]
+constexpr uint32_t FONT_ATLAS_MAGIC = 0x41465345; // "ESFA"
+constexpr uint32_t FONT_ATLAS_VERSION = 1;
+
+struct FontAtlasHeader {
+    uint32_t magic = FONT_ATLAS_MAGIC;
+    uint32_t version = FONT_ATLAS_VERSION;
+    uint32_t pixelSize = 0;
+    uint32_t sdf = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t firstCodepoint = 0;
+    uint32_t glyphCount = 0;
+    float ascent = 0.0f;
+    float descent = 0.0f;
+    float lineGap = 0.0f;
+    // Distance (in pixels) covered by the SDF gradient, 0 for coverage atlases
+    float sdfSpread = 0.0f;
+    // Used to detect a stale cache when the source TTF changes
+    uint64_t sourceSize = 0;
+    int64_t sourceWriteTime = 0;
+};
+
+struct FontAtlasGlyph {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    float bearingX = 0.0f;
+    float bearingY = 0.0f;
+    float advance = 0.0f;
+};
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    inline const uint8_t *Data() const { return data; }
+    inline std::size_t Size() const { return size; }
+
+  private:
+    const uint8_t *data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
+
+// Zero-copy view over a mapped atlas file
+class FontAtlas {
+  public:
+    bool Load(const std::string &cachePath);
+
+    inline const FontAtlasHeader &Header() const { return *header; }
+    inline const uint8_t *Pixels() const { return pixels; }
+    inline bool IsLoaded() const { return header != nullptr; }
+
+    const FontAtlasGlyph *GetGlyph(uint32_t codepoint) const;
+
+    // Scale to apply to the atlas metrics to render at the given pixel size.
+    // Coverage atlases only look right at their baked size, SDF atlases at any size.
+    inline float ScaleFor(uint32_t pixelSize) const
+    {
+        return static_cast<float>(pixelSize) / static_cast<float>(header->pixelSize);
+    }
+
+  private:
+    MappedFile file;
+    const FontAtlasHeader *header = nullptr;
+    const FontAtlasGlyph *glyphs = nullptr;
+    const uint8_t *pixels = nullptr;
+};
+
+// Rasterizes the printable ASCII range of a TTF into a single-channel atlas and
+// writes it to cachePath. With sdf set, glyphs are stored as signed distance fields.
+bool BakeFontAtlas(const std::string &ttfPath, uint32_t pixelSize, bool sdf, const std::string &cachePath);
+
+// True if the cache file exists, has the expected format and matches the TTF on disk
+bool IsFontAtlasUpToDate(const std::string &ttfPath, uint32_t pixelSize, bool sdf, const std::string &cachePath);
@@ -0,0 +1,79 @@
+#include "FontAtlasCache.hpp"
+
+#include "Logger.hpp"
+#include "OpenGL.hpp"
+
+#include <filesystem>
+
+std::string FontAtlasCache::GetKey(const std::string &ttfPath, uint32_t pixelSize, bool sdf)
+{
+    return fmt::format("{}@{}{}", ttfPath, pixelSize, sdf ? "sdf" : "");
+}
+
+std::string FontAtlasCache::GetCachePath(const std::string &ttfPath, uint32_t pixelSize, bool sdf) const
+{
+    auto stem = std::filesystem::path(ttfPath).stem().string();
+    return fmt::format("{}/{}_{}{}.esfa", cacheDirectory, stem, pixelSize, sdf ? "_sdf" : "");
+}
+
+const FontAtlasCache::Entry *FontAtlasCache::Acquire(const std::string &ttfPath, uint32_t pixelSize, bool sdf)
+{
+    auto key = GetKey(ttfPath, pixelSize, sdf);
+    if (auto it = atlases.find(key); it != atlases.end())
+        return it->second.get();
+
+    auto cachePath = GetCachePath(ttfPath, pixelSize, sdf);
+    if (!IsFontAtlasUpToDate(ttfPath, pixelSize, sdf, cachePath))
+    {
+        ES::Utils::Log::Info(fmt::format("Baking font atlas {}", cachePath));
+        if (!BakeFontAtlas(ttfPath, pixelSize, sdf, cachePath))
+            return nullptr;
+    }
+
+    auto entry = std::make_unique<Entry>();
+    if (!entry->atlas.Load(cachePath))
+    {
+        ES::Utils::Log::Error(fmt::format("Failed to map font atlas {}", cachePath));
+        return nullptr;
+    }
+    return atlases.emplace(key, std::move(entry)).first->second.get();
+}
+
+uint32_t FontAtlasCache::GetTexture(const std::string &ttfPath, uint32_t pixelSize, bool sdf)
+{
+    auto entry = const_cast<Entry *>(Acquire(ttfPath, pixelSize, sdf));
+    if (entry == nullptr)
+        return 0;
+    if (entry->textureId != 0)
+        return entry->textureId;
+
+    const auto &header = entry->atlas.Header();
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // Uploaded straight from the mapped file, no intermediate copy
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, header.width, header.height, 0, GL_RED, GL_UNSIGNED_BYTE,
+                 entry->atlas.Pixels());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    entry->textureId = texture;
+    return texture;
+}
+
+void FontAtlasCache::ReleaseTextures()
+{
+    for (auto &[key, entry] : atlases)
+    {
+        if (entry->textureId != 0)
+        {
+            GLuint texture = entry->textureId;
+            glDeleteTextures(1, &texture);
+            entry->textureId = 0;
+        }
+    }
+}
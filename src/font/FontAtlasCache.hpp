@@ -0,0 +1,42 @@
+#pragma once
+
+#include "FontAtlas.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Process-wide font cache, registered once at startup so it outlives scene reloads.
+// Atlases are baked on first run, then memory mapped from the cache directory on
+// every later run; a given (font, size) is never rasterized twice. The
+// HudTextRenderer draws the HUD from it.
+class FontAtlasCache {
+  public:
+    struct Entry {
+        FontAtlas atlas;
+        // Atlas pixels uploaded as a single channel texture, 0 until first use on the GL thread
+        uint32_t textureId = 0;
+    };
+
+    explicit FontAtlasCache(std::string cacheDirectory = "cache/font") : cacheDirectory(std::move(cacheDirectory)) {}
+
+    FontAtlasCache(FontAtlasCache &&) = default;
+    FontAtlasCache &operator=(FontAtlasCache &&) = default;
+
+    // Returns the atlas for the given font, baking it if needed. With sdf set the
+    // pixel size only picks the bake resolution: the same atlas serves every size.
+    const Entry *Acquire(const std::string &ttfPath, uint32_t pixelSize, bool sdf = true);
+
+    // Uploads the atlas texture on first call and returns its GL id
+    uint32_t GetTexture(const std::string &ttfPath, uint32_t pixelSize, bool sdf = true);
+
+    void ReleaseTextures();
+
+  private:
+    std::string GetCachePath(const std::string &ttfPath, uint32_t pixelSize, bool sdf) const;
+    static std::string GetKey(const std::string &ttfPath, uint32_t pixelSize, bool sdf);
+
+    std::string cacheDirectory;
+    std::unordered_map<std::string, std::unique_ptr<Entry>> atlases;
+};
@@ -0,0 +1,141 @@
+#include "HudText.hpp"
+
+#include "FontAtlasCache.hpp"
+#include "Logger.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstddef>
+
+void HudTextRenderer::Init(ES::Engine::Core &core)
+{
+    auto &cache = core.GetResource<FontAtlasCache>();
+    const FontAtlasCache::Entry *entry = cache.Acquire(HUD_FONT, HUD_FONT_BAKE_SIZE, true);
+    if (entry == nullptr)
+    {
+        ES::Utils::Log::Error(fmt::format("HudTextRenderer: no atlas for {}, the HUD has no text", HUD_FONT));
+        return;
+    }
+    atlas = &entry->atlas;
+    atlasTexture = cache.GetTexture(HUD_FONT, HUD_FONT_BAKE_SIZE, true);
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          reinterpret_cast<void *>(offsetof(Vertex, position)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, uv)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          reinterpret_cast<void *>(offsetof(Vertex, color)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void HudTextRenderer::Shutdown()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vertexBuffer);
+    vao = 0;
+    vertexBuffer = 0;
+    // The texture belongs to the FontAtlasCache
+    atlasTexture = 0;
+    atlas = nullptr;
+}
+
+void HudTextRenderer::AddLine(const HudText &line, ArenaVector<Vertex> &vertices) const
+{
+    const FontAtlasHeader &header = atlas->Header();
+    const float scale = atlas->ScaleFor(static_cast<uint32_t>(HUD_FONT_SIZE * line.scale + 0.5f));
+    const glm::vec2 texel = 1.0f / glm::vec2(header.width, header.height);
+
+    glm::vec2 pen = line.position;
+    for (char c : line.text)
+    {
+        const FontAtlasGlyph *glyph = atlas->GetGlyph(static_cast<unsigned char>(c));
+        if (glyph == nullptr)
+            continue;
+        if (glyph->width > 0 && glyph->height > 0)
+        {
+            // Atlas rows go down from the top of the glyph, window y goes up
+            const glm::vec2 topLeft = pen + glm::vec2(glyph->bearingX, glyph->bearingY) * scale;
+            const glm::vec2 size = glm::vec2(glyph->width, glyph->height) * scale;
+            const glm::vec2 uvMin = glm::vec2(glyph->x, glyph->y) * texel;
+            const glm::vec2 uvMax = glm::vec2(glyph->x + glyph->width, glyph->y + glyph->height) * texel;
+
+            const Vertex tl{topLeft, uvMin, line.color};
+            const Vertex tr{topLeft + glm::vec2(size.x, 0.0f), glm::vec2(uvMax.x, uvMin.y), line.color};
+            const Vertex bl{topLeft - glm::vec2(0.0f, size.y), glm::vec2(uvMin.x, uvMax.y), line.color};
+            const Vertex br{topLeft + glm::vec2(size.x, -size.y), uvMax, line.color};
+            vertices.insert(vertices.end(), {tl, bl, br, tl, br, tr});
+        }
+        pen.x += glyph->advance * scale;
+    }
+}
+
+void HudTextRenderer::Draw(ES::Engine::Core &core)
+{
+    if (atlas == nullptr)
+        return;
+
+    // Rebuilt every frame in the frame arena, released by ResetFrameArena
+    auto lines = core.GetRegistry().view<HudText>();
+    std::size_t characters = 0;
+    lines.each([&characters](auto, const HudText &line) { characters += line.text.size(); });
+    ArenaVector<Vertex> vertices(&core.GetResource<FrameArenas>().frame);
+    vertices.reserve(characters * 6);
+    lines.each([this, &vertices](auto, const HudText &line) { AddLine(line, vertices); });
+    if (vertices.empty())
+        return;
+
+    int width = 0;
+    int height = 0;
+    glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
+    const glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height));
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    // Orphaned every frame, the driver hands back fresh storage while the GPU reads the old one
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    using namespace entt;
+    auto &sp = core.GetResource<ES::Plugin::OpenGL::Resource::ShaderManager>().Get("hudText"_hs);
+    sp.Use();
+    glUniformMatrix4fv(sp.GetUniform("Projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    sp.Disable();
+}
+
+void InitHudText(ES::Engine::Core &core)
+{
+    core.GetResource<HudTextRenderer>().Init(core);
+}
+
+void RenderHudText(ES::Engine::Core &core)
+{
+    core.GetResource<HudTextRenderer>().Draw(core);
+}
+
+void ShutdownHudText(ES::Engine::Core &core)
+{
+    core.GetResource<HudTextRenderer>().Shutdown();
+    core.GetResource<FontAtlasCache>().ReleaseTextures();
+}
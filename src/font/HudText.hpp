@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Core.hpp"
+#include "FontAtlas.hpp"
+#include "OpenGL.hpp"
+#include "memory/LinearArena.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+
+// A line of HUD text, drawn by the HudTextRenderer from the cached font atlas.
+// Position is the baseline start in pixels from the bottom left of the window.
+struct HudText {
+    std::string text;
+    glm::vec2 position = glm::vec2(0.0f);
+    // 1 is HUD_FONT_SIZE pixels
+    float scale = 1.0f;
+    glm::vec3 color = glm::vec3(1.0f);
+};
+
+// Draws every HudText with the SDF atlas of the FontAtlasCache: the atlas is baked on
+// the first run only, later runs map the cached file and upload it as is, so no
+// session rasterizes the TTF again. All the lines share one vertex buffer and one
+// draw call, rebuilt every frame.
+class HudTextRenderer {
+  public:
+    static constexpr const char *HUD_FONT = "asset/font/Tomorrow-Medium.ttf";
+    // Size the SDF atlas is baked at, it serves every HUD size
+    static constexpr uint32_t HUD_FONT_BAKE_SIZE = 48;
+    static constexpr float HUD_FONT_SIZE = 32.0f;
+
+    HudTextRenderer() = default;
+
+    HudTextRenderer(HudTextRenderer &&) = default;
+    HudTextRenderer &operator=(HudTextRenderer &&) = default;
+
+    // Must be called once a GL context exists
+    void Init(ES::Engine::Core &core);
+    void Shutdown();
+
+    void Draw(ES::Engine::Core &core);
+
+  private:
+    // Mirrors the vertex layout of the hudText shader
+    struct Vertex {
+        glm::vec2 position;
+        glm::vec2 uv;
+        glm::vec3 color;
+    };
+
+    void AddLine(const HudText &line, ArenaVector<Vertex> &vertices) const;
+
+    GLuint atlasTexture = 0;
+    const FontAtlas *atlas = nullptr;
+    GLuint vao = 0;
+    GLuint vertexBuffer = 0;
+};
+
+void InitHudText(ES::Engine::Core &core);
+
+void RenderHudText(ES::Engine::Core &core);
+
+void ShutdownHudText(ES::Engine::Core &core);
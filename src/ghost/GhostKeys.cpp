@@ -0,0 +1,41 @@
+#include "GhostKeys.hpp"
+
+#include "GhostPlayer.hpp"
+#include "GhostRecorder.hpp"
+#include "Logger.hpp"
+
+#include <chrono>
+
+void FinishGhostLap(ES::Engine::Core &core)
+{
+    auto &recorder = core.GetResource<GhostRecorder>();
+    if (!recorder.IsRecording())
+        return;
+
+    ES::Engine::Entity vehicle = recorder.GetVehicle();
+    GhostTrack track = recorder.Finish();
+    recorder.Start(vehicle);
+    if (track.GetDuration() <= 0.0f)
+        return;
+
+    auto stamp = std::chrono::duration_cast<std::chrono::seconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+    std::string path = fmt::format("{}/lap_{}.esgh", GHOST_DIRECTORY, stamp);
+    if (track.Save(path))
+        ES::Utils::Log::Info(fmt::format("Saved {:.2f}s ghost lap to {}", track.GetDuration(), path));
+    else
+        ES::Utils::Log::Warn(fmt::format("Failed to save ghost lap to {}", path));
+
+    auto &player = core.GetResource<GhostPlayer>();
+    player.Add(core, std::move(track));
+    player.Restart();
+}
+
+void GhostKeys::operator()(ES::Engine::Core &core) const
+{
+    bool lapPressed = ES::Plugin::Input::Utils::IsKeyPressed(lapKey);
+    if (lapPressed && !lapWasPressed)
+        FinishGhostLap(core);
+    lapWasPressed = lapPressed;
+}
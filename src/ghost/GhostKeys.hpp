@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Engine.hpp"
+
+#include "Input.hpp"
+
+#include <string>
+
+// Ends the lap being recorded: saves it next to the previous ones, starts it as a
+// ghost and begins recording the next lap
+class GhostKeys
+{
+  public:
+    void operator()(ES::Engine::Core &core) const;
+
+    inline void SetLapKey(int key) { lapKey = key; }
+
+  private:
+    int lapKey = GLFW_KEY_G;
+    mutable bool lapWasPressed = false;
+};
+
+// Ghost files are kept there between runs and loaded when the game scene starts
+constexpr const char *GHOST_DIRECTORY = "cache/ghost";
+
+// Saves the current recording as a new lap and restarts recording
+void FinishGhostLap(ES::Engine::Core &core);
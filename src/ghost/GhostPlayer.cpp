@@ -0,0 +1,86 @@
+#include "GhostPlayer.hpp"
+
+#include "Logger.hpp"
+#include "Object.hpp"
+#include "physics/TransformSync.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+void GhostPlayer::Add(ES::Engine::Core &core, GhostTrack track)
+{
+    ghosts.push_back(Ghost{std::move(track), CreateVehicleVisual(core)});
+}
+
+uint32_t GhostPlayer::LoadDirectory(ES::Engine::Core &core, const std::string &directory)
+{
+    std::error_code ec;
+    if (!std::filesystem::is_directory(directory, ec))
+        return 0;
+
+    // Sorted so ghosts come back in the same order on every run
+    std::vector<std::filesystem::path> paths;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, ec))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".esgh")
+            paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    uint32_t loaded = 0;
+    for (const auto &path : paths)
+    {
+        GhostTrack track;
+        if (!GhostTrack::Load(path.string(), track))
+        {
+            ES::Utils::Log::Warn(fmt::format("Skipping unreadable ghost file {}", path.string()));
+            continue;
+        }
+        Add(core, std::move(track));
+        loaded++;
+    }
+    return loaded;
+}
+
+void GhostPlayer::Restart()
+{
+    for (auto &ghost : ghosts)
+        ghost.time = 0.0f;
+}
+
+void GhostPlayer::Update(ES::Engine::Core &core, float deltaTime)
+{
+    using ES::Plugin::Object::Component::Transform;
+
+    auto &transformSync = core.GetResource<TransformSync>();
+    for (auto &ghost : ghosts)
+    {
+        // Ghosts loop so a finished lap keeps showing the line
+        const float duration = ghost.track.GetDuration();
+        ghost.time += deltaTime;
+        if (duration > 0.0f && ghost.time > duration)
+            ghost.time = std::fmod(ghost.time, duration);
+
+        const GhostFrame frame = ghost.track.Sample(ghost.time);
+        const GhostPose &body = frame[0];
+
+        auto &bodyTransform = ghost.visual.body.GetComponents<Transform>(core);
+        bodyTransform.position = body.position;
+        bodyTransform.rotation = body.rotation;
+        transformSync.MarkDirty(ghost.visual.body);
+        for (uint32_t i = 0; i < ghost.visual.wheels.size(); ++i)
+        {
+            const GhostPose &wheel = frame[i + 1];
+            auto &wheelTransform = ghost.visual.wheels[i].GetComponents<Transform>(core);
+            wheelTransform.position = body.position + body.rotation * wheel.position;
+            wheelTransform.rotation = body.rotation * wheel.rotation;
+            transformSync.MarkDirty(ghost.visual.wheels[i]);
+        }
+    }
+}
+
+void PlayGhosts(ES::Engine::Core &core)
+{
+    core.GetResource<GhostPlayer>().Update(core, core.GetScheduler<ES::Engine::Scheduler::Update>().GetDeltaTime());
+}
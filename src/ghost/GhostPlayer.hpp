@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CreateVehicle.hpp"
+#include "Engine.hpp"
+#include "GhostTrack.hpp"
+
+#include <string>
+#include <vector>
+
+// Replays recorded laps on render-only vehicle visuals. Ghosts never touch the
+// physics system: no body, no VehicleConstraint, nothing to collide with, so any
+// number of them can run next to the simulated cars.
+class GhostPlayer {
+  public:
+    GhostPlayer() = default;
+
+    GhostPlayer(GhostPlayer &&) = default;
+    GhostPlayer &operator=(GhostPlayer &&) = default;
+
+    void Add(ES::Engine::Core &core, GhostTrack track);
+
+    // Adds every ghost file found in the directory, returns how many were loaded
+    uint32_t LoadDirectory(ES::Engine::Core &core, const std::string &directory);
+
+    // Restarts every ghost from the beginning of its lap
+    void Restart();
+
+    void Update(ES::Engine::Core &core, float deltaTime);
+
+    // Forgets every ghost. Their entities are left to the caller, who usually clears
+    // the whole scene at the same time.
+    inline void Clear() { ghosts.clear(); }
+
+    inline std::size_t GetCount() const { return ghosts.size(); }
+
+  private:
+    struct Ghost {
+        GhostTrack track;
+        VehicleVisual visual;
+        float time = 0.0f;
+    };
+
+    std::vector<Ghost> ghosts;
+};
+
+void PlayGhosts(ES::Engine::Core &core);
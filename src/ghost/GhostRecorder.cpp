@@ -0,0 +1,53 @@
+#include "GhostRecorder.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Object.hpp"
+#include "WheeledVehicle3D.hpp"
+
+void GhostRecorder::Start(ES::Engine::Entity vehicle_)
+{
+    vehicle = vehicle_;
+    recording = true;
+    frames.clear();
+    // A few minutes at 240Hz, avoids reallocating during a lap
+    frames.reserve(240 * 180);
+}
+
+GhostTrack GhostRecorder::Finish()
+{
+    recording = false;
+    GhostTrack track = GhostTrack::Compress(frames, tickRate);
+    frames.clear();
+    return track;
+}
+
+void GhostRecorder::Record(ES::Engine::Core &core)
+{
+    using ES::Plugin::Object::Component::Transform;
+
+    if (!recording)
+        return;
+    auto &registry = core.GetRegistry();
+    if (!registry.valid(vehicle) || !registry.all_of<ES::Plugin::Physics::Component::WheeledVehicle3D>(vehicle))
+    {
+        recording = false;
+        return;
+    }
+
+    const auto &body = registry.get<Transform>(vehicle);
+    const auto &wheels = registry.get<ES::Plugin::Physics::Component::WheeledVehicle3D>(vehicle).wheelEntities;
+    const glm::quat inverseRotation = glm::inverse(body.rotation);
+
+    GhostFrame &frame = frames.emplace_back();
+    frame[0] = GhostPose{body.position, body.rotation};
+    for (uint32_t i = 0; i < GHOST_CHANNEL_COUNT - 1 && i < wheels.size(); ++i)
+    {
+        const auto &wheel = registry.get<Transform>(wheels[i]);
+        frame[i + 1] = GhostPose{inverseRotation * (wheel.position - body.position), inverseRotation * wheel.rotation};
+    }
+}
+
+void RecordGhost(ES::Engine::Core &core)
+{
+    core.GetResource<GhostRecorder>().Record(core);
+}
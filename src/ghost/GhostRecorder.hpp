@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Engine.hpp"
+#include "GhostTrack.hpp"
+
+#include <vector>
+
+// Records the body and wheel Transforms of one vehicle every fixed tick
+class GhostRecorder {
+  public:
+    // tickRate must match the FixedTimeUpdate rate Record runs at
+    explicit GhostRecorder(float tickRate = 1.0f / 240.0f) : tickRate(tickRate) {}
+
+    GhostRecorder(GhostRecorder &&) = default;
+    GhostRecorder &operator=(GhostRecorder &&) = default;
+
+    // Starts a new recording of the given WheeledVehicle3D, dropping the current one
+    void Start(ES::Engine::Entity vehicle);
+
+    // Ends the recording and returns it compressed, the recorder goes idle
+    GhostTrack Finish();
+
+    void Record(ES::Engine::Core &core);
+
+    inline void Cancel() { recording = false; }
+    inline bool IsRecording() const { return recording; }
+    inline ES::Engine::Entity GetVehicle() const { return vehicle; }
+
+  private:
+    float tickRate;
+    ES::Engine::Entity vehicle;
+    bool recording = false;
+    std::vector<GhostFrame> frames;
+};
+
+void RecordGhost(ES::Engine::Core &core);
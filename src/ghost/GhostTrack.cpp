@@ -0,0 +1,336 @@
+#include "GhostTrack.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+constexpr char GHOST_MAGIC[4] = {'E', 'S', 'G', 'H'};
+constexpr uint32_t GHOST_VERSION = 1;
+
+constexpr float POSITION_STEP = 1.0f / 1024.0f;
+constexpr float ROTATION_COMPONENT_MAX = 0.70710678f; // 1 / sqrt(2)
+constexpr int32_t ROTATION_COMPONENT_RANGE = 16383;
+
+struct GhostFileHeader {
+    char magic[4];
+    uint32_t version;
+    float tickRate;
+    uint32_t tickCount;
+    uint32_t channelCount;
+};
+
+struct QuantizedPose {
+    std::array<int32_t, 3> position = {};
+    uint32_t rotationLargest = 3;
+    std::array<int32_t, 3> rotation = {};
+};
+
+static QuantizedPose Quantize(const GhostPose &pose)
+{
+    QuantizedPose q;
+    for (int i = 0; i < 3; ++i)
+        q.position[i] = static_cast<int32_t>(std::lround(pose.position[i] / POSITION_STEP));
+
+    // Smallest three, the dropped component is rebuilt from the unit length
+    glm::quat rotation = glm::normalize(pose.rotation);
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; ++i)
+    {
+        if (std::abs(rotation[i]) > std::abs(rotation[largest]))
+            largest = i;
+    }
+    const float sign = rotation[largest] < 0.0f ? -1.0f : 1.0f;
+    q.rotationLargest = largest;
+    for (uint32_t i = 0, j = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float component = std::clamp(sign * rotation[i] / ROTATION_COMPONENT_MAX, -1.0f, 1.0f);
+        q.rotation[j++] = static_cast<int32_t>(std::lround(component * ROTATION_COMPONENT_RANGE));
+    }
+    return q;
+}
+
+static GhostPose Dequantize(const QuantizedPose &q)
+{
+    GhostPose pose;
+    for (int i = 0; i < 3; ++i)
+        pose.position[i] = q.position[i] * POSITION_STEP;
+
+    float sumSquares = 0.0f;
+    for (uint32_t i = 0, j = 0; i < 4; ++i)
+    {
+        if (i == q.rotationLargest)
+            continue;
+        float component = static_cast<float>(q.rotation[j++]) / ROTATION_COMPONENT_RANGE * ROTATION_COMPONENT_MAX;
+        pose.rotation[i] = component;
+        sumSquares += component * component;
+    }
+    pose.rotation[q.rotationLargest] = std::sqrt(std::max(0.0f, 1.0f - sumSquares));
+    pose.rotation = glm::normalize(pose.rotation);
+    return pose;
+}
+
+static GhostPose Interpolate(const GhostPose &a, const GhostPose &b, float t)
+{
+    return GhostPose{glm::mix(a.position, b.position, t), glm::slerp(a.rotation, b.rotation, t)};
+}
+
+static float RotationError(const glm::quat &a, const glm::quat &b)
+{
+    float dot = std::min(1.0f, std::abs(glm::dot(a, b)));
+    return 2.0f * std::acos(dot);
+}
+
+// Douglas-Peucker over time: keeps the sample that deviates most from the segment
+// between two kept keys until every sample is within tolerance
+static std::vector<GhostTrack::Key> ReduceChannel(const std::vector<GhostPose> &samples, float positionTolerance,
+                                                  float rotationTolerance)
+{
+    const std::size_t count = samples.size();
+    std::vector<bool> keep(count, false);
+    keep.front() = true;
+    keep.back() = true;
+
+    std::vector<std::pair<std::size_t, std::size_t>> segments;
+    if (count > 2)
+        segments.emplace_back(0, count - 1);
+    while (!segments.empty())
+    {
+        auto [first, last] = segments.back();
+        segments.pop_back();
+
+        float worstError = 1.0f;
+        std::size_t worst = first;
+        for (std::size_t i = first + 1; i < last; ++i)
+        {
+            float t = static_cast<float>(i - first) / static_cast<float>(last - first);
+            GhostPose predicted = Interpolate(samples[first], samples[last], t);
+            float error = std::max(glm::distance(predicted.position, samples[i].position) / positionTolerance,
+                                   RotationError(predicted.rotation, samples[i].rotation) / rotationTolerance);
+            if (error > worstError)
+            {
+                worstError = error;
+                worst = i;
+            }
+        }
+        if (worst == first)
+            continue;
+        keep[worst] = true;
+        if (worst - first > 1)
+            segments.emplace_back(first, worst);
+        if (last - worst > 1)
+            segments.emplace_back(worst, last);
+    }
+
+    std::vector<GhostTrack::Key> keys;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (keep[i])
+            keys.push_back(GhostTrack::Key{static_cast<uint32_t>(i), samples[i]});
+    }
+    return keys;
+}
+
+GhostTrack GhostTrack::Compress(const std::vector<GhostFrame> &frames, float tickRate, float positionTolerance,
+                                float rotationTolerance)
+{
+    GhostTrack track;
+    track.tickRate = tickRate;
+    track.tickCount = static_cast<uint32_t>(frames.size());
+    if (frames.empty())
+        return track;
+
+    std::vector<GhostPose> samples(frames.size());
+    for (uint32_t channel = 0; channel < GHOST_CHANNEL_COUNT; ++channel)
+    {
+        // Reduce the values the file will hold, so the tolerance covers the quantization too
+        for (std::size_t i = 0; i < frames.size(); ++i)
+            samples[i] = Dequantize(Quantize(frames[i][channel]));
+        track.channels[channel] = ReduceChannel(samples, positionTolerance, rotationTolerance);
+    }
+    return track;
+}
+
+GhostFrame GhostTrack::Sample(float time) const
+{
+    GhostFrame frame;
+    const float tick = std::max(0.0f, time / tickRate);
+    for (uint32_t channel = 0; channel < GHOST_CHANNEL_COUNT; ++channel)
+    {
+        const auto &keys = channels[channel];
+        if (keys.empty())
+            continue;
+        auto next = std::upper_bound(keys.begin(), keys.end(), tick,
+                                     [](float value, const Key &key) { return value < static_cast<float>(key.tick); });
+        if (next == keys.begin())
+        {
+            frame[channel] = keys.front().pose;
+            continue;
+        }
+        if (next == keys.end())
+        {
+            frame[channel] = keys.back().pose;
+            continue;
+        }
+        const Key &previous = *std::prev(next);
+        float t = (tick - previous.tick) / static_cast<float>(next->tick - previous.tick);
+        frame[channel] = Interpolate(previous.pose, next->pose, t);
+    }
+    return frame;
+}
+
+static void WriteVarint(std::vector<uint8_t> &out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void WriteSignedVarint(std::vector<uint8_t> &out, int32_t value)
+{
+    // Zigzag keeps small negative deltas small
+    WriteVarint(out, (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+}
+
+class ByteReader {
+  public:
+    ByteReader(const uint8_t *data, std::size_t size) : data(data), size(size) {}
+
+    uint32_t ReadVarint()
+    {
+        uint32_t value = 0;
+        for (uint32_t shift = 0; shift < 35; shift += 7)
+        {
+            if (position >= size)
+            {
+                failed = true;
+                return 0;
+            }
+            uint8_t byte = data[position++];
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+        failed = true;
+        return 0;
+    }
+
+    int32_t ReadSignedVarint()
+    {
+        uint32_t value = ReadVarint();
+        return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    inline bool HasFailed() const { return failed; }
+
+  private:
+    const uint8_t *data;
+    std::size_t size;
+    std::size_t position = 0;
+    bool failed = false;
+};
+
+bool GhostTrack::Save(const std::string &path) const
+{
+    GhostFileHeader header;
+    std::memcpy(header.magic, GHOST_MAGIC, sizeof(header.magic));
+    header.version = GHOST_VERSION;
+    header.tickRate = tickRate;
+    header.tickCount = tickCount;
+    header.channelCount = GHOST_CHANNEL_COUNT;
+
+    // Keys are delta coded against the previous key of the same channel
+    std::vector<uint8_t> body;
+    for (const auto &keys : channels)
+    {
+        WriteVarint(body, static_cast<uint32_t>(keys.size()));
+        uint32_t previousTick = 0;
+        QuantizedPose previous;
+        for (const Key &key : keys)
+        {
+            QuantizedPose q = Quantize(key.pose);
+            WriteVarint(body, key.tick - previousTick);
+            for (int i = 0; i < 3; ++i)
+                WriteSignedVarint(body, q.position[i] - previous.position[i]);
+            WriteVarint(body, q.rotationLargest);
+            for (int i = 0; i < 3; ++i)
+            {
+                int32_t baseline = q.rotationLargest == previous.rotationLargest ? previous.rotation[i] : 0;
+                WriteSignedVarint(body, q.rotation[i] - baseline);
+            }
+            previousTick = key.tick;
+            previous = q;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(body.data()), static_cast<std::streamsize>(body.size()));
+    return static_cast<bool>(file);
+}
+
+bool GhostTrack::Load(const std::string &path, GhostTrack &track)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    GhostFileHeader header;
+    if (data.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, GHOST_MAGIC, sizeof(header.magic)) != 0 || header.version != GHOST_VERSION ||
+        header.channelCount != GHOST_CHANNEL_COUNT || header.tickRate <= 0.0f)
+        return false;
+
+    GhostTrack loaded;
+    loaded.tickRate = header.tickRate;
+    loaded.tickCount = header.tickCount;
+
+    ByteReader reader(data.data() + sizeof(header), data.size() - sizeof(header));
+    for (auto &keys : loaded.channels)
+    {
+        uint32_t keyCount = reader.ReadVarint();
+        if (reader.HasFailed() || keyCount > header.tickCount)
+            return false;
+        keys.resize(keyCount);
+
+        uint32_t tick = 0;
+        QuantizedPose q;
+        for (Key &key : keys)
+        {
+            tick += reader.ReadVarint();
+            for (int i = 0; i < 3; ++i)
+                q.position[i] += reader.ReadSignedVarint();
+            uint32_t largest = reader.ReadVarint();
+            if (largest > 3)
+                return false;
+            for (int i = 0; i < 3; ++i)
+            {
+                int32_t baseline = largest == q.rotationLargest ? q.rotation[i] : 0;
+                q.rotation[i] = baseline + reader.ReadSignedVarint();
+            }
+            q.rotationLargest = largest;
+            key.tick = tick;
+            key.pose = Dequantize(q);
+        }
+    }
+    if (reader.HasFailed())
+        return false;
+
+    track = std::move(loaded);
+    return true;
+}
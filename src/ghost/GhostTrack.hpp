@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Body plus the four wheels. Wheels are stored relative to the body, which keeps
+// their position nearly constant and lets keyframe reduction drop most of them.
+constexpr uint32_t GHOST_CHANNEL_COUNT = 5;
+
+struct GhostPose {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+};
+
+using GhostFrame = std::array<GhostPose, GHOST_CHANNEL_COUNT>;
+
+// One recorded lap, reduced to the keyframes needed to stay within the given
+// position and rotation tolerances of the recording when interpolated linearly.
+class GhostTrack {
+  public:
+    struct Key {
+        uint32_t tick = 0;
+        GhostPose pose;
+    };
+
+    static GhostTrack Compress(const std::vector<GhostFrame> &frames, float tickRate, float positionTolerance = 0.01f,
+                               float rotationTolerance = 0.01f);
+
+    // Pose of every channel at the given time, clamped to the recorded range
+    GhostFrame Sample(float time) const;
+
+    bool Save(const std::string &path) const;
+    static bool Load(const std::string &path, GhostTrack &track);
+
+    inline float GetDuration() const { return tickCount > 0 ? (tickCount - 1) * tickRate : 0.0f; }
+    inline const std::vector<Key> &GetKeys(uint32_t channel) const { return channels[channel]; }
+
+  private:
+    float tickRate = 1.0f / 240.0f;
+    uint32_t tickCount = 0;
+    std::array<std::vector<Key>, GHOST_CHANNEL_COUNT> channels;
+};
@@ -0,0 +1,262 @@
+#include "InputService.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+constexpr uint32_t KEY_CHANNELS = GLFW_KEY_LAST + 1;
+// Farther than this from the wall clock, the tick windows are realigned on it: after
+// a hitch, or when the fixed scheduler drops time
+constexpr double MAX_DRIFT_SECONDS = 0.1;
+// Weight of the newest sample in the average latency
+constexpr float LATENCY_SMOOTHING = 0.05f;
+
+InputService::Devices::~Devices()
+{
+    stop = true;
+    if (simulatedThread.joinable())
+        simulatedThread.join();
+    if (keyCallbackDevices == this)
+        keyCallbackDevices = nullptr;
+}
+
+void InputService::Devices::Push(Queue &queue, const Event &event)
+{
+    if (!queue.TryPush(event))
+        dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+InputService::InputService() : devices(std::make_unique<Devices>())
+{
+    channels.resize(KEY_CHANNELS + MAX_AXES + MAX_BUTTONS);
+    touched.reserve(channels.size());
+    joystickAxes.assign(MAX_AXES, 0.0f);
+    joystickButtons.assign(MAX_BUTTONS, 0);
+}
+
+double InputService::Now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void InputService::OnKey(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+    if (previousKeyCallback != nullptr)
+        previousKeyCallback(window, key, scancode, action, mods);
+    if (keyCallbackDevices == nullptr || key < 0 || key > GLFW_KEY_LAST || action == GLFW_REPEAT)
+        return;
+    keyCallbackDevices->Push(keyCallbackDevices->keyboard, Event{Now(), EventType::KEY, static_cast<uint16_t>(key),
+                                                                 action == GLFW_PRESS ? 1.0f : 0.0f});
+}
+
+bool InputService::InstallKeyCallback()
+{
+    GLFWwindow *window = glfwGetCurrentContext();
+    if (window == nullptr)
+        return false;
+    keyCallbackDevices = devices.get();
+    GLFWkeyfun previous = glfwSetKeyCallback(window, OnKey);
+    if (previous != OnKey)
+        previousKeyCallback = previous;
+    return true;
+}
+
+void InputService::SampleJoystick(int joystick, double time)
+{
+    int axisCount = 0;
+    int buttonCount = 0;
+    const float *axes = glfwJoystickPresent(joystick) ? glfwGetJoystickAxes(joystick, &axisCount) : nullptr;
+    const unsigned char *buttons = axes != nullptr ? glfwGetJoystickButtons(joystick, &buttonCount) : nullptr;
+    joystickAxisCount = axes != nullptr ? std::min<uint32_t>(axisCount, MAX_AXES) : 0;
+    joystickButtonCount = buttons != nullptr ? std::min<uint32_t>(buttonCount, MAX_BUTTONS) : 0;
+
+    for (uint32_t axis = 0; axis < joystickAxisCount; ++axis)
+    {
+        if (axes[axis] == joystickAxes[axis])
+            continue;
+        joystickAxes[axis] = axes[axis];
+        devices->Push(devices->joystick,
+                      Event{time, EventType::JOYSTICK_AXIS, static_cast<uint16_t>(axis), axes[axis]});
+    }
+    for (uint32_t button = 0; button < joystickButtonCount; ++button)
+    {
+        if (buttons[button] == joystickButtons[button])
+            continue;
+        joystickButtons[button] = buttons[button];
+        devices->Push(devices->joystick, Event{time, EventType::JOYSTICK_BUTTON, static_cast<uint16_t>(button),
+                                               buttons[button] == GLFW_PRESS ? 1.0f : 0.0f});
+    }
+}
+
+void InputService::StartSimulatedDevice(const SimulatedInputSettings &settings)
+{
+    if (devices->simulatedThread.joinable())
+        return;
+
+    Devices *target = devices.get();
+    target->simulatedThread = std::thread([target, settings] {
+        const auto interval = std::chrono::duration<double>(1.0 / settings.sampleRate);
+        const double start = Now();
+        auto next = std::chrono::steady_clock::now();
+        bool pressed = false;
+        while (!target->stop.load(std::memory_order_relaxed))
+        {
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+            std::this_thread::sleep_until(next);
+
+            // Timestamped when sampled, like a real device would be
+            const double now = Now();
+            const bool down = std::fmod(now - start, static_cast<double>(settings.period)) < settings.pressDuration;
+            if (down == pressed)
+                continue;
+            pressed = down;
+            target->Push(target->simulated,
+                         Event{now, EventType::KEY, static_cast<uint16_t>(settings.key), down ? 1.0f : 0.0f});
+        }
+    });
+}
+
+uint32_t InputService::ChannelIndex(EventType type, uint16_t code) const
+{
+    switch (type)
+    {
+    case EventType::KEY: return code < KEY_CHANNELS ? code : UINT32_MAX;
+    case EventType::JOYSTICK_AXIS: return code < MAX_AXES ? KEY_CHANNELS + code : UINT32_MAX;
+    case EventType::JOYSTICK_BUTTON: return code < MAX_BUTTONS ? KEY_CHANNELS + MAX_AXES + code : UINT32_MAX;
+    }
+    return UINT32_MAX;
+}
+
+const InputService::Event *InputService::PeekOldest(Queue *&from) const
+{
+    const Event *oldest = nullptr;
+    from = nullptr;
+    for (Queue *queue : {&devices->keyboard, &devices->joystick, &devices->simulated})
+    {
+        const Event *event = queue->Peek();
+        if (event != nullptr && (oldest == nullptr || event->time < oldest->time))
+        {
+            oldest = event;
+            from = queue;
+        }
+    }
+    return oldest;
+}
+
+void InputService::Touch(uint32_t index, double tickStart)
+{
+    Channel &channel = channels[index];
+    if (channel.touched)
+        return;
+    channel.touched = true;
+    channel.integral = 0.0;
+    channel.since = tickStart;
+    touched.push_back(index);
+}
+
+void InputService::Advance(Channel &channel, double time)
+{
+    if (channel.releaseTime > 0.0 && channel.releaseTime <= time)
+    {
+        const double release = std::max(channel.releaseTime, channel.since);
+        channel.integral += channel.value * (release - channel.since);
+        channel.since = release;
+        channel.value = 0.0f;
+        channel.releaseTime = 0.0;
+    }
+    channel.integral += channel.value * (time - channel.since);
+    channel.since = time;
+}
+
+double InputService::GetNextTickStart(double tickSeconds) const
+{
+    const double now = Now();
+    if (tickEnd == 0.0 || std::abs(tickEnd + tickSeconds - now) > MAX_DRIFT_SECONDS)
+        return now - tickSeconds;
+    return tickEnd;
+}
+
+void InputService::Consume(double tickSeconds)
+{
+    const double now = Now();
+    const double tickStart = GetNextTickStart(tickSeconds);
+    tickEnd = tickStart + tickSeconds;
+
+    for (uint32_t index : touched)
+    {
+        channels[index].touched = false;
+        channels[index].pressed = false;
+    }
+    touched.clear();
+
+    // Events from all devices, oldest first, up to the end of the window
+    stats.events = 0;
+    Queue *from = nullptr;
+    for (const Event *event = PeekOldest(from); event != nullptr && event->time < tickEnd; event = PeekOldest(from))
+    {
+        const uint32_t index = ChannelIndex(event->type, event->code);
+        if (index != UINT32_MAX)
+        {
+            Touch(index, tickStart);
+            Channel &channel = channels[index];
+            // Late events, from before the window, count from its start
+            const double time = std::max(event->time, tickStart);
+            Advance(channel, time);
+
+            // A key whose release is pending is still down as far as presses go
+            const bool wasDown = channel.value >= 0.5f && channel.releaseTime == 0.0;
+            const bool isDown = event->value >= 0.5f;
+            if (!wasDown && isDown)
+            {
+                channel.pressed = true;
+                channel.pressTime = time;
+            }
+            const bool holdDown = event->type == EventType::KEY && wasDown && !isDown &&
+                                  time < channel.pressTime + MIN_PRESS_SECONDS;
+            channel.releaseTime = holdDown ? channel.pressTime + MIN_PRESS_SECONDS : 0.0;
+            if (!holdDown)
+                channel.value = event->value;
+        }
+
+        const auto latency = static_cast<float>((now - event->time) * 1000.0);
+        stats.averageLatencyMs += LATENCY_SMOOTHING * (latency - stats.averageLatencyMs);
+        stats.maxLatencyMs = std::max(stats.maxLatencyMs, latency);
+        stats.events++;
+        from->Pop();
+    }
+
+    for (uint32_t index = 0; index < channels.size(); ++index)
+    {
+        Channel &channel = channels[index];
+        // No event this tick and no release due: the value held the whole window
+        if (!channel.touched && channel.releaseTime == 0.0)
+        {
+            channel.average = channel.value;
+            continue;
+        }
+        Touch(index, tickStart);
+        Advance(channel, tickEnd);
+        channel.average = static_cast<float>(channel.integral / tickSeconds);
+    }
+    stats.dropped = devices->dropped.load(std::memory_order_relaxed);
+}
+
+float InputService::GetKey(int key) const
+{
+    return key >= 0 && key <= GLFW_KEY_LAST ? channels[key].average : 0.0f;
+}
+
+bool InputService::WasKeyPressed(int key) const
+{
+    return key >= 0 && key <= GLFW_KEY_LAST && channels[key].pressed;
+}
+
+float InputService::GetJoystickAxis(uint32_t axis) const
+{
+    return axis < MAX_AXES ? channels[KEY_CHANNELS + axis].average : 0.0f;
+}
+
+float InputService::GetJoystickButton(uint32_t button) const
+{
+    return button < MAX_BUTTONS ? channels[KEY_CHANNELS + MAX_AXES + button].average : 0.0f;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "SpscQueue.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Settings of the simulated device: a key pressed briefly at a fixed period,
+// sampled on its own thread, for measuring latency without hardware
+struct SimulatedInputSettings {
+    int key = GLFW_KEY_W;
+    float sampleRate = 1000.0f;
+    float period = 0.25f;
+    // Shorter than a fixed tick on purpose
+    float pressDuration = 0.004f;
+};
+
+// Timestamped input events, consumed once per fixed tick.
+//
+// Every device produces into its own SpscQueue: the keyboard from the GLFW key
+// callback, the joystick from a sample at the start of each tick (GLFW only allows
+// joystick calls on the main thread) and the simulated device from its own thread.
+// Each tick takes the events that happened during its time window, in timestamp
+// order, and integrates every control over the window: a key held for a third of the
+// tick reads 0.33. A key released sooner than MIN_PRESS_SECONDS after its press reads
+// as held that long, so a tap moves the car instead of vanishing in one tick.
+//
+// Free of the engine: the systems driving it are in InputSystems.hpp.
+class InputService
+{
+  public:
+    enum class EventType : uint16_t {
+        KEY,
+        JOYSTICK_AXIS,
+        JOYSTICK_BUTTON,
+    };
+
+    struct Event {
+        // Seconds on the steady clock, see Now
+        double time;
+        EventType type;
+        uint16_t code;
+        float value;
+    };
+
+    struct Stats {
+        uint32_t events = 0;
+        // Pushes rejected because a queue was full
+        uint32_t dropped = 0;
+        // From the event timestamp to the tick that consumed it, the maximum is since startup
+        float averageLatencyMs = 0.0f;
+        float maxLatencyMs = 0.0f;
+    };
+
+    static constexpr uint32_t QUEUE_CAPACITY = 1024;
+    static constexpr uint32_t MAX_AXES = 8;
+    static constexpr uint32_t MAX_BUTTONS = 32;
+    static constexpr double MIN_PRESS_SECONDS = 0.05;
+
+    InputService();
+
+    InputService(InputService &&) = default;
+    InputService &operator=(InputService &&) = default;
+
+    // Keyboard events from the GLFW callback of the current context's window. The
+    // callback that was installed before is still called. False without a window.
+    bool InstallKeyCallback();
+    // Pushes the joystick axes and buttons that changed since the last sample,
+    // timestamped at time
+    void SampleJoystick(int joystick, double time);
+    void StartSimulatedDevice(const SimulatedInputSettings &settings);
+
+    // Start of the window the next Consume of that length takes
+    double GetNextTickStart(double tickSeconds) const;
+    // Takes the events of the next tick of the given length
+    void Consume(double tickSeconds);
+
+    // Fraction of the last tick the key was held
+    float GetKey(int key) const;
+    // Whether the key went down during the last tick
+    bool WasKeyPressed(int key) const;
+    // Average over the last tick
+    float GetJoystickAxis(uint32_t axis) const;
+    float GetJoystickButton(uint32_t button) const;
+    inline uint32_t GetJoystickAxisCount() const { return joystickAxisCount; }
+    inline uint32_t GetJoystickButtonCount() const { return joystickButtonCount; }
+
+    inline const Stats &GetStats() const { return stats; }
+
+    static double Now();
+
+  private:
+    using Queue = SpscQueue<Event, QUEUE_CAPACITY>;
+
+    // Everything the producer threads touch, kept at a fixed address
+    struct Devices {
+        Queue keyboard;
+        Queue joystick;
+        Queue simulated;
+        std::atomic<uint32_t> dropped = 0;
+        std::atomic<bool> stop = false;
+        std::thread simulatedThread;
+
+        ~Devices();
+        void Push(Queue &queue, const Event &event);
+    };
+
+    struct Channel {
+        float value = 0.0f;
+        float average = 0.0f;
+        // Value integrated over the current tick, and the time it was integrated up to
+        double integral = 0.0;
+        double since = 0.0;
+        // Keys only: when the key last went down, and when a release that came
+        // before MIN_PRESS_SECONDS takes effect, 0 when none is pending
+        double pressTime = 0.0;
+        double releaseTime = 0.0;
+        bool touched = false;
+        bool pressed = false;
+    };
+
+    static void OnKey(GLFWwindow *window, int key, int scancode, int action, int mods);
+
+    uint32_t ChannelIndex(EventType type, uint16_t code) const;
+    // Starts integrating the channel over the current tick if it was not yet
+    void Touch(uint32_t index, double tickStart);
+    // Integrates the channel up to time, applying a pending release due by then
+    static void Advance(Channel &channel, double time);
+    const Event *PeekOldest(Queue *&from) const;
+
+    // The GLFW callback has no user pointer of its own to spare
+    inline static Devices *keyCallbackDevices = nullptr;
+    inline static GLFWkeyfun previousKeyCallback = nullptr;
+
+    std::unique_ptr<Devices> devices;
+    // Keys, then joystick axes, then joystick buttons
+    std::vector<Channel> channels;
+    std::vector<uint32_t> touched;
+    std::vector<float> joystickAxes;
+    std::vector<uint8_t> joystickButtons;
+    uint32_t joystickAxisCount = 0;
+    uint32_t joystickButtonCount = 0;
+    // End of the last consumed tick window, on the steady clock
+    double tickEnd = 0.0;
+    Stats stats;
+};
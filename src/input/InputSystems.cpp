@@ -0,0 +1,35 @@
+#include "InputSystems.hpp"
+
+#include "Logger.hpp"
+
+#include <cstdlib>
+#include <string_view>
+
+InputService CreateInputServiceFromEnvironment()
+{
+    InputService input;
+    if (const char *value = std::getenv("ES_INPUT"); value != nullptr && std::string_view(value) == "simulated")
+    {
+        const SimulatedInputSettings settings;
+        input.StartSimulatedDevice(settings);
+        ES::Utils::Log::Info(fmt::format("InputService: simulated device pressing key {} for {} ms every {} ms",
+                                         settings.key, settings.pressDuration * 1000.0f, settings.period * 1000.0f));
+    }
+    return input;
+}
+
+void InstallInputCallbacks(ES::Engine::Core &core)
+{
+    if (!core.GetResource<InputService>().InstallKeyCallback())
+        ES::Utils::Log::Warn("InputService: no current window, keyboard events are not captured");
+}
+
+void ConsumeInput(ES::Engine::Core &core)
+{
+    auto &input = core.GetResource<InputService>();
+    const double tickSeconds = core.GetScheduler<ES::Engine::Scheduler::FixedTimeUpdate>().GetTickRate();
+    // Frames and ticks are not in step: sampled here, the axes count from the start
+    // of the tick instead of whenever the last frame ran
+    input.SampleJoystick(0, input.GetNextTickStart(tickSeconds));
+    input.Consume(tickSeconds);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Engine.hpp"
+#include "InputService.hpp"
+
+// Reads ES_INPUT: "simulated" starts the simulated device
+InputService CreateInputServiceFromEnvironment();
+
+void InstallInputCallbacks(ES::Engine::Core &core);
+
+// Samples the joystick as of the start of the tick, then takes the tick's events
+void ConsumeInput(ES::Engine::Core &core);
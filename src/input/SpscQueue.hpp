@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Bounded single-producer single-consumer queue. The producer only writes tail and
+// the consumer only writes head, so neither side locks; a full queue rejects pushes.
+template <typename T, uint32_t Capacity> class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  public:
+    // Producer side
+    bool TryPush(const T &value)
+    {
+        const uint32_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        slots[tail & (Capacity - 1)] = value;
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: the oldest element, nullptr when empty. It stays valid until Pop.
+    const T *Peek() const
+    {
+        const uint32_t head = this->head.load(std::memory_order_relaxed);
+        if (head == tail.load(std::memory_order_acquire))
+            return nullptr;
+        return &slots[head & (Capacity - 1)];
+    }
+    void Pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  private:
+    std::array<T, Capacity> slots = {};
+    // Apart so the two sides do not share a cache line
+    alignas(64) std::atomic<uint32_t> head = 0;
+    alignas(64) std::atomic<uint32_t> tail = 0;
+};
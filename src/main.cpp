@@ -10,27 +10,164 @@
 
 // Demo headers
 #include "shader/LoadNoLightShader.hpp"
+#include "shader/LoadInstancedShader.hpp"
+#include "shader/LoadParticleShader.hpp"
+#include "shader/LoadSkidShader.hpp"
+#include "shader/LoadShadowShaders.hpp"
+#include "shader/LoadHudTextShader.hpp"
 #include "LoadMaterials.hpp"
 #include "CreateFloor.hpp"
 #include "CreateVehicle.hpp"
 #include "Game.hpp"
+#include "ai/AiDriver.hpp"
+#include "audio/EngineAudio.hpp"
+#include "font/FontAtlasCache.hpp"
+#include "font/HudText.hpp"
+#include "ghost/GhostKeys.hpp"
+#include "ghost/GhostPlayer.hpp"
+#include "ghost/GhostRecorder.hpp"
+#include "input/InputSystems.hpp"
+#include "memory/AllocationStats.hpp"
+#include "memory/LinearArena.hpp"
+#include "net/VehicleReplication.hpp"
+#include "perf/PerfOverlay.hpp"
+#include "perf/RenderBenchmark.hpp"
+#include "physics/PhysicsQueryService.hpp"
+#include "physics/PhysicsRewindKeys.hpp"
+#include "physics/PhysicsSnapshot.hpp"
+#include "physics/TransformSync.hpp"
+#include "physics/VehicleSimulationLod.hpp"
+#include "physics/WheelTesterBenchmark.hpp"
+#include "race/LapTiming.hpp"
+#include "render/FrameUniforms.hpp"
+#include "render/InstanceBatcher.hpp"
+#include "render/MeshBuffer.hpp"
+#include "render/ParticleSystem.hpp"
+#include "render/RenderCulling.hpp"
+#include "render/ShadowCascades.hpp"
+#include "render/SkidMarks.hpp"
+#include "task/ParallelSystems.hpp"
+#include "task/TaskScheduler.hpp"
 
 using namespace ES::Plugin;
 
 int main(void)
 {
+    // Before the window plugin initializes GLFW
+    ConfigureRenderBenchmarkPlatform();
+
     ES::Engine::Core core;
 
 	core.AddPlugins<Physics::Plugin, Input::Plugin, OpenGL::Plugin, Scene::Plugin>();
 
+    core.RegisterResource<TaskScheduler>(TaskScheduler());
+    core.RegisterResource<FrameArenas>(FrameArenas());
+    core.RegisterResource<AllocationStats>(AllocationStats());
+    core.RegisterResource<PerfOverlay>(CreatePerfOverlayFromEnvironment());
+    core.RegisterResource<RenderBenchmark>(CreateRenderBenchmarkFromEnvironment());
+    core.RegisterResource<FontAtlasCache>(FontAtlasCache());
+    core.RegisterResource<HudTextRenderer>(HudTextRenderer());
+    core.RegisterResource<InputService>(CreateInputServiceFromEnvironment());
+    core.RegisterResource<FrameUniforms>(FrameUniforms());
+    core.RegisterResource<MeshBuffer>(MeshBuffer());
+    core.RegisterResource<InstanceBatcher>(InstanceBatcher());
+    core.RegisterResource<RenderCulling>(RenderCulling());
+    core.RegisterResource<ShadowCascades>(ShadowCascades());
+    core.RegisterResource<ParticleSystem>(ParticleSystem());
+    core.RegisterResource<SkidMarks>(SkidMarks());
+    core.RegisterResource<TransformSync>(TransformSync());
+    core.RegisterResource<PhysicsSnapshotRing>(PhysicsSnapshotRing());
+    core.RegisterResource<VehicleSimulationLod>(VehicleSimulationLod());
+    core.RegisterResource<PhysicsQueryService>(PhysicsQueryService());
+    core.RegisterResource<AiDriverSystem>(CreateAiDriverSystemFromEnvironment());
+    core.RegisterResource<GhostRecorder>(GhostRecorder());
+    core.RegisterResource<GhostPlayer>(GhostPlayer());
+    core.RegisterResource<LapTiming>(LapTiming());
+    core.RegisterResource<EngineAudio>(CreateEngineAudioFromEnvironment());
+
     core.RegisterSystem<ES::Engine::Scheduler::Startup>(
         LoadMaterials,
-        LoadNoLightShader
+        LoadNoLightShader,
+        LoadInstancedShader,
+        LoadParticleShader,
+        LoadSkidShader,
+        LoadShadowShaders,
+        LoadHudTextShader,
+        InitFrameUniforms,
+        InitMeshBuffer,
+        InitInstanceBatcher,
+        InitRenderCulling,
+        InitShadowCascades,
+        InitParticleSystem,
+        InitSkidMarks,
+        InitPerfOverlay,
+        InitRenderBenchmark,
+        // Bakes the HUD atlas on first run only, later runs map the cached file
+        InitHudText,
+        InstallInputCallbacks
+    );
+
+    core.RegisterSystem<ES::Engine::Scheduler::Update>(
+        // Moves the camera along its path, then times culling and submission
+        BeginRenderBenchmarkFrame,
+        CountAllocations("UpdateFrameUniforms", UpdateFrameUniforms),
+        CountAllocations("PlayGhosts", PlayGhosts),
+        // Sets the light volume the shadow casters are culled against
+        CountAllocations("FitShadowCascades", FitShadowCascades),
+        CountAllocations("UpdateRenderCulling", UpdateRenderCulling),
+        // Everything that moved since the last frame has been refitted
+        ClearTransformDirty,
+        CountAllocations("RenderShadowCascades", RenderShadowCascades),
+        CountAllocations("RenderInstanceBatches", RenderInstanceBatches),
+        // Transparent, after the opaque geometry
+        CountAllocations("RenderSkidMarks", RenderSkidMarks),
+        CountAllocations("RenderParticles", RenderParticles),
+        EndRenderBenchmarkFrame,
+        // Over everything, and out of the benchmark image since the chrono changes every run
+        RenderHudText,
+        EndAllocationFrame,
+        // Reads every counter of the frame, allocations included
+        EndPerfFrame,
+        ResetFrameArena
     );
 
+    // Only read the physics state and the transforms, each one writes its own resource
+    ParallelSystems physicsReaders;
+    physicsReaders
+        // Casts requested during this tick, results are read on the next one
+        .Add("ExecutePhysicsQueries", ExecutePhysicsQueries,
+             ParallelSystems::Access().Read<Physics::Resource::PhysicsManager>().Write<PhysicsQueryService>())
+        .Add("CapturePhysicsSnapshot", CapturePhysicsSnapshot,
+             ParallelSystems::Access()
+                 .Read<Physics::Resource::PhysicsManager, Object::Component::Transform, SimulationLod>()
+                 .Write<PhysicsSnapshotRing>())
+        .Add("RecordGhost", RecordGhost,
+             ParallelSystems::Access().Read<Object::Component::Transform>().Write<GhostRecorder>())
+        .Add("UpdateEngineAudio", UpdateEngineAudio,
+             ParallelSystems::Access()
+                 .Read<Physics::Resource::PhysicsManager, OpenGL::Resource::Camera>()
+                 .Write<EngineAudio>());
+
     core.RegisterSystem<ES::Engine::Scheduler::FixedTimeUpdate>(
+        // First after the step, to time it
+        BeginPerfTick,
+        // The joystick sample and input events of this tick's window, before anything reads them
+        ConsumeInput,
+        CountAllocations("SyncActiveTransforms", SyncActiveTransforms),
+        // Gate crossings reported by the step that just ran
+        CountAllocations("UpdateLapTiming", UpdateLapTiming),
         // VehicleMovement
+        CountAllocations("UpdateAiDrivers", UpdateAiDrivers),
+        CountAllocations("UpdateVehicleSimulationLod", UpdateVehicleSimulationLod),
+        CountAllocations("PhysicsReaders", physicsReaders),
+        CountAllocations("UpdateParticles", UpdateParticles),
+        CountAllocations("UpdateSkidMarks", UpdateSkidMarks),
+        ResetTickArena
     );
+    core.RegisterSystem<ES::Engine::Scheduler::Update>(PhysicsRewindKeys(), GhostKeys(), PerfOverlayKeys());
+
+    RegisterReplicationFromEnvironment(core);
+    RegisterWheelTesterBenchmarkFromEnvironment(core);
 
     core.RegisterSystem<ES::Engine::Scheduler::Startup>(
 		[](ES::Engine::Core &c) {
@@ -51,15 +188,26 @@ int main(void)
         },
         [](ES::Engine::Core &c) {
             c.GetResource<OpenGL::Resource::DirectionalLight>().posOfLight = glm::vec3(3.0f, 20.0f, 0.0f);
-            c.GetResource<OpenGL::Resource::DirectionalLight>().lightProjection = glm::ortho(-50.0f, 50.0f, 50.0f, -50.0f, 1.0f, 50.0f);
+            // Only the direction matters, ShadowCascades fits the volume to the camera every frame
             c.GetResource<OpenGL::Resource::DirectionalLight>().lightView =
                 glm::lookAt(c.GetResource<OpenGL::Resource::DirectionalLight>().posOfLight,
                             glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-            c.GetResource<OpenGL::Resource::DirectionalLight>().lightSpaceMatrix = c.GetResource<OpenGL::Resource::DirectionalLight>().lightProjection * c.GetResource<OpenGL::Resource::DirectionalLight>().lightView;
         }
     );
 
     core.RunCore();
 
-    return 0;
+    // GL objects, mapped buffers and fences go in reverse init order, while the context still exists
+    if (glfwGetCurrentContext() != nullptr)
+    {
+        ShutdownHudText(core);
+        ShutdownSkidMarks(core);
+        ShutdownParticleSystem(core);
+        ShutdownShadowCascades(core);
+        ShutdownInstanceBatcher(core);
+        ShutdownMeshBuffer(core);
+        ShutdownFrameUniforms(core);
+    }
+
+    return core.GetResource<RenderBenchmark>().GetExitCode();
 }
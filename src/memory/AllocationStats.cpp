@@ -0,0 +1,117 @@
+#include "AllocationStats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> heapAllocations = 0;
+static std::atomic<uint64_t> jobWorkerHeapAllocations = 0;
+static thread_local uint64_t threadHeapAllocations = 0;
+static thread_local bool jobWorkerThread = false;
+
+static void *CountedAllocate(std::size_t size) noexcept
+{
+    threadHeapAllocations++;
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (jobWorkerThread)
+        jobWorkerHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void *operator new(std::size_t size)
+{
+    if (void *pointer = CountedAllocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    if (void *pointer = CountedAllocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return CountedAllocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return CountedAllocate(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+    std::free(pointer);
+}
+
+uint64_t AllocationStats::GetHeapAllocations()
+{
+    return heapAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationStats::GetThreadHeapAllocations()
+{
+    return threadHeapAllocations;
+}
+
+uint64_t AllocationStats::GetJobWorkerHeapAllocations()
+{
+    return jobWorkerHeapAllocations.load(std::memory_order_relaxed);
+}
+
+void AllocationStats::MarkJobWorkerThread()
+{
+    jobWorkerThread = true;
+}
+
+void AllocationStats::Record(const char *name, uint64_t allocations)
+{
+    auto it = std::find_if(systems.begin(), systems.end(), [name](const System &system) { return system.name == name; });
+    if (it == systems.end())
+        it = systems.insert(systems.end(), System{name});
+    it->last = allocations;
+    it->peak = std::max(it->peak, allocations);
+    it->total += allocations;
+    it->calls++;
+}
+
+void AllocationStats::EndFrame()
+{
+    const uint64_t now = GetHeapAllocations();
+    frameHeapAllocations = now - frameStart;
+    frameStart = now;
+}
+
+void EndAllocationFrame(ES::Engine::Core &core)
+{
+    core.GetResource<AllocationStats>().EndFrame();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Engine.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Heap allocations made through the global operator new, which this demo replaces to
+// count them. Aligned new is not counted.
+//
+// Systems wrapped with CountAllocations report what they allocated on the calling
+// thread plus what the TaskScheduler workers allocated meanwhile: systems run one at a
+// time and wait for their jobs, so the workers only run jobs of the wrapped system.
+// EndAllocationFrame closes the frame total. In the steady state both are expected to
+// stay at zero.
+class AllocationStats
+{
+  public:
+    struct System {
+        const char *name;
+        // Allocations made by the last call
+        uint64_t last = 0;
+        // Most allocations made by a single call
+        uint64_t peak = 0;
+        uint64_t total = 0;
+        uint64_t calls = 0;
+    };
+
+    static uint64_t GetHeapAllocations();
+    static uint64_t GetThreadHeapAllocations();
+    // Allocations made on the threads flagged with MarkJobWorkerThread
+    static uint64_t GetJobWorkerHeapAllocations();
+    // Called once by each job worker thread when it starts
+    static void MarkJobWorkerThread();
+
+    void Record(const char *name, uint64_t allocations);
+    void EndFrame();
+
+    inline const std::vector<System> &GetSystems() const { return systems; }
+    inline uint64_t GetFrameHeapAllocations() const { return frameHeapAllocations; }
+
+  private:
+    std::vector<System> systems;
+    uint64_t frameStart = 0;
+    uint64_t frameHeapAllocations = 0;
+};
+
+// Wraps a system so AllocationStats gets its heap allocation count on every call
+template <typename SystemT> auto CountAllocations(const char *name, SystemT system)
+{
+    return [name, system](ES::Engine::Core &core) {
+        const uint64_t before =
+            AllocationStats::GetThreadHeapAllocations() + AllocationStats::GetJobWorkerHeapAllocations();
+        system(core);
+        const uint64_t allocations = AllocationStats::GetThreadHeapAllocations() +
+                                     AllocationStats::GetJobWorkerHeapAllocations() - before;
+        core.GetResource<AllocationStats>().Record(name, allocations);
+    };
+}
+
+void EndAllocationFrame(ES::Engine::Core &core);
@@ -0,0 +1,98 @@
+#include "LinearArena.hpp"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+static std::size_t AlignUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+LinearArena::LinearArena(std::size_t capacity_) : buffer(std::make_unique<std::byte[]>(capacity_)), capacity(capacity_)
+{
+}
+
+LinearArena::~LinearArena()
+{
+    ReleaseOverflow();
+}
+
+LinearArena::LinearArena(LinearArena &&other) noexcept
+    : buffer(std::move(other.buffer)), capacity(std::exchange(other.capacity, 0)),
+      offset(std::exchange(other.offset, 0)), overflow(std::exchange(other.overflow, nullptr)), stats(other.stats)
+{
+}
+
+LinearArena &LinearArena::operator=(LinearArena &&other) noexcept
+{
+    if (this != &other)
+    {
+        ReleaseOverflow();
+        buffer = std::move(other.buffer);
+        capacity = std::exchange(other.capacity, 0);
+        offset = std::exchange(other.offset, 0);
+        overflow = std::exchange(other.overflow, nullptr);
+        stats = other.stats;
+    }
+    return *this;
+}
+
+void *LinearArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    stats.allocations++;
+    const auto base = reinterpret_cast<std::uintptr_t>(buffer.get());
+    const std::size_t start = AlignUp(base + offset, alignment) - base;
+    if (start + bytes <= capacity)
+    {
+        offset = start + bytes;
+        stats.used = std::max(stats.used, offset);
+        stats.peak = std::max(stats.peak, stats.used);
+        return buffer.get() + start;
+    }
+
+    // Out of room: a heap block that lives until the next Reset
+    stats.overflows++;
+    alignment = std::max(alignment, alignof(Overflow));
+    const std::size_t header = AlignUp(sizeof(Overflow), alignment);
+    auto *block = static_cast<std::byte *>(::operator new(header + bytes, std::align_val_t(alignment)));
+    overflow = new (block) Overflow{overflow, alignment};
+    stats.used += bytes;
+    stats.peak = std::max(stats.peak, stats.used);
+    return block + header;
+}
+
+void LinearArena::ReleaseOverflow()
+{
+    while (overflow != nullptr)
+    {
+        Overflow *next = overflow->next;
+        ::operator delete(overflow, std::align_val_t(overflow->alignment));
+        overflow = next;
+    }
+}
+
+void LinearArena::Reset()
+{
+    if (overflow != nullptr)
+    {
+        ReleaseOverflow();
+        // Room for the worst frame so far, with some margin
+        capacity = AlignUp(stats.peak + stats.peak / 2, alignof(std::max_align_t));
+        buffer = std::make_unique<std::byte[]>(capacity);
+    }
+    offset = 0;
+    stats.used = 0;
+    stats.allocations = 0;
+    stats.overflows = 0;
+}
+
+void ResetFrameArena(ES::Engine::Core &core)
+{
+    core.GetResource<FrameArenas>().frame.Reset();
+}
+
+void ResetTickArena(ES::Engine::Core &core)
+{
+    core.GetResource<FrameArenas>().tick.Reset();
+}
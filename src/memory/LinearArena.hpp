@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Engine.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for data that dies at the end of a frame or tick. Deallocation is a
+// no-op, Reset releases everything at once. When the buffer runs out, allocations
+// fall back to the heap and the next Reset grows the buffer to the peak, so only the
+// first frames of a heavier scene touch the heap.
+//
+// Not thread-safe: meant for the thread that runs the systems, not for job workers.
+class LinearArena : public std::pmr::memory_resource
+{
+  public:
+    struct Stats {
+        std::size_t used = 0;
+        std::size_t peak = 0;
+        uint32_t allocations = 0;
+        // Allocations the buffer could not hold since the last Reset
+        uint32_t overflows = 0;
+    };
+
+    explicit LinearArena(std::size_t capacity);
+    ~LinearArena() override;
+
+    LinearArena(LinearArena &&other) noexcept;
+    LinearArena &operator=(LinearArena &&other) noexcept;
+
+    void Reset();
+
+    inline std::size_t GetCapacity() const { return capacity; }
+    inline const Stats &GetStats() const { return stats; }
+
+  private:
+    // Header in front of each heap block taken on overflow
+    struct Overflow {
+        Overflow *next;
+        std::size_t alignment;
+    };
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    void ReleaseOverflow();
+
+    std::unique_ptr<std::byte[]> buffer;
+    std::size_t capacity = 0;
+    std::size_t offset = 0;
+    Overflow *overflow = nullptr;
+    Stats stats;
+};
+
+template <typename T> using ArenaVector = std::pmr::vector<T>;
+
+// One arena reset after each rendered frame, one after each fixed tick
+struct FrameArenas {
+    LinearArena frame = LinearArena(1024 * 1024);
+    LinearArena tick = LinearArena(256 * 1024);
+};
+
+void ResetFrameArena(ES::Engine::Core &core);
+void ResetTickArena(ES::Engine::Core &core);
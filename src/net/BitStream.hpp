@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bit-level writer over a caller-owned buffer. Writing past the end sets the
+// overflow flag instead of growing the buffer.
+class BitWriter {
+  public:
+    BitWriter(uint8_t *data, std::size_t capacity) : data(data), capacity(capacity) {}
+
+    void WriteBits(uint32_t value, uint32_t bits)
+    {
+        for (uint32_t i = 0; i < bits; ++i)
+        {
+            if (bitPosition >= capacity * 8)
+            {
+                overflow = true;
+                return;
+            }
+            std::size_t byte = bitPosition >> 3;
+            uint32_t shift = bitPosition & 7;
+            if (shift == 0)
+                data[byte] = 0;
+            data[byte] |= static_cast<uint8_t>(((value >> i) & 1u) << shift);
+            bitPosition++;
+        }
+    }
+
+    inline void WriteBool(bool value) { WriteBits(value ? 1u : 0u, 1); }
+
+    // Signed value, stored as two's complement truncated to the given width
+    inline void WriteSigned(int32_t value, uint32_t bits) { WriteBits(static_cast<uint32_t>(value), bits); }
+
+    inline std::size_t GetBitsWritten() const { return bitPosition; }
+    inline std::size_t GetBytesWritten() const { return (bitPosition + 7) >> 3; }
+    inline bool HasOverflowed() const { return overflow; }
+
+  private:
+    uint8_t *data;
+    std::size_t capacity;
+    std::size_t bitPosition = 0;
+    bool overflow = false;
+};
+
+// Bit-level reader mirroring BitWriter. Reading past the end returns zeros and
+// sets the overflow flag, so a truncated packet can be rejected after decoding.
+class BitReader {
+  public:
+    BitReader(const uint8_t *data, std::size_t size) : data(data), size(size) {}
+
+    uint32_t ReadBits(uint32_t bits)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits; ++i)
+        {
+            if (bitPosition >= size * 8)
+            {
+                overflow = true;
+                return 0;
+            }
+            uint32_t bit = (data[bitPosition >> 3] >> (bitPosition & 7)) & 1u;
+            value |= bit << i;
+            bitPosition++;
+        }
+        return value;
+    }
+
+    inline bool ReadBool() { return ReadBits(1) != 0; }
+
+    inline int32_t ReadSigned(uint32_t bits)
+    {
+        uint32_t value = ReadBits(bits);
+        if (bits < 32 && (value & (1u << (bits - 1))))
+            value |= ~((1u << bits) - 1);
+        return static_cast<int32_t>(value);
+    }
+
+    inline bool HasOverflowed() const { return overflow; }
+
+  private:
+    const uint8_t *data;
+    std::size_t size;
+    std::size_t bitPosition = 0;
+    bool overflow = false;
+};
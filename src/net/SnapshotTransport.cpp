@@ -0,0 +1,309 @@
+#include "SnapshotTransport.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+constexpr uint32_t PACKET_MAGIC = 0x4553; // "ES"
+constexpr uint32_t PACKET_MAGIC_BITS = 16;
+constexpr uint32_t PACKET_TYPE_BITS = 2;
+constexpr uint32_t SEQUENCE_BITS = 32;
+constexpr uint32_t SNAPSHOT_RATE_BITS = 16;
+// Fragment index and count minus one, a fragment holds at least one vehicle
+constexpr uint32_t FRAGMENT_BITS = 6;
+constexpr uint32_t VEHICLE_COUNT_BITS = 7;
+constexpr uint32_t NET_ID_BITS = 16;
+// Everything in a snapshot packet before its vehicles, with a baseline
+constexpr std::size_t SNAPSHOT_HEADER_BITS = PACKET_MAGIC_BITS + PACKET_TYPE_BITS + SEQUENCE_BITS +
+                                             SNAPSHOT_RATE_BITS + 2 * FRAGMENT_BITS + 1 + SEQUENCE_BITS +
+                                             VEHICLE_COUNT_BITS;
+
+static_assert(MAX_REPLICATED_VEHICLES <= (1u << FRAGMENT_BITS));
+static_assert(MAX_REPLICATED_VEHICLES < (1u << VEHICLE_COUNT_BITS));
+
+enum class PacketType : uint32_t {
+    Hello = 0,
+    Ack = 1,
+    Snapshot = 2,
+};
+
+static void WriteHeader(BitWriter &writer, PacketType type)
+{
+    writer.WriteBits(PACKET_MAGIC, PACKET_MAGIC_BITS);
+    writer.WriteBits(static_cast<uint32_t>(type), PACKET_TYPE_BITS);
+}
+
+static bool ReadHeader(BitReader &reader, PacketType &type)
+{
+    if (reader.ReadBits(PACKET_MAGIC_BITS) != PACKET_MAGIC)
+        return false;
+    type = static_cast<PacketType>(reader.ReadBits(PACKET_TYPE_BITS));
+    return !reader.HasOverflowed();
+}
+
+const QuantizedVehicleState *FindVehicle(const ReplicationSnapshot &snapshot, uint16_t netId)
+{
+    auto begin = snapshot.vehicles.begin();
+    auto end = begin + snapshot.vehicleCount;
+    auto it = std::lower_bound(begin, end, netId,
+                               [](const QuantizedVehicleState &state, uint16_t id) { return state.netId < id; });
+    return it != end && it->netId == netId ? &*it : nullptr;
+}
+
+static void WriteVehicle(BitWriter &writer, const QuantizedVehicleState &state, const ReplicationSnapshot *baseline)
+{
+    static const QuantizedVehicleState empty;
+    const QuantizedVehicleState *previous = baseline != nullptr ? FindVehicle(*baseline, state.netId) : nullptr;
+    writer.WriteBits(state.netId, NET_ID_BITS);
+    WriteVehicleDelta(writer, state, previous != nullptr ? *previous : empty);
+}
+
+static QuantizedVehicleState ReadVehicle(BitReader &reader, const ReplicationSnapshot *baseline)
+{
+    static const QuantizedVehicleState empty;
+    auto netId = static_cast<uint16_t>(reader.ReadBits(NET_ID_BITS));
+    const QuantizedVehicleState *previous = baseline != nullptr ? FindVehicle(*baseline, netId) : nullptr;
+    return ReadVehicleDelta(reader, netId, previous != nullptr ? *previous : empty);
+}
+
+bool SnapshotServer::Start(uint16_t port)
+{
+    return socket.Open(port);
+}
+
+void SnapshotServer::ReceiveAcks()
+{
+    uint8_t buffer[64];
+    NetAddress from;
+    std::size_t size;
+    while ((size = socket.ReceiveFrom(from, buffer, sizeof(buffer))) > 0)
+    {
+        BitReader reader(buffer, size);
+        PacketType type;
+        if (!ReadHeader(reader, type) || (type != PacketType::Hello && type != PacketType::Ack))
+            continue;
+        uint32_t acked = type == PacketType::Ack ? reader.ReadBits(SEQUENCE_BITS) : 0;
+        if (reader.HasOverflowed())
+            continue;
+
+        auto client = std::find_if(clients.begin(), clients.end(), [&from](const Client &c) { return c.address == from; });
+        if (client == clients.end())
+        {
+            clients.push_back(Client{from});
+            client = std::prev(clients.end());
+        }
+        // Acks can arrive out of order, only ever move the baseline forward
+        if (type == PacketType::Ack && (!client->hasAck || static_cast<int32_t>(acked - client->ackedSequence) > 0))
+        {
+            client->ackedSequence = acked;
+            client->hasAck = true;
+        }
+    }
+}
+
+ReplicationSnapshot &SnapshotServer::NextSnapshot()
+{
+    ReplicationSnapshot &snapshot = history[++sequence % REPLICATION_HISTORY];
+    snapshot.sequence = sequence;
+    snapshot.valid = false;
+    snapshot.vehicleCount = 0;
+    return snapshot;
+}
+
+void SnapshotServer::Send()
+{
+    ReplicationSnapshot &snapshot = history[sequence % REPLICATION_HISTORY];
+    snapshot.valid = true;
+    for (auto &client : clients)
+        SendTo(client, snapshot);
+}
+
+void SnapshotServer::SendTo(Client &client, const ReplicationSnapshot &snapshot)
+{
+    // Without a baseline still held in the history the client gets a full snapshot
+    const ReplicationSnapshot *baseline = nullptr;
+    if (client.hasAck)
+    {
+        const ReplicationSnapshot &candidate = history[client.ackedSequence % REPLICATION_HISTORY];
+        if (candidate.valid && candidate.sequence == client.ackedSequence)
+            baseline = &candidate;
+    }
+
+    // Deltas vary in size, measure them first to know where the fragments split
+    uint8_t buffer[REPLICATION_MAX_PACKET];
+    std::array<std::size_t, MAX_REPLICATED_VEHICLES> vehicleBits;
+    for (uint32_t i = 0; i < snapshot.vehicleCount; ++i)
+    {
+        BitWriter writer(buffer, sizeof(buffer));
+        WriteVehicle(writer, snapshot.vehicles[i], baseline);
+        vehicleBits[i] = writer.GetBitsWritten();
+    }
+
+    // Each fragment takes as many whole vehicles as fit, at least one
+    std::array<uint32_t, MAX_REPLICATED_VEHICLES + 1> fragmentStarts;
+    uint32_t fragmentCount = 0;
+    fragmentStarts[0] = 0;
+    std::size_t bits = SNAPSHOT_HEADER_BITS;
+    for (uint32_t i = 0; i < snapshot.vehicleCount; ++i)
+    {
+        if (bits + vehicleBits[i] > REPLICATION_MAX_PACKET * 8 && i > fragmentStarts[fragmentCount])
+        {
+            fragmentStarts[++fragmentCount] = i;
+            bits = SNAPSHOT_HEADER_BITS;
+        }
+        bits += vehicleBits[i];
+    }
+    fragmentStarts[++fragmentCount] = snapshot.vehicleCount;
+
+    for (uint32_t fragment = 0; fragment < fragmentCount; ++fragment)
+    {
+        BitWriter writer(buffer, sizeof(buffer));
+        WriteHeader(writer, PacketType::Snapshot);
+        writer.WriteBits(snapshot.sequence, SEQUENCE_BITS);
+        writer.WriteBits(snapshotRate, SNAPSHOT_RATE_BITS);
+        writer.WriteBits(fragment, FRAGMENT_BITS);
+        writer.WriteBits(fragmentCount - 1, FRAGMENT_BITS);
+        writer.WriteBool(baseline != nullptr);
+        if (baseline != nullptr)
+            writer.WriteBits(baseline->sequence, SEQUENCE_BITS);
+        writer.WriteBits(fragmentStarts[fragment + 1] - fragmentStarts[fragment], VEHICLE_COUNT_BITS);
+        for (uint32_t i = fragmentStarts[fragment]; i < fragmentStarts[fragment + 1]; ++i)
+            WriteVehicle(writer, snapshot.vehicles[i], baseline);
+
+        // Only a single vehicle larger than a packet could overflow
+        if (writer.HasOverflowed())
+            return;
+        if (socket.SendTo(client.address, buffer, writer.GetBytesWritten()))
+        {
+            bytesSent += writer.GetBytesWritten();
+            packetsSent++;
+        }
+    }
+}
+
+bool SnapshotClient::Connect(const std::string &host, uint16_t port)
+{
+    if (!NetAddress::Resolve(host, port, server) || !socket.Open())
+        return false;
+    SendAck();
+    return true;
+}
+
+void SnapshotClient::Receive()
+{
+    if (!socket.IsOpen())
+        return;
+
+    uint8_t buffer[REPLICATION_MAX_PACKET];
+    NetAddress from;
+    std::size_t size;
+    bool received = false;
+    while ((size = socket.ReceiveFrom(from, buffer, sizeof(buffer))) > 0)
+    {
+        if (!(from == server))
+            continue;
+        bytesReceived += size;
+        received |= Decode(buffer, size);
+    }
+
+    // Acknowledge the newest snapshot, or keep saying hello until the first one arrives
+    if (received || !hasSnapshot)
+        SendAck();
+}
+
+void SnapshotClient::SendAck()
+{
+    uint8_t buffer[8];
+    BitWriter writer(buffer, sizeof(buffer));
+    if (hasSnapshot)
+    {
+        WriteHeader(writer, PacketType::Ack);
+        writer.WriteBits(latestSequence, SEQUENCE_BITS);
+    }
+    else
+    {
+        WriteHeader(writer, PacketType::Hello);
+    }
+    socket.SendTo(server, buffer, writer.GetBytesWritten());
+}
+
+bool SnapshotClient::Decode(const uint8_t *data, std::size_t size)
+{
+    BitReader reader(data, size);
+    PacketType type;
+    if (!ReadHeader(reader, type) || type != PacketType::Snapshot)
+        return false;
+
+    uint32_t sequence = reader.ReadBits(SEQUENCE_BITS);
+    uint32_t rate = reader.ReadBits(SNAPSHOT_RATE_BITS);
+    uint32_t fragment = reader.ReadBits(FRAGMENT_BITS);
+    uint32_t fragmentCount = reader.ReadBits(FRAGMENT_BITS) + 1;
+    const ReplicationSnapshot *baseline = nullptr;
+    if (reader.ReadBool())
+    {
+        baseline = FindSnapshot(reader.ReadBits(SEQUENCE_BITS));
+        // The baseline fell out of our history, wait for the server to send a full snapshot
+        if (baseline == nullptr)
+            return false;
+    }
+    // Older than anything still useful for interpolation, or already complete
+    if (hasSnapshot && static_cast<int32_t>(sequence - latestSequence) <= -static_cast<int32_t>(REPLICATION_HISTORY))
+        return false;
+    if (FindSnapshot(sequence) != nullptr)
+        return false;
+
+    uint32_t vehicleCount = reader.ReadBits(VEHICLE_COUNT_BITS);
+    if (fragment >= fragmentCount || vehicleCount > MAX_REPLICATED_VEHICLES)
+        return false;
+    std::array<QuantizedVehicleState, MAX_REPLICATED_VEHICLES> vehicles;
+    for (uint32_t i = 0; i < vehicleCount; ++i)
+        vehicles[i] = ReadVehicle(reader, baseline);
+    if (reader.HasOverflowed())
+        return false;
+
+    PendingSnapshot &slot = pending[sequence % PENDING_SNAPSHOTS];
+    if (!slot.snapshot.valid || slot.snapshot.sequence != sequence)
+    {
+        slot.snapshot.sequence = sequence;
+        slot.snapshot.valid = true;
+        slot.snapshot.vehicleCount = 0;
+        slot.fragmentCount = fragmentCount;
+        slot.received = 0;
+    }
+    const uint64_t bit = uint64_t(1) << fragment;
+    if (slot.fragmentCount != fragmentCount || (slot.received & bit) != 0 ||
+        slot.snapshot.vehicleCount + vehicleCount > MAX_REPLICATED_VEHICLES)
+        return false;
+    std::copy_n(vehicles.begin(), vehicleCount, slot.snapshot.vehicles.begin() + slot.snapshot.vehicleCount);
+    slot.snapshot.vehicleCount += vehicleCount;
+    slot.received |= bit;
+    if (rate > 0)
+        snapshotRate = static_cast<float>(rate);
+
+    const uint64_t complete = fragmentCount == 64u ? ~uint64_t(0) : (uint64_t(1) << fragmentCount) - 1;
+    if (slot.received != complete)
+        return false;
+    Complete(slot);
+    return true;
+}
+
+void SnapshotClient::Complete(PendingSnapshot &slot)
+{
+    // Fragments arrive in any order
+    ReplicationSnapshot &snapshot = slot.snapshot;
+    std::sort(snapshot.vehicles.begin(), snapshot.vehicles.begin() + snapshot.vehicleCount,
+              [](const QuantizedVehicleState &a, const QuantizedVehicleState &b) { return a.netId < b.netId; });
+    history[snapshot.sequence % REPLICATION_HISTORY] = snapshot;
+    snapshot.valid = false;
+
+    if (!hasSnapshot || static_cast<int32_t>(snapshot.sequence - latestSequence) > 0)
+    {
+        latestSequence = snapshot.sequence;
+        hasSnapshot = true;
+    }
+}
+
+const ReplicationSnapshot *SnapshotClient::FindSnapshot(uint32_t sequence) const
+{
+    const ReplicationSnapshot &snapshot = history[sequence % REPLICATION_HISTORY];
+    return snapshot.valid && snapshot.sequence == sequence ? &snapshot : nullptr;
+}
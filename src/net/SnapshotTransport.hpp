@@ -0,0 +1,125 @@
+#pragma once
+
+#include "UdpSocket.hpp"
+#include "VehicleStateCodec.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr uint32_t MAX_REPLICATED_VEHICLES = 64;
+// Snapshots kept on each side to serve as delta baselines
+constexpr uint32_t REPLICATION_HISTORY = 64;
+// Keeps every datagram under a typical MTU, larger snapshots are split
+constexpr std::size_t REPLICATION_MAX_PACKET = 1200;
+
+struct ReplicationSnapshot {
+    uint32_t sequence = 0;
+    bool valid = false;
+    uint32_t vehicleCount = 0;
+    // Sorted by netId
+    std::array<QuantizedVehicleState, MAX_REPLICATED_VEHICLES> vehicles;
+};
+
+// Finds a vehicle by netId in a snapshot, nullptr when it is not in it
+const QuantizedVehicleState *FindVehicle(const ReplicationSnapshot &snapshot, uint16_t netId);
+
+// The network half of ReplicationServer, free of the engine.
+//
+// Sends each snapshot to every client as a delta against the last snapshot that
+// client acknowledged. A snapshot larger than REPLICATION_MAX_PACKET is split
+// between vehicles into fragments that decode on their own against the baseline.
+class SnapshotServer {
+  public:
+    explicit SnapshotServer(uint32_t snapshotRate = 60) : snapshotRate(snapshotRate) {}
+
+    SnapshotServer(SnapshotServer &&) = default;
+    SnapshotServer &operator=(SnapshotServer &&) = default;
+
+    // 0 picks an ephemeral port, see GetPort
+    bool Start(uint16_t port);
+    inline bool IsOpen() const { return socket.IsOpen(); }
+    inline uint16_t GetPort() const { return socket.GetPort(); }
+
+    // Registers new clients and moves their baselines forward
+    void ReceiveAcks();
+
+    // The history slot of the next snapshot, its sequence set: fill in the vehicles
+    // sorted by netId, then call Send
+    ReplicationSnapshot &NextSnapshot();
+    void Send();
+
+    // Clients in the order they first said hello
+    inline std::size_t GetClientCount() const { return clients.size(); }
+    inline const NetAddress &GetClientAddress(std::size_t index) const { return clients[index].address; }
+    // Newest snapshot the client acknowledged, 0 before its first
+    inline uint32_t GetAckedSequence(std::size_t index) const { return clients[index].ackedSequence; }
+    inline std::size_t GetBytesSent() const { return bytesSent; }
+    inline std::size_t GetPacketsSent() const { return packetsSent; }
+
+  private:
+    struct Client {
+        NetAddress address;
+        uint32_t ackedSequence = 0;
+        bool hasAck = false;
+    };
+
+    void SendTo(Client &client, const ReplicationSnapshot &snapshot);
+
+    UdpSocket socket;
+    uint32_t snapshotRate;
+    uint32_t sequence = 0;
+    std::vector<Client> clients;
+    std::vector<ReplicationSnapshot> history = std::vector<ReplicationSnapshot>(REPLICATION_HISTORY);
+    std::size_t bytesSent = 0;
+    std::size_t packetsSent = 0;
+};
+
+// The network half of ReplicationClient, free of the engine.
+//
+// Reassembles the fragments of each snapshot, keeps the complete ones as baselines
+// and acknowledges the newest. A snapshot missing a fragment is never acknowledged,
+// the server keeps sending deltas against an older one until a newer one completes.
+class SnapshotClient {
+  public:
+    SnapshotClient() = default;
+
+    SnapshotClient(SnapshotClient &&) = default;
+    SnapshotClient &operator=(SnapshotClient &&) = default;
+
+    bool Connect(const std::string &host, uint16_t port);
+    void Receive();
+
+    const ReplicationSnapshot *FindSnapshot(uint32_t sequence) const;
+
+    inline bool HasSnapshot() const { return hasSnapshot; }
+    inline uint32_t GetLatestSequence() const { return latestSequence; }
+    // Snapshots per second, as announced by the server
+    inline float GetSnapshotRate() const { return snapshotRate; }
+    inline std::size_t GetBytesReceived() const { return bytesReceived; }
+
+  private:
+    // Snapshots whose fragments are still arriving
+    static constexpr uint32_t PENDING_SNAPSHOTS = 4;
+
+    struct PendingSnapshot {
+        ReplicationSnapshot snapshot;
+        uint32_t fragmentCount = 0;
+        // One bit per fragment received
+        uint64_t received = 0;
+    };
+
+    bool Decode(const uint8_t *data, std::size_t size);
+    void Complete(PendingSnapshot &pending);
+    void SendAck();
+
+    UdpSocket socket;
+    NetAddress server;
+    float snapshotRate = 60.0f;
+    uint32_t latestSequence = 0;
+    bool hasSnapshot = false;
+    std::vector<ReplicationSnapshot> history = std::vector<ReplicationSnapshot>(REPLICATION_HISTORY);
+    std::vector<PendingSnapshot> pending = std::vector<PendingSnapshot>(PENDING_SNAPSHOTS);
+    std::size_t bytesReceived = 0;
+};
@@ -0,0 +1,173 @@
+#include "UdpSocket.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+#else
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+// Winsock must be initialized once before the first socket is created
+static bool InitSockets()
+{
+    static bool initialized = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return initialized;
+}
+#endif
+
+bool NetAddress::Resolve(const std::string &host, uint16_t port, NetAddress &out)
+{
+#ifdef _WIN32
+    if (!InitSockets())
+        return false;
+#endif
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo *result = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr)
+        return false;
+    auto *address = reinterpret_cast<sockaddr_in *>(result->ai_addr);
+    out.ip = ntohl(address->sin_addr.s_addr);
+    out.port = port;
+    freeaddrinfo(result);
+    return true;
+}
+
+std::string NetAddress::ToString() const
+{
+    return std::to_string((ip >> 24) & 0xFF) + "." + std::to_string((ip >> 16) & 0xFF) + "." +
+           std::to_string((ip >> 8) & 0xFF) + "." + std::to_string(ip & 0xFF) + ":" + std::to_string(port);
+}
+
+UdpSocket::~UdpSocket()
+{
+    Close();
+}
+
+UdpSocket::UdpSocket(UdpSocket &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+UdpSocket &UdpSocket::operator=(UdpSocket &&other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        std::swap(handle, other.handle);
+    }
+    return *this;
+}
+
+bool UdpSocket::Open(uint16_t port)
+{
+    Close();
+#ifdef _WIN32
+    if (!InitSockets())
+        return false;
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET)
+        return false;
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0)
+        return false;
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    handle = static_cast<intptr_t>(s);
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(s, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+uint16_t UdpSocket::GetPort() const
+{
+    if (handle == INVALID_HANDLE)
+        return 0;
+    sockaddr_in address = {};
+#ifdef _WIN32
+    int length = sizeof(address);
+    if (getsockname(static_cast<SOCKET>(handle), reinterpret_cast<sockaddr *>(&address), &length) != 0)
+        return 0;
+#else
+    socklen_t length = sizeof(address);
+    if (getsockname(static_cast<int>(handle), reinterpret_cast<sockaddr *>(&address), &length) != 0)
+        return 0;
+#endif
+    return ntohs(address.sin_port);
+}
+
+void UdpSocket::Close()
+{
+    if (handle == INVALID_HANDLE)
+        return;
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(handle));
+#else
+    close(static_cast<int>(handle));
+#endif
+    handle = INVALID_HANDLE;
+}
+
+bool UdpSocket::SendTo(const NetAddress &address, const uint8_t *data, std::size_t size)
+{
+    if (handle == INVALID_HANDLE)
+        return false;
+    sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = htonl(address.ip);
+    to.sin_port = htons(address.port);
+#ifdef _WIN32
+    int sent = sendto(static_cast<SOCKET>(handle), reinterpret_cast<const char *>(data), static_cast<int>(size), 0,
+                      reinterpret_cast<sockaddr *>(&to), sizeof(to));
+#else
+    auto sent = sendto(static_cast<int>(handle), data, size, 0, reinterpret_cast<sockaddr *>(&to), sizeof(to));
+#endif
+    return sent == static_cast<decltype(sent)>(size);
+}
+
+std::size_t UdpSocket::ReceiveFrom(NetAddress &address, uint8_t *data, std::size_t capacity)
+{
+    if (handle == INVALID_HANDLE)
+        return 0;
+    sockaddr_in from = {};
+#ifdef _WIN32
+    int fromLength = sizeof(from);
+    int received = recvfrom(static_cast<SOCKET>(handle), reinterpret_cast<char *>(data), static_cast<int>(capacity), 0,
+                            reinterpret_cast<sockaddr *>(&from), &fromLength);
+#else
+    socklen_t fromLength = sizeof(from);
+    auto received = recvfrom(static_cast<int>(handle), data, capacity, 0, reinterpret_cast<sockaddr *>(&from),
+                             &fromLength);
+#endif
+    if (received <= 0)
+        return 0;
+    address.ip = ntohl(from.sin_addr.s_addr);
+    address.port = ntohs(from.sin_port);
+    return static_cast<std::size_t>(received);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct NetAddress {
+    // IPv4 address and port, both in host byte order
+    uint32_t ip = 0;
+    uint16_t port = 0;
+
+    bool operator==(const NetAddress &other) const = default;
+
+    static bool Resolve(const std::string &host, uint16_t port, NetAddress &out);
+    std::string ToString() const;
+};
+
+// Non-blocking IPv4 UDP socket
+class UdpSocket {
+  public:
+    UdpSocket() = default;
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket &) = delete;
+    UdpSocket &operator=(const UdpSocket &) = delete;
+    UdpSocket(UdpSocket &&other) noexcept;
+    UdpSocket &operator=(UdpSocket &&other) noexcept;
+
+    // Binds to the given port on every interface, 0 picks an ephemeral port
+    bool Open(uint16_t port = 0);
+    void Close();
+    inline bool IsOpen() const { return handle != INVALID_HANDLE; }
+    // Port the socket is bound to, in host byte order, 0 when closed
+    uint16_t GetPort() const;
+
+    bool SendTo(const NetAddress &address, const uint8_t *data, std::size_t size);
+
+    // Returns the datagram size, or 0 when nothing is pending
+    std::size_t ReceiveFrom(NetAddress &address, uint8_t *data, std::size_t capacity);
+
+  private:
+    static constexpr intptr_t INVALID_HANDLE = -1;
+    intptr_t handle = INVALID_HANDLE;
+};
@@ -0,0 +1,258 @@
+#include "VehicleReplication.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "Object.hpp"
+#include "WheeledVehicle3D.hpp"
+#include "physics/JoltGlm.hpp"
+#include "physics/TransformSync.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+ReplicationServer::ReplicationServer(uint32_t sendInterval_, float tickRate)
+    : transport(static_cast<uint32_t>(std::lround(1.0f / (tickRate * sendInterval_)))), sendInterval(sendInterval_)
+{
+}
+
+bool ReplicationServer::Start(uint16_t port)
+{
+    if (!transport.Start(port))
+    {
+        ES::Utils::Log::Error(fmt::format("Replication server failed to bind UDP port {}", port));
+        return false;
+    }
+    ES::Utils::Log::Info(fmt::format("Replication server listening on UDP port {}", port));
+    return true;
+}
+
+void ReplicationServer::Update(ES::Engine::Core &core)
+{
+    if (!transport.IsOpen())
+        return;
+    transport.ReceiveAcks();
+    for (; knownClients < transport.GetClientCount(); ++knownClients)
+        ES::Utils::Log::Info(fmt::format("Replication client connected from {}",
+                                         transport.GetClientAddress(knownClients).ToString()));
+
+    if (tick++ % sendInterval != 0)
+        return;
+
+    Sample(core, transport.NextSnapshot());
+    transport.Send();
+}
+
+void ReplicationServer::Sample(ES::Engine::Core &core, ReplicationSnapshot &snapshot) const
+{
+    snapshot.vehicleCount = 0;
+    core.GetRegistry()
+        .view<ES::Plugin::Physics::Component::WheeledVehicle3D, ES::Plugin::Physics::Component::RigidBody3D>()
+        .each([&snapshot](entt::entity entity, auto &vehicle, auto &rigidBody) {
+            if (snapshot.vehicleCount >= MAX_REPLICATED_VEHICLES || rigidBody.body == nullptr ||
+                vehicle.vehicleConstraint == nullptr)
+                return;
+
+            VehicleState state;
+            state.position = ToGlm(rigidBody.body->GetPosition());
+            state.rotation = ToGlm(rigidBody.body->GetRotation());
+            state.linearVelocity = ToGlm(rigidBody.body->GetLinearVelocity());
+            state.angularVelocity = ToGlm(rigidBody.body->GetAngularVelocity());
+            for (uint32_t i = 0; i < REPLICATED_WHEEL_COUNT; ++i)
+            {
+                const JPH::Wheel *wheel = vehicle.vehicleConstraint->GetWheel(i);
+                state.wheelRotation[i] = wheel->GetRotationAngle();
+                state.wheelSteer[i] = wheel->GetSteerAngle();
+                state.suspensionLength[i] = wheel->GetSuspensionLength();
+            }
+
+            // The entity index is stable for the lifetime of the vehicle
+            auto netId = static_cast<uint16_t>(entt::to_entity(entity));
+            snapshot.vehicles[snapshot.vehicleCount++] = QuantizeVehicleState(netId, state);
+        });
+
+    std::sort(snapshot.vehicles.begin(), snapshot.vehicles.begin() + snapshot.vehicleCount,
+              [](const QuantizedVehicleState &a, const QuantizedVehicleState &b) { return a.netId < b.netId; });
+}
+
+bool ReplicationClient::Connect(const std::string &host, uint16_t port)
+{
+    if (!transport.Connect(host, port))
+    {
+        ES::Utils::Log::Error(fmt::format("Replication client failed to reach {}:{}", host, port));
+        return false;
+    }
+    ES::Utils::Log::Info(fmt::format("Replication client connecting to {}:{}", host, port));
+    return true;
+}
+
+void ReplicationClient::Receive()
+{
+    transport.Receive();
+}
+
+static float LerpAngle(float from, float to, float t)
+{
+    float delta = std::remainder(to - from, 2.0f * glm::pi<float>());
+    return from + delta * t;
+}
+
+static VehicleState InterpolateVehicle(const VehicleState &a, const VehicleState &b, float t)
+{
+    VehicleState state;
+    state.position = glm::mix(a.position, b.position, t);
+    state.rotation = glm::slerp(a.rotation, b.rotation, t);
+    state.linearVelocity = glm::mix(a.linearVelocity, b.linearVelocity, t);
+    state.angularVelocity = glm::mix(a.angularVelocity, b.angularVelocity, t);
+    for (uint32_t i = 0; i < REPLICATED_WHEEL_COUNT; ++i)
+    {
+        state.wheelRotation[i] = LerpAngle(a.wheelRotation[i], b.wheelRotation[i], t);
+        state.wheelSteer[i] = glm::mix(a.wheelSteer[i], b.wheelSteer[i], t);
+        state.suspensionLength[i] = glm::mix(a.suspensionLength[i], b.suspensionLength[i], t);
+    }
+    return state;
+}
+
+void ReplicationClient::Interpolate(ES::Engine::Core &core, float deltaTime)
+{
+    if (!transport.HasSnapshot())
+        return;
+    const uint32_t latestSequence = transport.GetLatestSequence();
+    if (!playing)
+    {
+        renderSequence = static_cast<double>(latestSequence) - interpolationDelay;
+        playing = true;
+    }
+
+    // Play back at the server rate, nudged so the delay behind the newest snapshot stays constant
+    const double target = static_cast<double>(latestSequence) - interpolationDelay;
+    const double error = target - renderSequence;
+    if (std::abs(error) > interpolationDelay * 4.0)
+        renderSequence = target;
+    else
+        renderSequence += deltaTime * transport.GetSnapshotRate() * (1.0 + std::clamp(error * 0.1, -0.1, 0.1));
+    renderSequence = std::min(renderSequence, static_cast<double>(latestSequence));
+
+    // Bracketing snapshots, skipping over lost ones
+    const auto floorSequence = static_cast<uint32_t>(std::floor(renderSequence));
+    const ReplicationSnapshot *from = nullptr;
+    const ReplicationSnapshot *to = nullptr;
+    for (uint32_t back = 0; back < REPLICATION_HISTORY && from == nullptr; ++back)
+        from = transport.FindSnapshot(floorSequence - back);
+    for (uint32_t sequence = floorSequence + 1; static_cast<int32_t>(latestSequence - sequence) >= 0 && to == nullptr;
+         ++sequence)
+        to = transport.FindSnapshot(sequence);
+    if (from == nullptr)
+        return;
+    if (to == nullptr)
+        to = from;
+
+    const double span = static_cast<double>(to->sequence - from->sequence);
+    const float t = span > 0.0 ? static_cast<float>(std::clamp((renderSequence - from->sequence) / span, 0.0, 1.0))
+                               : 1.0f;
+
+    for (uint32_t i = 0; i < to->vehicleCount; ++i)
+    {
+        const QuantizedVehicleState &target = to->vehicles[i];
+        const QuantizedVehicleState *previous = FindVehicle(*from, target.netId);
+        VehicleState state = DequantizeVehicleState(target);
+        if (previous != nullptr)
+            state = InterpolateVehicle(DequantizeVehicleState(*previous), state, t);
+
+        auto visual = visuals.find(target.netId);
+        if (visual == visuals.end())
+            visual = visuals.emplace(target.netId, CreateVehicleVisual(core)).first;
+        PoseVehicleVisual(core, visual->second, state);
+    }
+
+    // Vehicles the server no longer sends
+    for (auto it = visuals.begin(); it != visuals.end();)
+    {
+        if (FindVehicle(*to, it->first) != nullptr)
+        {
+            ++it;
+            continue;
+        }
+        it->second.body.Destroy(core);
+        for (auto &wheel : it->second.wheels)
+            wheel.Destroy(core);
+        it = visuals.erase(it);
+    }
+}
+
+void PoseVehicleVisual(ES::Engine::Core &core, const VehicleVisual &visual, const VehicleState &state)
+{
+    using ES::Plugin::Object::Component::Transform;
+
+    auto &transformSync = core.GetResource<TransformSync>();
+    auto &bodyTransform = visual.body.GetComponents<Transform>(core);
+    bodyTransform.position = state.position;
+    bodyTransform.rotation = state.rotation;
+    transformSync.MarkDirty(visual.body);
+
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+    for (uint32_t i = 0; i < REPLICATED_WHEEL_COUNT; ++i)
+    {
+        // Wheels hang below their attachment point along the body's down axis
+        glm::vec3 local = VEHICLE_WHEEL_OFFSETS[i] - up * state.suspensionLength[i];
+        auto &wheelTransform = visual.wheels[i].GetComponents<Transform>(core);
+        wheelTransform.position = state.position + state.rotation * local;
+        wheelTransform.rotation = state.rotation * glm::angleAxis(state.wheelSteer[i], up) *
+                                  glm::angleAxis(state.wheelRotation[i], glm::vec3(1.0f, 0.0f, 0.0f));
+        transformSync.MarkDirty(visual.wheels[i]);
+    }
+}
+
+void UpdateReplicationServer(ES::Engine::Core &core)
+{
+    core.GetResource<ReplicationServer>().Update(core);
+}
+
+void UpdateReplicationClient(ES::Engine::Core &core)
+{
+    auto &client = core.GetResource<ReplicationClient>();
+    client.Receive();
+    client.Interpolate(core, core.GetScheduler<ES::Engine::Scheduler::Update>().GetDeltaTime());
+}
+
+void RegisterReplicationFromEnvironment(ES::Engine::Core &core)
+{
+    const char *setting = std::getenv("ES_REPLICATION");
+    if (setting == nullptr)
+        return;
+
+    // "server:PORT" or "client:HOST:PORT"
+    const std::string value(setting);
+    const std::size_t portSeparator = value.rfind(':');
+    const std::size_t modeSeparator = value.find(':');
+    if (portSeparator == std::string::npos)
+    {
+        ES::Utils::Log::Warn(fmt::format("Ignoring malformed ES_REPLICATION value \"{}\"", value));
+        return;
+    }
+    const auto port = static_cast<uint16_t>(std::strtoul(value.c_str() + portSeparator + 1, nullptr, 10));
+    const std::string mode = value.substr(0, modeSeparator);
+
+    if (mode == "server")
+    {
+        ReplicationServer server;
+        if (!server.Start(port))
+            return;
+        core.RegisterResource<ReplicationServer>(std::move(server));
+        core.RegisterSystem<ES::Engine::Scheduler::FixedTimeUpdate>(UpdateReplicationServer);
+    }
+    else if (mode == "client" && portSeparator > modeSeparator)
+    {
+        ReplicationClient client;
+        if (!client.Connect(value.substr(modeSeparator + 1, portSeparator - modeSeparator - 1), port))
+            return;
+        core.RegisterResource<ReplicationClient>(std::move(client));
+        core.RegisterSystem<ES::Engine::Scheduler::Update>(UpdateReplicationClient);
+    }
+    else
+    {
+        ES::Utils::Log::Warn(fmt::format("Ignoring malformed ES_REPLICATION value \"{}\"", value));
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Core.hpp"
+#include "CreateVehicle.hpp"
+#include "SnapshotTransport.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Samples every WheeledVehicle3D every sendInterval fixed ticks and sends it to each
+// client through a SnapshotServer.
+class ReplicationServer {
+  public:
+    explicit ReplicationServer(uint32_t sendInterval = 4, float tickRate = 1.0f / 240.0f);
+
+    ReplicationServer(ReplicationServer &&) = default;
+    ReplicationServer &operator=(ReplicationServer &&) = default;
+
+    bool Start(uint16_t port);
+    void Update(ES::Engine::Core &core);
+
+    inline std::size_t GetBytesSent() const { return transport.GetBytesSent(); }
+
+  private:
+    void Sample(ES::Engine::Core &core, ReplicationSnapshot &snapshot) const;
+
+    SnapshotServer transport;
+    uint32_t sendInterval;
+    uint32_t tick = 0;
+    std::size_t knownClients = 0;
+};
+
+// Receives snapshots, acknowledges them and drives one VehicleVisual per remote
+// vehicle, interpolating between buffered snapshots interpolationDelay snapshots
+// behind the newest one so that late or lost packets do not show as stutter.
+class ReplicationClient {
+  public:
+    explicit ReplicationClient(float interpolationDelay = 3.0f) : interpolationDelay(interpolationDelay) {}
+
+    ReplicationClient(ReplicationClient &&) = default;
+    ReplicationClient &operator=(ReplicationClient &&) = default;
+
+    bool Connect(const std::string &host, uint16_t port);
+    void Receive();
+    void Interpolate(ES::Engine::Core &core, float deltaTime);
+
+    inline uint32_t GetLatestSequence() const { return transport.GetLatestSequence(); }
+    inline std::size_t GetBytesReceived() const { return transport.GetBytesReceived(); }
+
+  private:
+    SnapshotClient transport;
+    float interpolationDelay;
+    double renderSequence = 0.0;
+    bool playing = false;
+    std::unordered_map<uint16_t, VehicleVisual> visuals;
+};
+
+// Places a VehicleVisual from a replicated state
+void PoseVehicleVisual(ES::Engine::Core &core, const VehicleVisual &visual, const VehicleState &state);
+
+void UpdateReplicationServer(ES::Engine::Core &core);
+
+void UpdateReplicationClient(ES::Engine::Core &core);
+
+// Reads ES_REPLICATION ("server:PORT" or "client:HOST:PORT") and registers the
+// matching resource and system, does nothing when the variable is unset
+void RegisterReplicationFromEnvironment(ES::Engine::Core &core);
@@ -0,0 +1,197 @@
+#include "VehicleStateCodec.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Grid steps of each field
+constexpr float POSITION_STEP = 1.0f / 1024.0f;      // ~1 mm
+constexpr float VELOCITY_STEP = 1.0f / 100.0f;       // 1 cm/s, 0.01 rad/s
+constexpr float WHEEL_ANGLE_STEP = 1.0f / 1000.0f;   // 1 mrad
+constexpr float SUSPENSION_STEP = 1.0f / 1000.0f;    // 1 mm
+constexpr uint32_t WHEEL_ROTATION_STEPS = 4096;      // per revolution
+constexpr float ROTATION_COMPONENT_MAX = 0.70710678f; // 1 / sqrt(2)
+constexpr int32_t ROTATION_COMPONENT_RANGE = 32767;
+
+// Full width of each field, used when a delta is too large to be sent as small
+constexpr uint32_t POSITION_BITS = 32;
+constexpr uint32_t ROTATION_BITS = 16;
+constexpr uint32_t VELOCITY_BITS = 20;
+constexpr uint32_t WHEEL_ROTATION_BITS = 13;
+constexpr uint32_t WHEEL_ANGLE_BITS = 12;
+constexpr uint32_t SUSPENSION_BITS = 12;
+
+constexpr uint32_t SMALL_DELTA_BITS = 8;
+constexpr int32_t SMALL_DELTA_LIMIT = 1 << (SMALL_DELTA_BITS - 1);
+
+static int32_t Quantize(float value, float step, uint32_t bits)
+{
+    const int32_t limit = bits >= 32 ? INT32_MAX : (1 << (bits - 1)) - 1;
+    const double scaled = std::round(static_cast<double>(value) / step);
+    return static_cast<int32_t>(std::clamp(scaled, static_cast<double>(-limit), static_cast<double>(limit)));
+}
+
+QuantizedVehicleState QuantizeVehicleState(uint16_t netId, const VehicleState &state)
+{
+    QuantizedVehicleState q;
+    q.netId = netId;
+    for (int i = 0; i < 3; ++i)
+    {
+        q.position[i] = Quantize(state.position[i], POSITION_STEP, POSITION_BITS);
+        q.linearVelocity[i] = Quantize(state.linearVelocity[i], VELOCITY_STEP, VELOCITY_BITS);
+        q.angularVelocity[i] = Quantize(state.angularVelocity[i], VELOCITY_STEP, VELOCITY_BITS);
+    }
+
+    // Smallest three: drop the largest component, it is rebuilt from the unit length
+    glm::quat rotation = glm::normalize(state.rotation);
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; ++i)
+    {
+        if (std::abs(rotation[i]) > std::abs(rotation[largest]))
+            largest = i;
+    }
+    const float sign = rotation[largest] < 0.0f ? -1.0f : 1.0f;
+    q.rotationLargest = largest;
+    for (uint32_t i = 0, j = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float component = sign * rotation[i] / ROTATION_COMPONENT_MAX;
+        q.rotation[j++] = static_cast<int32_t>(
+            std::round(std::clamp(component, -1.0f, 1.0f) * ROTATION_COMPONENT_RANGE));
+    }
+
+    for (uint32_t i = 0; i < REPLICATED_WHEEL_COUNT; ++i)
+    {
+        float turns = state.wheelRotation[i] / (2.0f * glm::pi<float>());
+        turns -= std::floor(turns);
+        q.wheelRotation[i] = static_cast<int32_t>(turns * WHEEL_ROTATION_STEPS) % WHEEL_ROTATION_STEPS;
+        q.wheelSteer[i] = Quantize(state.wheelSteer[i], WHEEL_ANGLE_STEP, WHEEL_ANGLE_BITS);
+        q.suspensionLength[i] = Quantize(state.suspensionLength[i], SUSPENSION_STEP, SUSPENSION_BITS);
+    }
+    return q;
+}
+
+VehicleState DequantizeVehicleState(const QuantizedVehicleState &q)
+{
+    VehicleState state;
+    for (int i = 0; i < 3; ++i)
+    {
+        state.position[i] = q.position[i] * POSITION_STEP;
+        state.linearVelocity[i] = q.linearVelocity[i] * VELOCITY_STEP;
+        state.angularVelocity[i] = q.angularVelocity[i] * VELOCITY_STEP;
+    }
+
+    float sumSquares = 0.0f;
+    for (uint32_t i = 0, j = 0; i < 4; ++i)
+    {
+        if (i == q.rotationLargest)
+            continue;
+        float component = static_cast<float>(q.rotation[j++]) / ROTATION_COMPONENT_RANGE * ROTATION_COMPONENT_MAX;
+        state.rotation[i] = component;
+        sumSquares += component * component;
+    }
+    state.rotation[q.rotationLargest] = std::sqrt(std::max(0.0f, 1.0f - sumSquares));
+    state.rotation = glm::normalize(state.rotation);
+
+    for (uint32_t i = 0; i < REPLICATED_WHEEL_COUNT; ++i)
+    {
+        state.wheelRotation[i] = static_cast<float>(q.wheelRotation[i]) / WHEEL_ROTATION_STEPS * 2.0f * glm::pi<float>();
+        state.wheelSteer[i] = q.wheelSteer[i] * WHEEL_ANGLE_STEP;
+        state.suspensionLength[i] = q.suspensionLength[i] * SUSPENSION_STEP;
+    }
+    return state;
+}
+
+static void WriteField(BitWriter &writer, int32_t value, int32_t baseline, uint32_t fullBits)
+{
+    const int64_t delta = static_cast<int64_t>(value) - baseline;
+    if (delta == 0)
+    {
+        writer.WriteBool(false);
+        return;
+    }
+    writer.WriteBool(true);
+    if (delta >= -SMALL_DELTA_LIMIT && delta < SMALL_DELTA_LIMIT)
+    {
+        writer.WriteBool(true);
+        writer.WriteSigned(static_cast<int32_t>(delta), SMALL_DELTA_BITS);
+    }
+    else
+    {
+        writer.WriteBool(false);
+        writer.WriteSigned(value, fullBits);
+    }
+}
+
+static int32_t ReadField(BitReader &reader, int32_t baseline, uint32_t fullBits)
+{
+    if (!reader.ReadBool())
+        return baseline;
+    if (reader.ReadBool())
+        return static_cast<int32_t>(static_cast<int64_t>(baseline) + reader.ReadSigned(SMALL_DELTA_BITS));
+    return reader.ReadSigned(fullBits);
+}
+
+template <std::size_t N>
+static void WriteFields(BitWriter &writer, const std::array<int32_t, N> &values, const std::array<int32_t, N> &baseline,
+                        uint32_t fullBits)
+{
+    for (std::size_t i = 0; i < N; ++i)
+        WriteField(writer, values[i], baseline[i], fullBits);
+}
+
+template <std::size_t N>
+static void ReadFields(BitReader &reader, std::array<int32_t, N> &values, const std::array<int32_t, N> &baseline,
+                       uint32_t fullBits)
+{
+    for (std::size_t i = 0; i < N; ++i)
+        values[i] = ReadField(reader, baseline[i], fullBits);
+}
+
+void WriteVehicleDelta(BitWriter &writer, const QuantizedVehicleState &state, const QuantizedVehicleState &baseline)
+{
+    QuantizedVehicleState comparable = baseline;
+    comparable.netId = state.netId;
+    if (state == comparable)
+    {
+        writer.WriteBool(false);
+        return;
+    }
+    writer.WriteBool(true);
+
+    WriteFields(writer, state.position, baseline.position, POSITION_BITS);
+    writer.WriteBits(state.rotationLargest, 2);
+    // Components are only comparable when the same one was dropped
+    const auto &rotationBaseline = state.rotationLargest == baseline.rotationLargest
+                                       ? baseline.rotation
+                                       : std::array<int32_t, 3>{};
+    WriteFields(writer, state.rotation, rotationBaseline, ROTATION_BITS);
+    WriteFields(writer, state.linearVelocity, baseline.linearVelocity, VELOCITY_BITS);
+    WriteFields(writer, state.angularVelocity, baseline.angularVelocity, VELOCITY_BITS);
+    WriteFields(writer, state.wheelRotation, baseline.wheelRotation, WHEEL_ROTATION_BITS);
+    WriteFields(writer, state.wheelSteer, baseline.wheelSteer, WHEEL_ANGLE_BITS);
+    WriteFields(writer, state.suspensionLength, baseline.suspensionLength, SUSPENSION_BITS);
+}
+
+QuantizedVehicleState ReadVehicleDelta(BitReader &reader, uint16_t netId, const QuantizedVehicleState &baseline)
+{
+    QuantizedVehicleState state = baseline;
+    state.netId = netId;
+    if (!reader.ReadBool())
+        return state;
+
+    ReadFields(reader, state.position, baseline.position, POSITION_BITS);
+    state.rotationLargest = reader.ReadBits(2);
+    const auto rotationBaseline = state.rotationLargest == baseline.rotationLargest
+                                      ? baseline.rotation
+                                      : std::array<int32_t, 3>{};
+    ReadFields(reader, state.rotation, rotationBaseline, ROTATION_BITS);
+    ReadFields(reader, state.linearVelocity, baseline.linearVelocity, VELOCITY_BITS);
+    ReadFields(reader, state.angularVelocity, baseline.angularVelocity, VELOCITY_BITS);
+    ReadFields(reader, state.wheelRotation, baseline.wheelRotation, WHEEL_ROTATION_BITS);
+    ReadFields(reader, state.wheelSteer, baseline.wheelSteer, WHEEL_ANGLE_BITS);
+    ReadFields(reader, state.suspensionLength, baseline.suspensionLength, SUSPENSION_BITS);
+    return state;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "BitStream.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <array>
+#include <cstdint>
+
+constexpr uint32_t REPLICATED_WHEEL_COUNT = 4;
+
+// Vehicle state as sampled from the simulation
+struct VehicleState {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 linearVelocity = glm::vec3(0.0f);
+    glm::vec3 angularVelocity = glm::vec3(0.0f);
+    std::array<float, REPLICATED_WHEEL_COUNT> wheelRotation = {};
+    std::array<float, REPLICATED_WHEEL_COUNT> wheelSteer = {};
+    std::array<float, REPLICATED_WHEEL_COUNT> suspensionLength = {};
+};
+
+// Vehicle state on the network grid. Deltas are computed on these integers, so the
+// server and the client agree bit for bit on every baseline.
+struct QuantizedVehicleState {
+    uint16_t netId = 0;
+    std::array<int32_t, 3> position = {};
+    // Smallest-three quaternion: index of the dropped component and the other three
+    uint32_t rotationLargest = 3;
+    std::array<int32_t, 3> rotation = {};
+    std::array<int32_t, 3> linearVelocity = {};
+    std::array<int32_t, 3> angularVelocity = {};
+    std::array<int32_t, REPLICATED_WHEEL_COUNT> wheelRotation = {};
+    std::array<int32_t, REPLICATED_WHEEL_COUNT> wheelSteer = {};
+    std::array<int32_t, REPLICATED_WHEEL_COUNT> suspensionLength = {};
+
+    bool operator==(const QuantizedVehicleState &other) const = default;
+};
+
+QuantizedVehicleState QuantizeVehicleState(uint16_t netId, const VehicleState &state);
+
+VehicleState DequantizeVehicleState(const QuantizedVehicleState &state);
+
+// Writes state as a delta against baseline. An unchanged vehicle costs one bit, small
+// changes cost 10 bits per field, large ones fall back to the full quantized value.
+void WriteVehicleDelta(BitWriter &writer, const QuantizedVehicleState &state, const QuantizedVehicleState &baseline);
+
+QuantizedVehicleState ReadVehicleDelta(BitReader &reader, uint16_t netId, const QuantizedVehicleState &baseline);
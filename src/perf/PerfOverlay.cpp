@@ -0,0 +1,248 @@
+#include "PerfOverlay.hpp"
+
+#include "Engine.pch.hpp"
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "font/HudText.hpp"
+#include "memory/AllocationStats.hpp"
+#include "physics/TransformSync.hpp"
+#include "render/InstanceBatcher.hpp"
+#include "render/MeshBuffer.hpp"
+#include "render/ParticleSystem.hpp"
+#include "render/ShadowCascades.hpp"
+#include "render/SkidMarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+
+constexpr float LINE_HEIGHT = 24.0f;
+constexpr float TEXT_SCALE = 0.5f;
+// Above the chrono
+constexpr float TEXT_BOTTOM = 50.0f;
+
+PerfOverlay::Export::~Export()
+{
+    if (file == nullptr)
+        return;
+    if (json)
+        fmt::print(file, "\n]\n");
+    std::fclose(file);
+}
+
+void PerfOverlay::StepListener::OnStep(const JPH::PhysicsStepListenerContext &)
+{
+    // Only the first collision step of an update marks its start
+    int64_t expected = 0;
+    stepStart.compare_exchange_strong(expected, Now(), std::memory_order_relaxed);
+}
+
+PerfOverlay::PerfOverlay() : listener(std::make_unique<StepListener>())
+{
+    window.resize(WINDOW);
+    sorted.reserve(WINDOW);
+    frameHistogram.edges = {1000.0f / 120.0f, 1000.0f / 60.0f, 1000.0f / 30.0f};
+    physicsHistogram.edges = {1.0f, 2.0f, 4.0f};
+}
+
+int64_t PerfOverlay::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void PerfOverlay::Init(ES::Engine::Core &core)
+{
+    core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem().AddStepListener(
+        listener.get());
+}
+
+bool PerfOverlay::OpenExport(const std::string &path)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    auto opened = std::make_unique<Export>();
+    opened->file = std::fopen(path.c_str(), "w");
+    if (opened->file == nullptr)
+    {
+        ES::Utils::Log::Warn(fmt::format("PerfOverlay: cannot write {}", path));
+        return false;
+    }
+    opened->json = std::filesystem::path(path).extension() == ".json";
+    if (opened->json)
+        fmt::print(opened->file, "[");
+    else
+        fmt::print(opened->file, "frame,frame_ms,ticks,physics_ms,active_bodies,draw_calls,triangles,allocations\n");
+    output = std::move(opened);
+    ES::Utils::Log::Info(fmt::format("PerfOverlay: writing frame counters to {}", path));
+    return true;
+}
+
+void PerfOverlay::BeginTick()
+{
+    const int64_t start = listener->stepStart.exchange(0, std::memory_order_relaxed);
+    if (start != 0)
+        current.physicsMs += static_cast<float>(Now() - start) / 1e6f;
+    current.ticks++;
+}
+
+void PerfOverlay::UpdateHistogram(Histogram &histogram, float Sample::*counter)
+{
+    const auto count = static_cast<uint32_t>(std::min<uint64_t>(frame, WINDOW));
+    sorted.clear();
+    histogram.counts = {};
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const float value = window[i].*counter;
+        sorted.push_back(value);
+        const auto bucket = std::upper_bound(histogram.edges.begin(), histogram.edges.end(), value);
+        histogram.counts[std::distance(histogram.edges.begin(), bucket)]++;
+    }
+    if (sorted.empty())
+        return;
+    const auto p99 = sorted.begin() + (sorted.size() - 1) * 99 / 100;
+    std::nth_element(sorted.begin(), p99, sorted.end());
+    histogram.p99 = *p99;
+    histogram.max = *std::max_element(p99, sorted.end());
+}
+
+void PerfOverlay::Write(const Sample &sample)
+{
+    if (output == nullptr)
+        return;
+    if (output->json)
+        fmt::print(output->file,
+                   "{}\n{{\"frame\":{},\"frameMs\":{:.3f},\"ticks\":{},\"physicsMs\":{:.3f},\"activeBodies\":{},"
+                   "\"drawCalls\":{},\"triangles\":{},\"allocations\":{}}}",
+                   frame == 0 ? "" : ",", frame, sample.frameMs, sample.ticks, sample.physicsMs, sample.activeBodies,
+                   sample.drawCalls, sample.triangles, sample.allocations);
+    else
+        fmt::print(output->file, "{},{:.3f},{},{:.3f},{},{},{},{}\n", frame, sample.frameMs, sample.ticks,
+                   sample.physicsMs, sample.activeBodies, sample.drawCalls, sample.triangles, sample.allocations);
+}
+
+void PerfOverlay::EndFrame(ES::Engine::Core &core)
+{
+    const auto &batches = core.GetResource<InstanceBatcher>().GetStats();
+    const auto &particles = core.GetResource<ParticleSystem>().GetStats();
+    const auto &skidMarks = core.GetResource<SkidMarks>().GetStats();
+
+    current.frameMs = core.GetScheduler<ES::Engine::Scheduler::Update>().GetDeltaTime() * 1000.0f;
+    current.activeBodies = core.GetResource<TransformSync>().GetStats().activeBodies;
+    const auto &shadows = core.GetResource<ShadowCascades>().GetStats();
+    // Skid marks are a single multi-draw, particles a quad each
+    current.drawCalls = batches.drawCalls + shadows.drawCalls + particles.drawCalls + (skidMarks.quads > 0 ? 1 : 0);
+    current.triangles = batches.triangles + shadows.triangles + 2ull * skidMarks.quads;
+    for (uint32_t alive : particles.alive)
+        current.triangles += 2ull * alive;
+    current.allocations = core.GetResource<AllocationStats>().GetFrameHeapAllocations();
+
+    Write(current);
+    window[frame % WINDOW] = current;
+    frame++;
+    current = Sample();
+
+    UpdateHistogram(frameHistogram, &Sample::frameMs);
+    UpdateHistogram(physicsHistogram, &Sample::physicsMs);
+    UpdateText(core);
+
+    if (frameLimit != 0 && frame == frameLimit)
+    {
+        ES::Utils::Log::Info(fmt::format("PerfOverlay: {} frames sampled, closing", frame));
+        output.reset();
+        glfwSetWindowShouldClose(glfwGetCurrentContext(), GLFW_TRUE);
+    }
+}
+
+void PerfOverlay::CreateText(ES::Engine::Core &core) const
+{
+    for (uint32_t line = 0; line < LINES; ++line)
+    {
+        auto text = ES::Engine::Entity::Create(core);
+        text.AddComponent<HudText>(
+            core, HudText{"", glm::vec2(10.0f, TEXT_BOTTOM + LINE_HEIGHT * static_cast<float>(LINES - 1 - line)),
+                          TEXT_SCALE, glm::vec3(1.0f)});
+        text.AddComponent<PerfOverlayLine>(core, line);
+    }
+}
+
+static void FormatHistogram(std::string &text, const PerfOverlay::Histogram &histogram, const char *unit)
+{
+    fmt::format_to(std::back_inserter(text), "    ");
+    for (uint32_t bucket = 0; bucket < PerfOverlay::BUCKETS - 1; ++bucket)
+        fmt::format_to(std::back_inserter(text), "<{:.1f}{}: {}   ", histogram.edges[bucket], unit,
+                       histogram.counts[bucket]);
+    fmt::format_to(std::back_inserter(text), "slower: {}", histogram.counts[PerfOverlay::BUCKETS - 1]);
+}
+
+void PerfOverlay::UpdateText(ES::Engine::Core &core)
+{
+    const Sample &last = GetLast();
+    const auto geometry = core.GetResource<MeshBuffer>().GetStats();
+    core.GetRegistry()
+        .view<HudText, PerfOverlayLine>()
+        .each([this, &last, &geometry](auto, auto &text, auto &line) {
+            // Formatted in place, like the chrono
+            text.text.clear();
+            if (!visible)
+                return;
+            auto out = std::back_inserter(text.text);
+            switch (line.line)
+            {
+            case 0:
+                fmt::format_to(out, "Frame {:.2f} ms   p99 {:.2f}   max {:.2f}   ticks {}", last.frameMs,
+                               frameHistogram.p99, frameHistogram.max, last.ticks);
+                break;
+            case 1: FormatHistogram(text.text, frameHistogram, "ms"); break;
+            case 2:
+                fmt::format_to(out, "Physics {:.2f} ms   p99 {:.2f}   max {:.2f}   active bodies {}", last.physicsMs,
+                               physicsHistogram.p99, physicsHistogram.max, last.activeBodies);
+                break;
+            case 3: FormatHistogram(text.text, physicsHistogram, "ms"); break;
+            case 4:
+                fmt::format_to(out, "Draws {}   triangles {}   allocations {}", last.drawCalls, last.triangles,
+                               last.allocations);
+                break;
+            case 5:
+                fmt::format_to(out, "Meshes {}   vertices {}/{}   indices {}/{}   free ranges {}   fragmentation {:.0f}%",
+                               geometry.meshes, geometry.vertexUsed, geometry.vertexCapacity, geometry.indexUsed,
+                               geometry.indexCapacity, geometry.freeRanges, geometry.fragmentation * 100.0f);
+                break;
+            }
+        });
+}
+
+PerfOverlay CreatePerfOverlayFromEnvironment()
+{
+    PerfOverlay overlay;
+    if (const char *value = std::getenv("ES_PERF_EXPORT"))
+        overlay.OpenExport(value);
+    if (const char *value = std::getenv("ES_PERF_FRAMES"))
+        overlay.SetFrameLimit(std::strtoull(value, nullptr, 10));
+    return overlay;
+}
+
+void InitPerfOverlay(ES::Engine::Core &core)
+{
+    core.GetResource<PerfOverlay>().Init(core);
+}
+
+void BeginPerfTick(ES::Engine::Core &core)
+{
+    core.GetResource<PerfOverlay>().BeginTick();
+}
+
+void EndPerfFrame(ES::Engine::Core &core)
+{
+    core.GetResource<PerfOverlay>().EndFrame(core);
+}
+
+void PerfOverlayKeys::operator()(ES::Engine::Core &core) const
+{
+    bool togglePressed = ES::Plugin::Input::Utils::IsKeyPressed(toggleKey);
+    if (togglePressed && !toggleWasPressed)
+        core.GetResource<PerfOverlay>().ToggleVisible();
+    toggleWasPressed = togglePressed;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Engine.hpp"
+
+#include "Input.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/PhysicsStepListener.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Marks the entities holding the overlay's text lines
+struct PerfOverlayLine {
+    uint32_t line;
+};
+
+// Frame counters on screen, and in a file for runs nobody watches.
+//
+// Every frame gathers one Sample from the stats the other resources already keep.
+// The physics step runs inside the engine's physics system, so it is timed from a
+// Jolt step listener, called when the step starts, to the first demo system of the
+// tick, which runs right after it. The last WINDOW samples are kept for the rolling
+// histograms.
+class PerfOverlay
+{
+  public:
+    struct Sample {
+        float frameMs = 0.0f;
+        uint32_t ticks = 0;
+        // Summed over the ticks of the frame
+        float physicsMs = 0.0f;
+        uint32_t activeBodies = 0;
+        uint32_t drawCalls = 0;
+        uint64_t triangles = 0;
+        uint64_t allocations = 0;
+    };
+
+    static constexpr uint32_t WINDOW = 240;
+    static constexpr uint32_t BUCKETS = 4;
+    static constexpr uint32_t LINES = 6;
+
+    // Distribution of one counter over the window; bucket i holds the values below
+    // edges[i], the last one everything above
+    struct Histogram {
+        std::array<float, BUCKETS - 1> edges;
+        std::array<uint32_t, BUCKETS> counts = {};
+        float p99 = 0.0f;
+        float max = 0.0f;
+    };
+
+    PerfOverlay();
+
+    PerfOverlay(PerfOverlay &&) = default;
+    PerfOverlay &operator=(PerfOverlay &&) = default;
+
+    // Hooks the step listener
+    void Init(ES::Engine::Core &core);
+    // Writes every sample to path: JSON when it ends in .json, CSV otherwise
+    bool OpenExport(const std::string &path);
+    // Closes the window once that many frames have been sampled, 0 never does
+    inline void SetFrameLimit(uint64_t frames) { frameLimit = frames; }
+
+    // At the start of each fixed tick, once the step is over
+    void BeginTick();
+    // At the end of the frame, after the allocation count is closed
+    void EndFrame(ES::Engine::Core &core);
+
+    // Creates the text lines in the current scene
+    void CreateText(ES::Engine::Core &core) const;
+    void UpdateText(ES::Engine::Core &core);
+
+    inline void ToggleVisible() { visible = !visible; }
+    inline bool IsVisible() const { return visible; }
+    inline const Sample &GetLast() const { return window[(frame + WINDOW - 1) % WINDOW]; }
+    inline const Histogram &GetFrameHistogram() const { return frameHistogram; }
+    inline const Histogram &GetPhysicsHistogram() const { return physicsHistogram; }
+
+  private:
+    // Called on a physics thread
+    class StepListener final : public JPH::PhysicsStepListener
+    {
+      public:
+        void OnStep(const JPH::PhysicsStepListenerContext &context) override;
+
+        // Steady clock nanoseconds of the first step since the last tick, 0 when none
+        std::atomic<int64_t> stepStart = 0;
+    };
+
+    struct Export {
+        std::FILE *file = nullptr;
+        bool json = false;
+
+        ~Export();
+    };
+
+    static int64_t Now();
+
+    void UpdateHistogram(Histogram &histogram, float Sample::*counter);
+    void Write(const Sample &sample);
+
+    std::unique_ptr<StepListener> listener;
+    std::unique_ptr<Export> output;
+    std::vector<Sample> window;
+    // Sorted copy of one counter, for the percentile
+    std::vector<float> sorted;
+    Histogram frameHistogram;
+    Histogram physicsHistogram;
+    Sample current;
+    uint64_t frame = 0;
+    uint64_t frameLimit = 0;
+    bool visible = true;
+};
+
+// Reads ES_PERF_EXPORT, the path samples are written to, and ES_PERF_FRAMES, the
+// number of frames to run before closing
+PerfOverlay CreatePerfOverlayFromEnvironment();
+
+void InitPerfOverlay(ES::Engine::Core &core);
+
+void BeginPerfTick(ES::Engine::Core &core);
+
+void EndPerfFrame(ES::Engine::Core &core);
+
+// Shows or hides the overlay
+class PerfOverlayKeys
+{
+  public:
+    void operator()(ES::Engine::Core &core) const;
+
+  private:
+    int toggleKey = GLFW_KEY_F3;
+    mutable bool toggleWasPressed = false;
+};
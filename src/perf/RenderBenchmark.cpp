@@ -0,0 +1,347 @@
+#include "RenderBenchmark.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "ai/AiDriver.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+
+constexpr float MIN_ORBIT_RADIUS = 20.0f;
+constexpr float ORBIT_HEIGHT = 0.5f;
+
+static int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static float Median(std::vector<float> values)
+{
+    if (values.empty())
+        return 0.0f;
+    const auto middle = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+void RenderBenchmark::Enable(const Settings &newSettings)
+{
+    settings = newSettings;
+    enabled = true;
+    frames.reserve(settings.frames);
+    queryFrames.fill(UINT32_MAX);
+}
+
+void RenderBenchmark::Init(ES::Engine::Core &core)
+{
+    if (!enabled)
+        return;
+    core.GetResource<AiDriverSystem>().GetSettings().parked = true;
+    glGenQueries(QUERY_FRAMES, queries.data());
+    ES::Utils::Log::Info(fmt::format("RenderBenchmark: {} frames after {} warmup frames on {}", settings.frames,
+                                     settings.warmupFrames,
+                                     reinterpret_cast<const char *>(glGetString(GL_RENDERER))));
+}
+
+void RenderBenchmark::PlaceCamera(ES::Engine::Core &core, uint32_t measured) const
+{
+    const float angle = 2.0f * glm::pi<float>() * static_cast<float>(measured) / static_cast<float>(settings.frames);
+    auto &camera = core.GetResource<ES::Plugin::OpenGL::Resource::Camera>();
+    camera.viewer.centerAt(glm::vec3(0.0f, 0.0f, 0.0f));
+    camera.viewer.lookFrom(
+        glm::vec3(std::cos(angle) * orbitRadius, orbitRadius * ORBIT_HEIGHT, std::sin(angle) * orbitRadius));
+}
+
+void RenderBenchmark::CollectQueries(bool wait)
+{
+    for (uint32_t slot = 0; slot < QUERY_FRAMES; ++slot)
+    {
+        if (queryFrames[slot] == UINT32_MAX)
+            continue;
+        GLuint available = GL_FALSE;
+        if (!wait)
+            glGetQueryObjectuiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!wait && available == GL_FALSE)
+            continue;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+        frames[queryFrames[slot]].gpuMs = static_cast<float>(elapsed) / 1e6f;
+        queryFrames[slot] = UINT32_MAX;
+    }
+}
+
+void RenderBenchmark::BeginFrame(ES::Engine::Core &core)
+{
+    if (!enabled || finished)
+        return;
+    // The line only exists once the scene is up, warmup covers it
+    orbitRadius = std::max(MIN_ORBIT_RADIUS, core.GetResource<AiDriverSystem>().GetLine().GetExtent() * 1.5f);
+
+    if (!measuring && frame >= settings.warmupFrames)
+    {
+        const bool resting = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>()
+                                 .GetPhysicsSystem()
+                                 .GetNumActiveBodies(JPH::EBodyType::RigidBody) == 0;
+        if (resting || frame >= settings.maxWarmupFrames)
+        {
+            measuring = true;
+            if (!resting)
+                ES::Utils::Log::Warn(fmt::format("RenderBenchmark: bodies still moving after {} frames, the frame "
+                                                 "hashes may not match",
+                                                 frame));
+        }
+    }
+
+    const auto measured = static_cast<uint32_t>(frames.size());
+    PlaceCamera(core, measured);
+    if (!measuring)
+        return;
+
+    // Results come back a few frames late, only a full ring waits for one
+    CollectQueries(false);
+    const uint32_t slot = measured % QUERY_FRAMES;
+    if (queryFrames[slot] != UINT32_MAX)
+        CollectQueries(true);
+    queryFrames[slot] = measured;
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+    cpuStart = NowNs();
+}
+
+RenderBenchmark::FrameHash RenderBenchmark::HashFramebuffer()
+{
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const auto width = static_cast<uint32_t>(std::max(viewport[2], 1));
+    const auto height = static_cast<uint32_t>(std::max(viewport[3], 1));
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(viewport[0], viewport[1], width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    std::array<float, HASH_GRID * HASH_GRID> cells = {};
+    std::array<uint32_t, HASH_GRID * HASH_GRID> counts = {};
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint32_t row = y * HASH_GRID / height * HASH_GRID;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint8_t *pixel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            const uint32_t cell = row + x * HASH_GRID / width;
+            cells[cell] += 0.2126f * pixel[0] + 0.7152f * pixel[1] + 0.0722f * pixel[2];
+            counts[cell]++;
+        }
+    }
+    float mean = 0.0f;
+    for (uint32_t cell = 0; cell < cells.size(); ++cell)
+    {
+        cells[cell] /= static_cast<float>(std::max(counts[cell], 1u));
+        mean += cells[cell] / static_cast<float>(cells.size());
+    }
+
+    FrameHash hash = {};
+    for (uint32_t cell = 0; cell < cells.size(); ++cell)
+    {
+        if (cells[cell] > mean)
+            hash[cell / 64] |= uint64_t(1) << (cell % 64);
+    }
+    return hash;
+}
+
+void RenderBenchmark::EndFrame()
+{
+    if (!enabled || finished)
+        return;
+    if (!measuring)
+    {
+        frame++;
+        return;
+    }
+
+    Frame result;
+    result.cpuMs = static_cast<float>(NowNs() - cpuStart) / 1e6f;
+    glEndQuery(GL_TIME_ELAPSED);
+    // After the timed span: the read back waits for the GPU
+    result.hash = HashFramebuffer();
+    frames.push_back(result);
+
+    if (frames.size() == settings.frames)
+        Finish();
+}
+
+bool RenderBenchmark::Compare(const std::vector<Frame> &baseline) const
+{
+    const size_t count = std::min(frames.size(), baseline.size());
+    std::vector<float> cpu;
+    std::vector<float> gpu;
+    std::vector<float> baselineCpu;
+    std::vector<float> baselineGpu;
+    uint32_t mismatches = 0;
+    uint32_t worstDistance = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        cpu.push_back(frames[i].cpuMs);
+        baselineCpu.push_back(baseline[i].cpuMs);
+        if (frames[i].gpuMs >= 0.0f && baseline[i].gpuMs >= 0.0f)
+        {
+            gpu.push_back(frames[i].gpuMs);
+            baselineGpu.push_back(baseline[i].gpuMs);
+        }
+        uint32_t distance = 0;
+        for (size_t word = 0; word < frames[i].hash.size(); ++word)
+            distance += std::popcount(frames[i].hash[word] ^ baseline[i].hash[word]);
+        worstDistance = std::max(worstDistance, distance);
+        if (distance > settings.hashTolerance)
+            mismatches++;
+    }
+
+    bool passed = true;
+    const auto check = [&passed, this](const char *name, float value, float reference) {
+        const float change = reference > 0.0f ? value / reference - 1.0f : 0.0f;
+        const bool ok = change <= settings.timeTolerance;
+        passed = passed && ok;
+        ES::Utils::Log::Info(fmt::format("RenderBenchmark: median {} {:.3f} ms, baseline {:.3f} ms ({:+.1f}%){}",
+                                         name, value, reference, change * 100.0f, ok ? "" : " REGRESSION"));
+    };
+    check("CPU submission", Median(cpu), Median(baselineCpu));
+    check("GPU", Median(gpu), Median(baselineGpu));
+
+    const auto allowed = static_cast<uint32_t>(settings.mismatchBudget * static_cast<float>(count));
+    const bool imagesOk = mismatches <= allowed;
+    passed = passed && imagesOk;
+    ES::Utils::Log::Info(fmt::format("RenderBenchmark: {} of {} frames differ by more than {} bits (worst {}, {} "
+                                     "allowed){}",
+                                     mismatches, count, settings.hashTolerance, worstDistance, allowed,
+                                     imagesOk ? "" : " REGRESSION"));
+    if (frames.size() != baseline.size())
+        ES::Utils::Log::Warn(fmt::format("RenderBenchmark: {} frames against a baseline of {}, compared the first {}",
+                                         frames.size(), baseline.size(), count));
+    return passed;
+}
+
+void RenderBenchmark::Finish()
+{
+    finished = true;
+    CollectQueries(true);
+    glDeleteQueries(QUERY_FRAMES, queries.data());
+    WriteCsv(settings.resultPath, frames);
+
+    std::vector<Frame> baseline;
+    if (!ReadCsv(settings.baselinePath, baseline))
+    {
+        ES::Utils::Log::Error(fmt::format("RenderBenchmark: no baseline at {}. Review {} and commit it there to make "
+                                          "this run the baseline.",
+                                          settings.baselinePath, settings.resultPath));
+        exitCode = 1;
+    }
+    else if (!Compare(baseline))
+    {
+        exitCode = 1;
+    }
+    ES::Utils::Log::Info(fmt::format("RenderBenchmark: {}", exitCode == 0 ? "passed" : "failed"));
+    glfwSetWindowShouldClose(glfwGetCurrentContext(), GLFW_TRUE);
+}
+
+bool RenderBenchmark::WriteCsv(const std::string &path, const std::vector<Frame> &frames)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        ES::Utils::Log::Warn(fmt::format("RenderBenchmark: cannot write {}", path));
+        return false;
+    }
+    file << "frame,cpu_ms,gpu_ms,hash\n";
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        file << fmt::format("{},{:.4f},{:.4f},", i, frames[i].cpuMs, frames[i].gpuMs);
+        for (uint64_t word : frames[i].hash)
+            file << fmt::format("{:016x}", word);
+        file << '\n';
+    }
+    return true;
+}
+
+bool RenderBenchmark::ReadCsv(const std::string &path, std::vector<Frame> &frames)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string index;
+        std::string cpu;
+        std::string gpu;
+        std::string hash;
+        if (!std::getline(fields, index, ',') || !std::getline(fields, cpu, ',') || !std::getline(fields, gpu, ',') ||
+            !std::getline(fields, hash) || hash.size() != std::tuple_size_v<FrameHash> * 16)
+        {
+            ES::Utils::Log::Warn(fmt::format("RenderBenchmark: malformed baseline line \"{}\" in {}", line, path));
+            return false;
+        }
+        Frame frame;
+        frame.cpuMs = std::strtof(cpu.c_str(), nullptr);
+        frame.gpuMs = std::strtof(gpu.c_str(), nullptr);
+        for (size_t word = 0; word < frame.hash.size(); ++word)
+            frame.hash[word] = std::strtoull(hash.substr(word * 16, 16).c_str(), nullptr, 16);
+        frames.push_back(frame);
+    }
+    return !frames.empty();
+}
+
+void ConfigureRenderBenchmarkPlatform()
+{
+    if (std::getenv("ES_RENDER_BENCHMARK") == nullptr)
+        return;
+    if (const char *value = std::getenv("ES_RENDER_BENCHMARK_OFFSCREEN"); value != nullptr && std::string_view(value) == "0")
+        return;
+    // The null platform creates its contexts with OSMesa, which Mesa runs on llvmpipe
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+}
+
+RenderBenchmark CreateRenderBenchmarkFromEnvironment()
+{
+    RenderBenchmark benchmark;
+    const char *value = std::getenv("ES_RENDER_BENCHMARK");
+    if (value == nullptr)
+        return benchmark;
+
+    RenderBenchmark::Settings settings;
+    if (std::string_view(value) != "1")
+        settings.baselinePath = value;
+    if (const char *frames = std::getenv("ES_RENDER_BENCHMARK_FRAMES"))
+        settings.frames = std::max(1, std::atoi(frames));
+    if (const char *tolerance = std::getenv("ES_RENDER_BENCHMARK_TOLERANCE"))
+        settings.timeTolerance = std::strtof(tolerance, nullptr);
+    benchmark.Enable(settings);
+    return benchmark;
+}
+
+void InitRenderBenchmark(ES::Engine::Core &core)
+{
+    core.GetResource<RenderBenchmark>().Init(core);
+}
+
+void BeginRenderBenchmarkFrame(ES::Engine::Core &core)
+{
+    core.GetResource<RenderBenchmark>().BeginFrame(core);
+}
+
+void EndRenderBenchmarkFrame(ES::Engine::Core &core)
+{
+    core.GetResource<RenderBenchmark>().EndFrame();
+}
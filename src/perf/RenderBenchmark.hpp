@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Core.hpp"
+#include "OpenGL.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Renders the game scene along a fixed camera path and checks it against a stored
+// baseline, so rendering changes get a performance and regression check without a
+// person watching a window.
+//
+// Each measured frame records the CPU time spent culling and submitting the demo's
+// draws, the GPU time of the same span from a timer query read back a few frames
+// later, and a hash of the finished frame. The hash is an average hash over a
+// HASH_GRID x HASH_GRID grid of luma cells, so driver-level rasterization differences
+// stay below hashTolerance bits while a broken shader or a missing batch flips many.
+// The run passes when the median times stay within the tolerance of the baseline and
+// few enough frames are farther from their baseline hash than hashTolerance bits. A
+// missing baseline fails the run: the result file is the candidate to review and
+// commit as the baseline.
+//
+// The fixed ticks follow the wall clock, so each frame runs a varying number of them.
+// To keep the images reproducible the AI cars stay parked, no ghost plays, and
+// measuring starts once every body is at rest: from there a frame only depends on
+// the camera, which follows the frame index.
+class RenderBenchmark
+{
+  public:
+    static constexpr uint32_t HASH_GRID = 16;
+    static constexpr uint32_t QUERY_FRAMES = 4;
+
+    using FrameHash = std::array<uint64_t, HASH_GRID * HASH_GRID / 64>;
+
+    struct Settings {
+        std::string baselinePath = "asset/benchmark/render_baseline.csv";
+        std::string resultPath = "cache/benchmark/render.csv";
+        // Frames rendered before measuring, while shaders compile and the cars settle.
+        // Warmup goes on until every body sleeps, up to maxWarmupFrames.
+        uint32_t warmupFrames = 120;
+        uint32_t maxWarmupFrames = 2400;
+        // One turn of the camera around the track
+        uint32_t frames = 600;
+        // Allowed slowdown of the median times, as a fraction of the baseline
+        float timeTolerance = 0.15f;
+        uint32_t hashTolerance = 12;
+        // Fraction of the frames allowed to differ more than hashTolerance
+        float mismatchBudget = 0.05f;
+    };
+
+    struct Frame {
+        float cpuMs = 0.0f;
+        // Negative until the query result came back
+        float gpuMs = -1.0f;
+        FrameHash hash = {};
+    };
+
+    RenderBenchmark() = default;
+    RenderBenchmark(RenderBenchmark &&) = default;
+    RenderBenchmark &operator=(RenderBenchmark &&) = default;
+
+    void Enable(const Settings &settings);
+    inline bool IsEnabled() const { return enabled; }
+
+    // Parks the AI cars
+    void Init(ES::Engine::Core &core);
+    // Around the demo's culling and draw submission
+    void BeginFrame(ES::Engine::Core &core);
+    void EndFrame();
+
+    inline const std::vector<Frame> &GetFrames() const { return frames; }
+    // 0 while running or when the run passed
+    inline int GetExitCode() const { return exitCode; }
+
+  private:
+    void PlaceCamera(ES::Engine::Core &core, uint32_t measured) const;
+    void CollectQueries(bool wait);
+    FrameHash HashFramebuffer();
+    void Finish();
+    bool Compare(const std::vector<Frame> &baseline) const;
+
+    static bool WriteCsv(const std::string &path, const std::vector<Frame> &frames);
+    static bool ReadCsv(const std::string &path, std::vector<Frame> &frames);
+
+    Settings settings;
+    bool enabled = false;
+    bool measuring = false;
+    bool finished = false;
+    // Warmup frames rendered
+    uint32_t frame = 0;
+    // Of the camera orbit, from the racing line
+    float orbitRadius = 0.0f;
+    std::array<GLuint, QUERY_FRAMES> queries = {};
+    // Measured frame each query belongs to, UINT32_MAX when idle
+    std::array<uint32_t, QUERY_FRAMES> queryFrames = {};
+    std::vector<Frame> frames;
+    std::vector<uint8_t> pixels;
+    int64_t cpuStart = 0;
+    int exitCode = 0;
+};
+
+// Picks GLFW's null platform when ES_RENDER_BENCHMARK is set, so the context is an
+// offscreen OSMesa one (llvmpipe) and no display or GPU is needed. Must run before
+// the engine initializes GLFW; ES_RENDER_BENCHMARK_OFFSCREEN=0 keeps the window.
+void ConfigureRenderBenchmarkPlatform();
+
+// Reads ES_RENDER_BENCHMARK, the baseline path ("1" for the default one),
+// ES_RENDER_BENCHMARK_FRAMES and ES_RENDER_BENCHMARK_TOLERANCE
+RenderBenchmark CreateRenderBenchmarkFromEnvironment();
+
+void InitRenderBenchmark(ES::Engine::Core &core);
+
+void BeginRenderBenchmarkFrame(ES::Engine::Core &core);
+
+void EndRenderBenchmarkFrame(ES::Engine::Core &core);
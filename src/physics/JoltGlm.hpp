@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Conversions between Jolt and glm math types
+
+inline glm::vec3 ToGlm(const JPH::Vec3 &v) { return glm::vec3(v.GetX(), v.GetY(), v.GetZ()); }
+
+#ifdef JPH_DOUBLE_PRECISION
+inline glm::vec3 ToGlm(const JPH::RVec3 &v)
+{
+    return glm::vec3(static_cast<float>(v.GetX()), static_cast<float>(v.GetY()), static_cast<float>(v.GetZ()));
+}
+#endif
+
+inline glm::quat ToGlm(const JPH::Quat &q) { return glm::quat(q.GetW(), q.GetX(), q.GetY(), q.GetZ()); }
+
+inline JPH::Vec3 ToJolt(const glm::vec3 &v) { return JPH::Vec3(v.x, v.y, v.z); }
+
+inline JPH::Quat ToJolt(const glm::quat &q) { return JPH::Quat(q.x, q.y, q.z, q.w); }
@@ -0,0 +1,140 @@
+#include "PhysicsQueryService.hpp"
+
+#include "JoltGlm.hpp"
+#include "JoltPhysics.hpp"
+#include "task/TaskScheduler.hpp"
+
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Geometry/AABox.h>
+#include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/ShapeCast.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Collision/TransformedShape.h>
+
+#include <algorithm>
+
+PhysicsQueryService::Ticket PhysicsQueryService::Cast(const glm::vec3 &origin, const glm::vec3 &direction,
+                                                      float radius, JPH::BodyID ignoreBody)
+{
+    pending.push_back(Request{origin, direction, radius, ignoreBody});
+    return Ticket{pendingBatch, static_cast<uint32_t>(pending.size() - 1)};
+}
+
+void PhysicsQueryService::Execute(ES::Engine::Core &core)
+{
+    // Nothing requested: keep the previous results readable
+    if (pending.empty())
+        return;
+
+    std::swap(pending, executing);
+    pending.clear();
+    const auto count = static_cast<uint32_t>(executing.size());
+    results.fraction.assign(count, 1.0f);
+    results.position.resize(count);
+    results.normal.resize(count);
+    results.body.assign(count, JPH::BodyID());
+
+    auto &jobSystem = core.GetResource<TaskScheduler>().GetJobSystem();
+    JPH::JobSystem::Barrier *barrier = jobSystem.CreateBarrier();
+    for (uint32_t first = 0; first < count; first += CHUNK_SIZE)
+    {
+        const uint32_t last = std::min(first + CHUNK_SIZE, count);
+        JPH::JobSystem::JobHandle job = jobSystem.CreateJob(
+            "PhysicsQueryChunk", JPH::Color::sCyan, [this, &core, first, last] { ExecuteChunk(core, first, last); });
+        barrier->AddJob(job);
+    }
+    jobSystem.WaitForJobs(barrier);
+    jobSystem.DestroyBarrier(barrier);
+
+    executedBatch = pendingBatch++;
+}
+
+void PhysicsQueryService::ExecuteChunk(ES::Engine::Core &core, uint32_t first, uint32_t last)
+{
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+
+    // One broad-phase query over the bounds of the whole chunk. The containers are per
+    // thread and keep their capacity, chunks run on whichever worker picks them up.
+    JPH::AABox bounds;
+    for (uint32_t i = first; i < last; ++i)
+    {
+        const Request &request = executing[i];
+        JPH::AABox cast(ToJolt(glm::min(request.origin, request.origin + request.direction)),
+                        ToJolt(glm::max(request.origin, request.origin + request.direction)));
+        cast.ExpandBy(JPH::Vec3::sReplicate(request.radius));
+        bounds.Encapsulate(cast);
+    }
+    thread_local JPH::AllHitCollisionCollector<JPH::CollideShapeBodyCollector> candidates;
+    candidates.Reset();
+    physicsSystem.GetBroadPhaseQuery().CollideAABox(bounds, candidates);
+
+    thread_local std::vector<JPH::TransformedShape> shapes;
+    shapes.clear();
+    for (const JPH::BodyID &id : candidates.mHits)
+    {
+        // Sensors, like the timing gates, are not surfaces
+        JPH::BodyLockRead lock(physicsSystem.GetBodyLockInterface(), id);
+        if (lock.Succeeded() && !lock.GetBody().IsSensor())
+            shapes.push_back(lock.GetBody().GetTransformedShape());
+    }
+
+    for (uint32_t i = first; i < last; ++i)
+    {
+        const Request &request = executing[i];
+        const JPH::RVec3 origin(request.origin.x, request.origin.y, request.origin.z);
+        const JPH::Vec3 direction = ToJolt(request.direction);
+        float &fraction = results.fraction[i];
+        JPH::BodyID &hitBody = results.body[i];
+
+        if (request.radius <= 0.0f)
+        {
+            const JPH::RRayCast ray(origin, direction);
+            JPH::RayCastResult hit;
+            for (const JPH::TransformedShape &shape : shapes)
+            {
+                if (shape.mBodyID == request.ignoreBody)
+                    continue;
+                hit.mFraction = fraction;
+                if (shape.CastRay(ray, hit))
+                {
+                    fraction = hit.mFraction;
+                    hitBody = shape.mBodyID;
+                    const JPH::RVec3 point = ray.GetPointOnRay(fraction);
+                    results.position[i] = ToGlm(point);
+                    results.normal[i] = ToGlm(shape.GetWorldSpaceSurfaceNormal(hit.mSubShapeID2, point));
+                }
+            }
+        }
+        else
+        {
+            JPH::SphereShape sphere(request.radius);
+            sphere.SetEmbedded();
+            const JPH::RShapeCast cast(&sphere, JPH::Vec3::sReplicate(1.0f), JPH::RMat44::sTranslation(origin),
+                                       direction);
+            JPH::ShapeCastSettings settings;
+            for (const JPH::TransformedShape &shape : shapes)
+            {
+                if (shape.mBodyID == request.ignoreBody)
+                    continue;
+                JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+                collector.UpdateEarlyOutFraction(fraction);
+                shape.CastShape(cast, settings, JPH::RVec3::sZero(), collector);
+                if (collector.HadHit() && collector.mHit.mFraction < fraction)
+                {
+                    fraction = collector.mHit.mFraction;
+                    hitBody = shape.mBodyID;
+                    results.position[i] = ToGlm(collector.mHit.mContactPointOn2);
+                    results.normal[i] = ToGlm(-collector.mHit.mPenetrationAxis.NormalizedOr(JPH::Vec3::sAxisY()));
+                }
+            }
+        }
+    }
+}
+
+void ExecutePhysicsQueries(ES::Engine::Core &core)
+{
+    core.GetResource<PhysicsQueryService>().Execute(core);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Core.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Collects ray and sphere casts issued by any system during a tick and runs them as
+// one batch on the TaskScheduler. Casts are grouped in chunks of consecutive
+// requests that share a single broad-phase query, so a car issuing its look-ahead
+// rays back to back pays for one tree traversal instead of one per ray.
+//
+// Results are published the tick after the request and stay readable until the next
+// batch runs; a Ticket tells whether its result is ready.
+class PhysicsQueryService {
+  public:
+    struct Ticket {
+        uint32_t batch = 0;
+        uint32_t index = 0;
+    };
+
+    // One field per array, indexed by Ticket::index. A fraction of 1 means no hit.
+    struct Results {
+        std::vector<float> fraction;
+        std::vector<glm::vec3> position;
+        std::vector<glm::vec3> normal;
+        std::vector<JPH::BodyID> body;
+    };
+
+    // Requests sharing a broad-phase query
+    static constexpr uint32_t CHUNK_SIZE = 16;
+
+    PhysicsQueryService() = default;
+    PhysicsQueryService(PhysicsQueryService &&) = default;
+    PhysicsQueryService &operator=(PhysicsQueryService &&) = default;
+
+    // Casts from origin along direction, whose length is the cast distance. A radius
+    // above 0 sweeps a sphere instead of a ray. ignoreBody is usually the caster itself.
+    // Sensor bodies are never hit.
+    Ticket Cast(const glm::vec3 &origin, const glm::vec3 &direction, float radius = 0.0f,
+                JPH::BodyID ignoreBody = JPH::BodyID());
+
+    // Runs every pending cast, to be called once per tick
+    void Execute(ES::Engine::Core &core);
+
+    inline bool IsReady(const Ticket &ticket) const { return ticket.batch == executedBatch; }
+    inline const Results &GetResults() const { return results; }
+    inline uint32_t GetLastBatchSize() const { return static_cast<uint32_t>(results.fraction.size()); }
+
+  private:
+    struct Request {
+        glm::vec3 origin;
+        glm::vec3 direction;
+        float radius;
+        JPH::BodyID ignoreBody;
+    };
+
+    void ExecuteChunk(ES::Engine::Core &core, uint32_t first, uint32_t last);
+
+    std::vector<Request> pending;
+    std::vector<Request> executing;
+    Results results;
+    // Batch the pending requests will run in, and the one results belong to
+    uint32_t pendingBatch = 1;
+    uint32_t executedBatch = 0;
+};
+
+void ExecutePhysicsQueries(ES::Engine::Core &core);
@@ -0,0 +1,26 @@
+#include "PhysicsRewindKeys.hpp"
+
+#include "Logger.hpp"
+#include "PhysicsSnapshot.hpp"
+
+void PhysicsRewindKeys::operator()(ES::Engine::Core &core) const
+{
+    bool rewindPressed = ES::Plugin::Input::Utils::IsKeyPressed(rewindKey);
+    bool checkpointPressed = ES::Plugin::Input::Utils::IsKeyPressed(checkpointKey);
+    auto &snapshots = core.GetResource<PhysicsSnapshotRing>();
+
+    if (rewindPressed && !rewindWasPressed)
+    {
+        uint32_t ticksAgo = snapshots.GetCount() == 0 ? 0 : snapshots.GetCount() - 1;
+        if (snapshots.Rewind(core, ticksAgo))
+            ES::Utils::Log::Info(fmt::format("Rewound {} ticks", ticksAgo));
+    }
+    if (checkpointPressed && !checkpointWasPressed)
+    {
+        if (snapshots.RestoreCheckpoint(core))
+            ES::Utils::Log::Info("Restored checkpoint");
+    }
+
+    rewindWasPressed = rewindPressed;
+    checkpointWasPressed = checkpointPressed;
+}
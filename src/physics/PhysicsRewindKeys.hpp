@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Engine.hpp"
+
+#include "Input.hpp"
+
+// Debug bindings for the PhysicsSnapshotRing: rewind the last second of simulation,
+// or go back to the checkpoint taken when the race started
+class PhysicsRewindKeys
+{
+  public:
+    void operator()(ES::Engine::Core &core) const;
+
+    inline void SetRewindKey(int key) { rewindKey = key; }
+    inline void SetCheckpointKey(int key) { checkpointKey = key; }
+
+  private:
+    int rewindKey = GLFW_KEY_BACKSPACE;
+    int checkpointKey = GLFW_KEY_R;
+    mutable bool rewindWasPressed = false;
+    mutable bool checkpointWasPressed = false;
+};
@@ -0,0 +1,254 @@
+#include "PhysicsSnapshot.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "Object.hpp"
+#include "TransformSync.hpp"
+#include "VehicleSimulationLod.hpp"
+#include "WheeledVehicle3D.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+void BufferStateRecorder::BeginWrite(uint8_t *data, std::size_t capacity)
+{
+    writeData = data;
+    readData = nullptr;
+    size = capacity;
+    position = 0;
+    failed = false;
+}
+
+void BufferStateRecorder::BeginRead(const uint8_t *data, std::size_t dataSize)
+{
+    writeData = nullptr;
+    readData = data;
+    size = dataSize;
+    position = 0;
+    failed = false;
+}
+
+void BufferStateRecorder::WriteBytes(const void *inData, std::size_t inNumBytes)
+{
+    if (failed || writeData == nullptr || position + inNumBytes > size)
+    {
+        failed = true;
+        return;
+    }
+    std::memcpy(writeData + position, inData, inNumBytes);
+    position += inNumBytes;
+}
+
+void BufferStateRecorder::ReadBytes(void *outData, std::size_t inNumBytes)
+{
+    if (failed || readData == nullptr || position + inNumBytes > size)
+    {
+        failed = true;
+        std::memset(outData, 0, inNumBytes);
+        return;
+    }
+    std::memcpy(outData, readData + position, inNumBytes);
+    position += inNumBytes;
+}
+
+PhysicsSnapshotRing::PhysicsSnapshotRing(uint32_t capacity_, std::size_t bytesPerSnapshot_)
+    : capacity(capacity_), bytesPerSnapshot(bytesPerSnapshot_), storage(capacity_ * bytesPerSnapshot_),
+      slots(capacity_), checkpointStorage(bytesPerSnapshot_)
+{
+}
+
+bool PhysicsSnapshotRing::Save(ES::Engine::Core &core, uint8_t *data, std::size_t &size)
+{
+    using ES::Plugin::Object::Component::Transform;
+    auto &registry = core.GetRegistry();
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+
+    recorder.BeginWrite(data, bytesPerSnapshot);
+
+    // LOD levels first: Load has to put the same vehicle constraints in the system before RestoreState
+    auto lods = registry.view<SimulationLod>();
+    recorder.Write(static_cast<uint32_t>(lods.size()));
+    for (auto entity : lods)
+    {
+        const auto &lod = lods.get<SimulationLod>(entity);
+        recorder.Write(entt::to_integral(entity));
+        recorder.Write(lod.level);
+        recorder.Write(lod.speed);
+        recorder.Write(lod.yawRate);
+    }
+
+    physicsSystem.SaveState(recorder);
+
+    // ECS side: transforms of everything the physics drives, tagged by entity id
+    auto writeTransform = [this](entt::entity entity, const Transform &transform) {
+        recorder.Write(entt::to_integral(entity));
+        recorder.Write(transform.position);
+        recorder.Write(transform.rotation);
+        recorder.Write(transform.scale);
+    };
+
+    auto bodies = registry.view<Transform, ES::Plugin::Physics::Component::RigidBody3D>();
+    auto transformCount = static_cast<uint32_t>(std::distance(bodies.begin(), bodies.end()));
+    registry.view<ES::Plugin::Physics::Component::WheeledVehicle3D>().each([&transformCount](auto, auto &vehicle) {
+        transformCount += static_cast<uint32_t>(vehicle.wheelEntities.size());
+    });
+
+    recorder.Write(transformCount);
+    for (auto entity : bodies)
+        writeTransform(entity, bodies.get<Transform>(entity));
+    registry.view<ES::Plugin::Physics::Component::WheeledVehicle3D>().each([&](auto, auto &vehicle) {
+        for (auto wheel : vehicle.wheelEntities)
+            writeTransform(wheel, registry.get<Transform>(wheel));
+    });
+
+    if (recorder.IsFailed())
+        return false;
+    size = recorder.GetPosition();
+    return true;
+}
+
+bool PhysicsSnapshotRing::Grow()
+{
+    std::size_t grown = bytesPerSnapshot * 2;
+    if (grown > MAX_BYTES_PER_SNAPSHOT)
+    {
+        ES::Utils::Log::Error(fmt::format("PhysicsSnapshotRing: snapshot does not fit in {} bytes", bytesPerSnapshot));
+        return false;
+    }
+    ES::Utils::Log::Warn(fmt::format("PhysicsSnapshotRing: growing slots from {} to {} bytes", bytesPerSnapshot, grown));
+
+    // Slots move to their new offsets, the ring and the checkpoint stay valid
+    std::vector<uint8_t> grownStorage(capacity * grown);
+    for (uint32_t i = 0; i < capacity; ++i)
+        std::memcpy(grownStorage.data() + i * grown, SlotData(i), slots[i].size);
+    storage = std::move(grownStorage);
+    checkpointStorage.resize(grown);
+    bytesPerSnapshot = grown;
+    return true;
+}
+
+bool PhysicsSnapshotRing::Load(ES::Engine::Core &core, const uint8_t *data, std::size_t size)
+{
+    using ES::Plugin::Object::Component::Transform;
+    auto &registry = core.GetRegistry();
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+
+    recorder.BeginRead(data, size);
+
+    auto &simulationLod = core.GetResource<VehicleSimulationLod>();
+    uint32_t lodCount = 0;
+    recorder.Read(lodCount);
+    for (uint32_t i = 0; i < lodCount && !recorder.IsFailed(); ++i)
+    {
+        std::underlying_type_t<entt::entity> id;
+        SimulationLod::Level level;
+        float speed;
+        float yawRate;
+        recorder.Read(id);
+        recorder.Read(level);
+        recorder.Read(speed);
+        recorder.Read(yawRate);
+        simulationLod.SetLevel(core, static_cast<entt::entity>(id), level, speed, yawRate);
+    }
+
+    if (!physicsSystem.RestoreState(recorder))
+    {
+        ES::Utils::Log::Error("PhysicsSnapshotRing: failed to restore the physics state");
+        return false;
+    }
+
+    auto &transformSync = core.GetResource<TransformSync>();
+    uint32_t transformCount = 0;
+    recorder.Read(transformCount);
+    for (uint32_t i = 0; i < transformCount && !recorder.IsFailed(); ++i)
+    {
+        std::underlying_type_t<entt::entity> id;
+        glm::vec3 position;
+        glm::quat rotation;
+        glm::vec3 scale;
+        recorder.Read(id);
+        recorder.Read(position);
+        recorder.Read(rotation);
+        recorder.Read(scale);
+
+        auto entity = static_cast<entt::entity>(id);
+        if (!registry.valid(entity) || !registry.all_of<Transform>(entity))
+            continue;
+        auto &transform = registry.get<Transform>(entity);
+        transform.position = position;
+        transform.rotation = rotation;
+        transform.scale = scale;
+        transformSync.MarkDirty(entity);
+    }
+    return !recorder.IsFailed();
+}
+
+bool PhysicsSnapshotRing::Capture(ES::Engine::Core &core)
+{
+    uint32_t index = count == 0 ? 0 : (newest + 1) % capacity;
+    // Overwritten from here on, whether the capture succeeds or not
+    slots[index].size = 0;
+    std::size_t size = 0;
+    while (!Save(core, SlotData(index), size))
+    {
+        if (!Grow())
+            return false;
+    }
+
+    slots[index] = Slot{tick, size};
+    newest = index;
+    count = std::min(count + 1, capacity);
+    tick++;
+    return true;
+}
+
+bool PhysicsSnapshotRing::Rewind(ES::Engine::Core &core, uint32_t ticksAgo)
+{
+    if (ticksAgo >= count)
+        return false;
+
+    uint32_t index = (newest + capacity - ticksAgo) % capacity;
+    if (!Load(core, SlotData(index), slots[index].size))
+        return false;
+
+    newest = index;
+    count -= ticksAgo;
+    tick = slots[index].tick + 1;
+    return true;
+}
+
+bool PhysicsSnapshotRing::CaptureCheckpoint(ES::Engine::Core &core)
+{
+    hasCheckpoint = false;
+    std::size_t size = 0;
+    while (!Save(core, checkpointStorage.data(), size))
+    {
+        if (!Grow())
+            return false;
+    }
+    checkpoint = Slot{tick, size};
+    hasCheckpoint = true;
+    return true;
+}
+
+bool PhysicsSnapshotRing::RestoreCheckpoint(ES::Engine::Core &core)
+{
+    if (!hasCheckpoint || !Load(core, checkpointStorage.data(), checkpoint.size))
+        return false;
+
+    // The ring no longer describes the past of the restored state
+    count = 0;
+    tick = checkpoint.tick;
+    return true;
+}
+
+void PhysicsSnapshotRing::Clear()
+{
+    count = 0;
+    hasCheckpoint = false;
+}
+
+void CapturePhysicsSnapshot(ES::Engine::Core &core)
+{
+    core.GetResource<PhysicsSnapshotRing>().Capture(core);
+}
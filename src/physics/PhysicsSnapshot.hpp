@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Core.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/StateRecorder.h>
+
+#include <cstdint>
+#include <vector>
+
+// JPH::StateRecorder over caller-owned memory: never allocates, fails instead of growing
+class BufferStateRecorder final : public JPH::StateRecorder {
+  public:
+    void BeginWrite(uint8_t *data, std::size_t capacity);
+    void BeginRead(const uint8_t *data, std::size_t size);
+
+    void WriteBytes(const void *inData, std::size_t inNumBytes) override;
+    void ReadBytes(void *outData, std::size_t inNumBytes) override;
+    bool IsEOF() const override { return position >= size; }
+    bool IsFailed() const override { return failed; }
+
+    inline std::size_t GetPosition() const { return position; }
+
+  private:
+    uint8_t *writeData = nullptr;
+    const uint8_t *readData = nullptr;
+    std::size_t size = 0;
+    std::size_t position = 0;
+    bool failed = false;
+};
+
+// Ring of full simulation snapshots, one per fixed tick. Every slot is allocated up
+// front; capturing and restoring only copy bytes in and out of those slots.
+// A snapshot holds the SimulationLod state of every vehicle, the whole Jolt state (bodies, contacts, constraints, including the
+// VehicleConstraint wheel, engine and transmission state) followed by the Transform of
+// every rigid body and vehicle wheel entity. Slots start at bytesPerSnapshot and are
+// doubled, keeping their content, the first time a snapshot does not fit.
+class PhysicsSnapshotRing {
+  public:
+    static constexpr std::size_t MAX_BYTES_PER_SNAPSHOT = 16 * 1024 * 1024;
+
+    explicit PhysicsSnapshotRing(uint32_t capacity = 240, std::size_t bytesPerSnapshot = 64 * 1024);
+
+    PhysicsSnapshotRing(PhysicsSnapshotRing &&) = default;
+    PhysicsSnapshotRing &operator=(PhysicsSnapshotRing &&) = default;
+
+    // Records the current state as the newest snapshot, overwriting the oldest one if full
+    bool Capture(ES::Engine::Core &core);
+
+    // Restores the snapshot taken ticksAgo captures before the newest one (0 = newest).
+    // Newer snapshots are discarded so the simulation can be replayed from there.
+    bool Rewind(ES::Engine::Core &core, uint32_t ticksAgo);
+
+    // Stores the current state in the dedicated checkpoint slot, which the ring never overwrites
+    bool CaptureCheckpoint(ES::Engine::Core &core);
+    bool RestoreCheckpoint(ES::Engine::Core &core);
+
+    // Drops every snapshot, to be called when the bodies they describe are destroyed
+    void Clear();
+
+    inline uint32_t GetCount() const { return count; }
+    inline uint64_t GetTick() const { return tick; }
+
+  private:
+    struct Slot {
+        uint64_t tick = 0;
+        std::size_t size = 0;
+    };
+
+    bool Save(ES::Engine::Core &core, uint8_t *data, std::size_t &size);
+    bool Load(ES::Engine::Core &core, const uint8_t *data, std::size_t size);
+    // Doubles the slot size, false once it would exceed MAX_BYTES_PER_SNAPSHOT
+    bool Grow();
+    inline uint8_t *SlotData(uint32_t index) { return storage.data() + index * bytesPerSnapshot; }
+
+    uint32_t capacity;
+    std::size_t bytesPerSnapshot;
+    std::vector<uint8_t> storage;
+    std::vector<Slot> slots;
+    std::vector<uint8_t> checkpointStorage;
+    Slot checkpoint;
+    bool hasCheckpoint = false;
+    uint32_t newest = 0;
+    uint32_t count = 0;
+    uint64_t tick = 0;
+    BufferStateRecorder recorder;
+};
+
+void CapturePhysicsSnapshot(ES::Engine::Core &core);
@@ -0,0 +1,126 @@
+#include "TransformSync.hpp"
+
+#include "JoltGlm.hpp"
+#include "JoltPhysics.hpp"
+#include "Object.hpp"
+#include "WheeledVehicle3D.hpp"
+
+#include <Jolt/Physics/Vehicle/VehicleConstraint.h>
+
+#include <algorithm>
+
+void TransformSync::RebuildBodyEntities(ES::Engine::Core &core)
+{
+    core.GetRegistry().view<ES::Plugin::Physics::Component::RigidBody3D>().each(
+        [this](entt::entity entity, auto &rigidBody) {
+            if (rigidBody.body == nullptr)
+                return;
+            const JPH::BodyID id = rigidBody.body->GetID();
+            if (id.GetIndex() >= bodyEntities.size())
+                bodyEntities.resize(id.GetIndex() + 1);
+            bodyEntities[id.GetIndex()] = BodyEntity{id, entity};
+        });
+}
+
+entt::entity TransformSync::FindEntity(ES::Engine::Core &core, const JPH::BodyID &body)
+{
+    const uint32_t index = body.GetIndex();
+    if (index < bodyEntities.size() && bodyEntities[index].body == body)
+        return bodyEntities[index].entity;
+
+    // New bodies show up as misses, one rebuild per tick picks all of them up
+    if (!rebuiltThisTick)
+    {
+        rebuiltThisTick = true;
+        RebuildBodyEntities(core);
+        if (index < bodyEntities.size() && bodyEntities[index].body == body)
+            return bodyEntities[index].entity;
+    }
+
+    // A body no entity owns: remember it so it does not trigger rebuilds
+    if (index >= bodyEntities.size())
+        bodyEntities.resize(index + 1);
+    bodyEntities[index] = BodyEntity{body, entt::null};
+    return entt::null;
+}
+
+void TransformSync::Sync(ES::Engine::Core &core)
+{
+    using ES::Plugin::Object::Component::Transform;
+
+    auto &registry = core.GetRegistry();
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+    // Runs between two steps on the thread that steps the world, nothing else writes bodies
+    const JPH::BodyInterface &bodyInterface = physicsSystem.GetBodyInterfaceNoLock();
+    auto &transforms = registry.storage<Transform>();
+
+    rebuiltThisTick = false;
+    stats.activeBodies = physicsSystem.GetNumActiveBodies(JPH::EBodyType::RigidBody);
+    const JPH::BodyID *active = physicsSystem.GetActiveBodiesUnsafe(JPH::EBodyType::RigidBody);
+
+    // Read every active body first, then write the Transforms in storage order
+    pending.clear();
+    for (uint32_t i = 0; i < stats.activeBodies; ++i)
+    {
+        const entt::entity entity = FindEntity(core, active[i]);
+        if (entity == entt::null || !transforms.contains(entity))
+            continue;
+        Pending &body = pending.emplace_back();
+        body.storageIndex = static_cast<uint32_t>(transforms.index(entity));
+        body.entity = entity;
+        bodyInterface.GetPositionAndRotation(active[i], body.position, body.rotation);
+    }
+    std::sort(pending.begin(), pending.end(),
+              [](const Pending &a, const Pending &b) { return a.storageIndex < b.storageIndex; });
+
+    for (const Pending &body : pending)
+    {
+        Transform &transform = transforms.get(body.entity);
+        transform.position = ToGlm(body.position);
+        transform.rotation = ToGlm(body.rotation);
+        MarkDirty(body.entity);
+
+        auto *vehicle = registry.try_get<ES::Plugin::Physics::Component::WheeledVehicle3D>(body.entity);
+        if (vehicle == nullptr || vehicle->vehicleConstraint == nullptr)
+            continue;
+        // Wheel meshes spin around their X axis
+        for (uint32_t wheel = 0; wheel < vehicle->wheelEntities.size(); ++wheel)
+        {
+            const JPH::RMat44 world = vehicle->vehicleConstraint->GetWheelWorldTransform(
+                wheel, JPH::Vec3::sAxisX(), JPH::Vec3::sAxisY());
+            Transform &wheelTransform = transforms.get(vehicle->wheelEntities[wheel]);
+            wheelTransform.position = ToGlm(world.GetTranslation());
+            wheelTransform.rotation = ToGlm(world.GetQuaternion());
+            MarkDirty(vehicle->wheelEntities[wheel]);
+        }
+    }
+    stats.synced = static_cast<uint32_t>(pending.size());
+    stats.dirty = static_cast<uint32_t>(dirty.size());
+}
+
+void TransformSync::MarkDirty(entt::entity entity)
+{
+    const auto slot = static_cast<std::size_t>(entt::to_entity(entity));
+    if (slot >= dirtyGeneration.size())
+        dirtyGeneration.resize(slot + 1, 0);
+    if (dirtyGeneration[slot] == generation)
+        return;
+    dirtyGeneration[slot] = generation;
+    dirty.push_back(entity);
+}
+
+void TransformSync::ClearDirty()
+{
+    dirty.clear();
+    generation++;
+}
+
+void SyncActiveTransforms(ES::Engine::Core &core)
+{
+    core.GetResource<TransformSync>().Sync(core);
+}
+
+void ClearTransformDirty(ES::Engine::Core &core)
+{
+    core.GetResource<TransformSync>().ClearDirty();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Engine.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+
+#include <entt/entt.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Copies the physics results into the Transform components, for the bodies Jolt
+// reports as active only: sleeping and static bodies cost nothing. Vehicles carry
+// their wheel entities along. The physics plugin's own sync still rewrites every
+// body's Transform each tick, until the engine lets main drop it.
+//
+// Every Transform written here, or by anything else that calls MarkDirty, lands in
+// the dirty list, which stays readable until ClearDirty. The renderer side refits
+// only those.
+class TransformSync
+{
+  public:
+    struct Stats {
+        uint32_t activeBodies = 0;
+        uint32_t synced = 0;
+        uint32_t dirty = 0;
+    };
+
+    TransformSync() = default;
+    TransformSync(TransformSync &&) = default;
+    TransformSync &operator=(TransformSync &&) = default;
+
+    void Sync(ES::Engine::Core &core);
+
+    void MarkDirty(entt::entity entity);
+    void ClearDirty();
+
+    inline const std::vector<entt::entity> &GetDirty() const { return dirty; }
+    inline const Stats &GetStats() const { return stats; }
+
+  private:
+    struct BodyEntity {
+        JPH::BodyID body;
+        entt::entity entity = entt::null;
+    };
+
+    struct Pending {
+        uint32_t storageIndex;
+        entt::entity entity;
+        JPH::RVec3 position;
+        JPH::Quat rotation;
+    };
+
+    entt::entity FindEntity(ES::Engine::Core &core, const JPH::BodyID &body);
+    void RebuildBodyEntities(ES::Engine::Core &core);
+
+    // Indexed by BodyID::GetIndex(), checked against the full id to catch reused slots
+    std::vector<BodyEntity> bodyEntities;
+    bool rebuiltThisTick = false;
+    std::vector<Pending> pending;
+    std::vector<entt::entity> dirty;
+    // Dirty generation each entity was last listed in, indexed by entity slot
+    std::vector<uint32_t> dirtyGeneration;
+    uint32_t generation = 1;
+    Stats stats;
+};
+
+void SyncActiveTransforms(ES::Engine::Core &core);
+void ClearTransformDirty(ES::Engine::Core &core);
@@ -0,0 +1,210 @@
+#include "VehicleSimulationLod.hpp"
+
+#include "Camera.hpp"
+#include "JoltGlm.hpp"
+#include "JoltPhysics.hpp"
+#include "Object.hpp"
+#include "OpenGL.hpp"
+#include "WheeledVehicle3D.hpp"
+#include "render/Frustum.hpp"
+
+#include <Jolt/Physics/Vehicle/VehicleConstraint.h>
+#include <Jolt/Physics/Vehicle/WheeledVehicleController.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Rough bounds of a car around its body position, for the frustum test
+constexpr float VEHICLE_CULL_EXTENT = 3.0f;
+
+// Wheelbase, largest steer angle and wheel radius, read from the constraint settings
+struct BicycleGeometry {
+    float wheelBase = 2.45f;
+    float maxSteerAngle = 0.0f;
+    float wheelRadius = 0.35f;
+};
+
+static BicycleGeometry GetBicycleGeometry(const JPH::VehicleConstraint &constraint)
+{
+    BicycleGeometry geometry;
+    float front = -FLT_MAX;
+    float rear = FLT_MAX;
+    for (const JPH::Wheel *wheel : constraint.GetWheels())
+    {
+        const auto *settings = static_cast<const JPH::WheelSettingsWV *>(wheel->GetSettings());
+        front = std::max(front, settings->mPosition.GetZ());
+        rear = std::min(rear, settings->mPosition.GetZ());
+        geometry.maxSteerAngle = std::max(geometry.maxSteerAngle, settings->mMaxSteerAngle);
+        geometry.wheelRadius = settings->mRadius;
+    }
+    if (front > rear)
+        geometry.wheelBase = front - rear;
+    return geometry;
+}
+
+static void ToReduced(JPH::PhysicsSystem &physicsSystem, JPH::Body &body, JPH::VehicleConstraint &constraint,
+                      SimulationLod &lod)
+{
+    const glm::quat rotation = ToGlm(body.GetRotation());
+    lod.speed = glm::dot(ToGlm(body.GetLinearVelocity()), rotation * glm::vec3(0.0f, 0.0f, 1.0f));
+    lod.yawRate = glm::dot(ToGlm(body.GetAngularVelocity()), rotation * glm::vec3(0.0f, 1.0f, 0.0f));
+
+    lod.parkedConstraint = &constraint;
+    physicsSystem.RemoveStepListener(&constraint);
+    physicsSystem.RemoveConstraint(&constraint);
+    physicsSystem.GetBodyInterface().SetMotionType(body.GetID(), JPH::EMotionType::Kinematic,
+                                                   JPH::EActivation::Activate);
+    lod.level = SimulationLod::Level::REDUCED;
+}
+
+static void ToFull(JPH::PhysicsSystem &physicsSystem, JPH::Body &body, JPH::VehicleConstraint &constraint,
+                   SimulationLod &lod)
+{
+    // Carry the reduced model's motion over so the hand-off does not jolt the car
+    auto &bodyInterface = physicsSystem.GetBodyInterface();
+    const glm::quat rotation = ToGlm(body.GetRotation());
+    bodyInterface.SetMotionType(body.GetID(), JPH::EMotionType::Dynamic, JPH::EActivation::Activate);
+    bodyInterface.SetLinearAndAngularVelocity(body.GetID(),
+                                              ToJolt(rotation * glm::vec3(0.0f, 0.0f, lod.speed)),
+                                              ToJolt(rotation * glm::vec3(0.0f, lod.yawRate, 0.0f)));
+
+    const BicycleGeometry geometry = GetBicycleGeometry(constraint);
+    for (JPH::Wheel *wheel : constraint.GetWheels())
+        wheel->SetAngularVelocity(lod.speed / geometry.wheelRadius);
+
+    physicsSystem.AddConstraint(&constraint);
+    physicsSystem.AddStepListener(&constraint);
+    lod.parkedConstraint = nullptr;
+    lod.level = SimulationLod::Level::FULL;
+}
+
+// Kinematic bicycle model on the ground plane: integrates speed from the driver
+// inputs, turns with the front axle's steer angle and keeps pitch and roll as they were
+static void StepReduced(JPH::BodyInterface &bodyInterface, JPH::Body &body, JPH::VehicleConstraint &constraint,
+                        SimulationLod &lod, const VehicleSimulationLod::Settings &settings, float deltaTime)
+{
+    const auto *controller = static_cast<const JPH::WheeledVehicleController *>(constraint.GetController());
+    const float forwardInput = controller->GetForwardInput();
+    const float rightInput = controller->GetRightInput();
+    const float brakeInput = std::max(controller->GetBrakeInput(), controller->GetHandBrakeInput());
+    const BicycleGeometry geometry = GetBicycleGeometry(constraint);
+
+    float acceleration = forwardInput * settings.maxAcceleration - settings.drag * lod.speed * std::abs(lod.speed);
+    float speed = lod.speed + acceleration * deltaTime;
+    float braking = brakeInput * settings.brakeDeceleration * deltaTime;
+    speed = std::abs(speed) <= braking ? 0.0f : speed - std::copysign(braking, speed);
+
+    // Turning right rotates the +Z forward axis towards -X, a negative yaw about +Y
+    const float steerAngle = rightInput * geometry.maxSteerAngle;
+    lod.yawRate = -speed * std::tan(steerAngle) / geometry.wheelBase;
+    lod.speed = speed;
+
+    const glm::quat rotation = ToGlm(body.GetRotation());
+    const glm::quat yaw = glm::angleAxis(lod.yawRate * deltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::quat nextRotation = glm::normalize(yaw * rotation);
+    glm::vec3 forward = glm::slerp(rotation, nextRotation, 0.5f) * glm::vec3(0.0f, 0.0f, 1.0f);
+    forward.y = 0.0f;
+    if (glm::dot(forward, forward) > 1e-6f)
+        forward = glm::normalize(forward);
+    const glm::vec3 position = ToGlm(body.GetPosition()) + forward * speed * deltaTime;
+
+    bodyInterface.MoveKinematic(body.GetID(), JPH::RVec3(position.x, position.y, position.z), ToJolt(nextRotation),
+                                deltaTime);
+
+    // The wheels are still drawn from the constraint, keep them turning and steering
+    for (uint32_t i = 0; i < constraint.GetWheels().size(); ++i)
+    {
+        JPH::Wheel *wheel = constraint.GetWheel(i);
+        const auto *wheelSettings = static_cast<const JPH::WheelSettingsWV *>(wheel->GetSettings());
+        wheel->SetRotationAngle(wheel->GetRotationAngle() + speed / geometry.wheelRadius * deltaTime);
+        wheel->SetSteerAngle(-rightInput * wheelSettings->mMaxSteerAngle);
+    }
+}
+
+void VehicleSimulationLod::Update(ES::Engine::Core &core, float deltaTime)
+{
+    auto &camera = core.GetResource<ES::Plugin::OpenGL::Resource::Camera>();
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+    auto &bodyInterface = physicsSystem.GetBodyInterface();
+    const glm::vec3 viewPoint = camera.viewer.getViewPoint();
+    const Frustum frustum(camera.projection * camera.view);
+
+    stats = Stats();
+    core.GetRegistry().view<ES::Plugin::Physics::Component::WheeledVehicle3D>().each([](auto entity, auto &vehicle) {
+        if (vehicle.vehicleConstraint != nullptr)
+            vehicle.vehicleConstraint->SetConstraintPriority(entt::to_integral(entity) + 1);
+    });
+
+    core.GetRegistry()
+        .view<SimulationLod, ES::Plugin::Physics::Component::WheeledVehicle3D,
+              ES::Plugin::Physics::Component::RigidBody3D>()
+        .each([&](auto, SimulationLod &lod, auto &vehicle, auto &rigidBody) {
+            if (rigidBody.body == nullptr || vehicle.vehicleConstraint == nullptr)
+                return;
+            JPH::Body &body = *rigidBody.body;
+            JPH::VehicleConstraint &constraint = *vehicle.vehicleConstraint;
+
+            const glm::vec3 position = ToGlm(body.GetPosition());
+            const float distance = glm::distance(position, viewPoint);
+            const bool visible = frustum.Classify(Aabb{position - glm::vec3(VEHICLE_CULL_EXTENT),
+                                                       position + glm::vec3(VEHICLE_CULL_EXTENT)}) !=
+                                 Frustum::Result::OUTSIDE;
+
+            // The gap between the two distances keeps cars at the boundary from flickering between levels
+            bool reduce;
+            if (distance < settings.fullDistance)
+                reduce = !visible && distance > settings.hiddenDistance;
+            else if (distance > settings.reducedDistance)
+                reduce = true;
+            else
+                reduce = lod.level == SimulationLod::Level::REDUCED || !visible;
+
+            if (reduce && lod.level == SimulationLod::Level::FULL)
+            {
+                ToReduced(physicsSystem, body, constraint, lod);
+                stats.transitions++;
+            }
+            else if (!reduce && lod.level == SimulationLod::Level::REDUCED)
+            {
+                ToFull(physicsSystem, body, constraint, lod);
+                stats.transitions++;
+            }
+
+            if (lod.level == SimulationLod::Level::REDUCED)
+            {
+                StepReduced(bodyInterface, body, constraint, lod, settings, deltaTime);
+                stats.reduced++;
+            }
+            else
+            {
+                stats.full++;
+            }
+        });
+}
+
+void VehicleSimulationLod::SetLevel(ES::Engine::Core &core, entt::entity entity, SimulationLod::Level level,
+                                    float speed, float yawRate)
+{
+    auto &registry = core.GetRegistry();
+    auto *lod = registry.try_get<SimulationLod>(entity);
+    auto *vehicle = registry.try_get<ES::Plugin::Physics::Component::WheeledVehicle3D>(entity);
+    auto *rigidBody = registry.try_get<ES::Plugin::Physics::Component::RigidBody3D>(entity);
+    if (lod == nullptr || vehicle == nullptr || rigidBody == nullptr || rigidBody->body == nullptr ||
+        vehicle->vehicleConstraint == nullptr)
+        return;
+
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+    if (level == SimulationLod::Level::REDUCED && lod->level == SimulationLod::Level::FULL)
+        ToReduced(physicsSystem, *rigidBody->body, *vehicle->vehicleConstraint, *lod);
+    else if (level == SimulationLod::Level::FULL && lod->level == SimulationLod::Level::REDUCED)
+        ToFull(physicsSystem, *rigidBody->body, *vehicle->vehicleConstraint, *lod);
+    lod->speed = speed;
+    lod->yawRate = yawRate;
+}
+
+void UpdateVehicleSimulationLod(ES::Engine::Core &core)
+{
+    core.GetResource<VehicleSimulationLod>().Update(
+        core, core.GetScheduler<ES::Engine::Scheduler::FixedTimeUpdate>().GetTickRate());
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Core.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Constraints/Constraint.h>
+
+#include <entt/entt.hpp>
+
+#include <cstdint>
+
+// Opts a vehicle into simulation LOD. The player car should not carry it.
+struct SimulationLod {
+    enum class Level {
+        FULL,
+        REDUCED,
+    };
+
+    Level level = Level::FULL;
+    // Bicycle model state, only meaningful while REDUCED
+    float speed = 0.0f;
+    float yawRate = 0.0f;
+    // Keeps the VehicleConstraint alive while it is out of the physics system
+    JPH::Ref<JPH::Constraint> parkedConstraint;
+};
+
+// Moves far or hidden vehicles off their VehicleConstraint onto a kinematic bicycle
+// model driven by the same driver inputs, and back when they come close again.
+// While REDUCED a vehicle costs no wheel casts, drivetrain or anti-roll work, and its
+// body is kinematic: other cars still collide with it.
+// Every VehicleConstraint gets a unique priority, so Jolt saves and restores them in the
+// same order however often they left and re-entered the system, and physics snapshots
+// stay restorable across transitions.
+class VehicleSimulationLod {
+  public:
+    struct Settings {
+        // Vehicles closer than this always run the full simulation
+        float fullDistance = 60.0f;
+        // Vehicles further than this always run the reduced model
+        float reducedDistance = 90.0f;
+        // Vehicles outside the camera frustum are reduced from this distance on
+        float hiddenDistance = 30.0f;
+        // Longitudinal model of the reduced path, in m/s^2 and 1/m
+        float maxAcceleration = 8.0f;
+        float brakeDeceleration = 12.0f;
+        float drag = 0.004f;
+    };
+
+    struct Stats {
+        uint32_t full = 0;
+        uint32_t reduced = 0;
+        uint32_t transitions = 0;
+    };
+
+    VehicleSimulationLod() = default;
+    explicit VehicleSimulationLod(const Settings &settings) : settings(settings) {}
+
+    void Update(ES::Engine::Core &core, float deltaTime);
+
+    // Moves a vehicle to the given level and model state at once, used to restore a snapshot
+    void SetLevel(ES::Engine::Core &core, entt::entity entity, SimulationLod::Level level, float speed,
+                  float yawRate);
+
+    inline Settings &GetSettings() { return settings; }
+    inline const Stats &GetStats() const { return stats; }
+
+  private:
+    Settings settings;
+    Stats stats;
+};
+
+void UpdateVehicleSimulationLod(ES::Engine::Core &core);
@@ -0,0 +1,83 @@
+#include "WheelCollisionTester.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "WheeledVehicle3D.hpp"
+
+#include <Jolt/Physics/Vehicle/VehicleConstraint.h>
+
+#include <algorithm>
+
+std::string_view ToString(WheelCollisionTesterType type)
+{
+    switch (type)
+    {
+    case WheelCollisionTesterType::RAY: return "ray";
+    case WheelCollisionTesterType::CAST_SPHERE: return "cast_sphere";
+    case WheelCollisionTesterType::CAST_CYLINDER: return "cast_cylinder";
+    }
+    return "unknown";
+}
+
+std::optional<WheelCollisionTesterType> ParseWheelCollisionTesterType(std::string_view name)
+{
+    for (WheelCollisionTesterType type : WHEEL_COLLISION_TESTER_TYPES)
+    {
+        if (ToString(type) == name)
+            return type;
+    }
+    return std::nullopt;
+}
+
+JPH::Ref<JPH::VehicleCollisionTester> CreateWheelCollisionTester(const WheelCollisionTesterSettings &settings,
+                                                                 JPH::ObjectLayer vehicleLayer, float wheelRadius)
+{
+    const JPH::ObjectLayer layer =
+        settings.objectLayer != JPH::cObjectLayerInvalid ? settings.objectLayer : vehicleLayer;
+
+    JPH::Ref<JPH::VehicleCollisionTester> tester;
+    switch (settings.type)
+    {
+    case WheelCollisionTesterType::RAY:
+        tester = new JPH::VehicleCollisionTesterRay(layer, settings.up, settings.maxSlopeAngle);
+        break;
+    case WheelCollisionTesterType::CAST_SPHERE:
+        tester = new JPH::VehicleCollisionTesterCastSphere(
+            layer, settings.sphereRadius > 0.0f ? settings.sphereRadius : wheelRadius, settings.up,
+            settings.maxSlopeAngle);
+        break;
+    case WheelCollisionTesterType::CAST_CYLINDER:
+        tester = new JPH::VehicleCollisionTesterCastCylinder(layer, settings.convexRadiusFraction);
+        break;
+    }
+
+    if (settings.broadPhaseLayerFilter != nullptr)
+        tester->SetBroadPhaseLayerFilter(settings.broadPhaseLayerFilter);
+    if (settings.objectLayerFilter != nullptr)
+        tester->SetObjectLayerFilter(settings.objectLayerFilter);
+    if (settings.bodyFilter != nullptr)
+        tester->SetBodyFilter(settings.bodyFilter);
+    return tester;
+}
+
+void SetWheelCollisionTester(ES::Engine::Core &core, ES::Engine::Entity vehicle,
+                             const WheelCollisionTesterSettings &settings)
+{
+    if (!vehicle.HasComponents<ES::Plugin::Physics::Component::WheeledVehicle3D,
+                               ES::Plugin::Physics::Component::RigidBody3D>(core))
+    {
+        ES::Utils::Log::Error(fmt::format("SetWheelCollisionTester: entity {} is not a vehicle",
+                                          static_cast<uint32_t>(vehicle)));
+        return;
+    }
+    auto &wheeledVehicle = vehicle.GetComponents<ES::Plugin::Physics::Component::WheeledVehicle3D>(core);
+    auto &rigidBody = vehicle.GetComponents<ES::Plugin::Physics::Component::RigidBody3D>(core);
+
+    // The sphere defaults to the largest wheel, so it never reaches past any tyre
+    float wheelRadius = 0.0f;
+    for (const JPH::Wheel *wheel : wheeledVehicle.vehicleConstraint->GetWheels())
+        wheelRadius = std::max(wheelRadius, wheel->GetSettings()->mRadius);
+
+    wheeledVehicle.vehicleConstraint->SetVehicleCollisionTester(
+        CreateWheelCollisionTester(settings, rigidBody.body->GetObjectLayer(), wheelRadius));
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Engine.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Vehicle/VehicleCollisionTester.h>
+
+#include <array>
+#include <optional>
+#include <string_view>
+
+// Jolt's wheel-versus-world testers, from cheapest to smoothest
+enum class WheelCollisionTesterType {
+    RAY,
+    CAST_SPHERE,
+    CAST_CYLINDER,
+};
+
+constexpr std::array<WheelCollisionTesterType, 3> WHEEL_COLLISION_TESTER_TYPES = {
+    WheelCollisionTesterType::RAY,
+    WheelCollisionTesterType::CAST_SPHERE,
+    WheelCollisionTesterType::CAST_CYLINDER,
+};
+
+struct WheelCollisionTesterSettings {
+    WheelCollisionTesterType type = WheelCollisionTesterType::RAY;
+    // Layer the wheels collide as, the vehicle body's layer when left unset
+    JPH::ObjectLayer objectLayer = JPH::cObjectLayerInvalid;
+    // Ray and sphere: slopes steeper than this relative to up give no contact
+    JPH::Vec3 up = JPH::Vec3::sAxisY();
+    float maxSlopeAngle = JPH::DegreesToRadians(80.0f);
+    // Sphere: radius of the cast sphere, the wheel radius when 0
+    float sphereRadius = 0.0f;
+    // Cylinder: fraction of the wheel radius rounded off the cylinder edges
+    float convexRadiusFraction = 0.1f;
+    // Optional filters, not owned: they must outlive the vehicle
+    const JPH::BroadPhaseLayerFilter *broadPhaseLayerFilter = nullptr;
+    const JPH::ObjectLayerFilter *objectLayerFilter = nullptr;
+    const JPH::BodyFilter *bodyFilter = nullptr;
+};
+
+std::string_view ToString(WheelCollisionTesterType type);
+std::optional<WheelCollisionTesterType> ParseWheelCollisionTesterType(std::string_view name);
+
+JPH::Ref<JPH::VehicleCollisionTester> CreateWheelCollisionTester(const WheelCollisionTesterSettings &settings,
+                                                                 JPH::ObjectLayer vehicleLayer, float wheelRadius);
+
+// Replaces the collision tester of a vehicle built by WheeledVehicleBuilder
+void SetWheelCollisionTester(ES::Engine::Core &core, ES::Engine::Entity vehicle,
+                             const WheelCollisionTesterSettings &settings);
@@ -0,0 +1,32 @@
+#include "WheelContact.hpp"
+
+#include "JoltGlm.hpp"
+
+#include <cmath>
+
+WheelContact GetWheelContact(const JPH::Body &vehicleBody, const JPH::Wheel &wheel)
+{
+    WheelContact contact;
+    if (!wheel.HasContact())
+        return contact;
+
+    contact.hasContact = true;
+    contact.position = ToGlm(wheel.GetContactPosition());
+    contact.normal = ToGlm(wheel.GetContactNormal());
+    contact.longitudinal = ToGlm(wheel.GetContactLongitudinal());
+    contact.lateral = ToGlm(wheel.GetContactLateral());
+    contact.groundBody = wheel.GetContactBodyID();
+    contact.groundSubShape = wheel.GetContactSubShapeID();
+
+    // GetContactPointVelocity is the ground's own velocity, non zero on moving platforms
+    const JPH::Vec3 relative =
+        vehicleBody.GetPointVelocity(wheel.GetContactPosition()) - wheel.GetContactPointVelocity();
+    contact.velocity = ToGlm(relative);
+
+    // A rolling tyre's tread moves at angular velocity * radius, anything else slides
+    const float treadSpeed = wheel.GetAngularVelocity() * wheel.GetSettings()->mRadius;
+    const float longitudinalSlip = relative.Dot(wheel.GetContactLongitudinal()) - treadSpeed;
+    const float lateralSlip = relative.Dot(wheel.GetContactLateral());
+    contact.slipSpeed = std::sqrt(longitudinalSlip * longitudinalSlip + lateralSlip * lateralSlip);
+    return contact;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/Body.h>
+#include <Jolt/Physics/Vehicle/Wheel.h>
+
+#include <glm/glm.hpp>
+
+// Where a wheel touches the ground and how fast its tyre slides there
+struct WheelContact {
+    bool hasContact = false;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 longitudinal = glm::vec3(0.0f, 0.0f, 1.0f);
+    glm::vec3 lateral = glm::vec3(-1.0f, 0.0f, 0.0f);
+    // Velocity of the car at the contact point, relative to the ground
+    glm::vec3 velocity = glm::vec3(0.0f);
+    // Speed of the tread over the ground: wheelspin, lockup and sideways slide, in m/s
+    float slipSpeed = 0.0f;
+    JPH::BodyID groundBody;
+    JPH::SubShapeID groundSubShape;
+};
+
+WheelContact GetWheelContact(const JPH::Body &vehicleBody, const JPH::Wheel &wheel);
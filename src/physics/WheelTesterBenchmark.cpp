@@ -0,0 +1,292 @@
+#include "WheelTesterBenchmark.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "WheeledVehicle3D.hpp"
+
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Collision/Shape/HeightFieldShape.h>
+#include <Jolt/Physics/Vehicle/VehicleConstraint.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+
+// Rough ground: 16 m square of bumps and gravel, far away from the track
+constexpr uint32_t HEIGHTFIELD_SAMPLES = 128;
+constexpr float HEIGHTFIELD_SPACING = 0.125f;
+constexpr float HEIGHTFIELD_ORIGIN = 1000.0f;
+// Top of the box CreateFloor builds
+constexpr float FLOOR_HEIGHT = 1.0f;
+// 12 m sweep in 2 cm steps, probed with every wheel
+constexpr uint32_t PROBE_COUNT = 600;
+constexpr float PROBE_STEP = 0.02f;
+// Timed passes over the sweep, one per tick, only the first one is used for the quality numbers
+constexpr uint32_t PASS_COUNT = 16;
+// Suspension length the probes would get on ground at the reference height
+constexpr float REST_LENGTH = 0.4f;
+
+// One pass over the sweep with every wheel, timed. The first pass also collects the
+// quality numbers.
+void WheelTesterBenchmark::MeasurePass(JPH::PhysicsSystem &physicsSystem, const JPH::VehicleConstraint &constraint,
+                                       const JPH::Body &vehicleBody, Measurement &measurement)
+{
+    const JPH::Array<JPH::Wheel *> &wheels = constraint.GetWheels();
+    const auto wheelCount = static_cast<uint32_t>(wheels.size());
+    const JPH::Quat rotation = vehicleBody.GetRotation();
+    const JPH::Vec3 step(PROBE_STEP, 0.0f, 0.0f);
+    const auto &surface = measurement.surface;
+    const bool firstPass = measurement.pass == 0;
+    if (firstPass)
+        measurement.lengths.assign(PROBE_COUNT * wheelCount, -1.0f);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t probe = 0; probe < PROBE_COUNT; ++probe)
+    {
+        const JPH::RVec3 bodyPosition = surface.start + step * static_cast<float>(probe);
+        for (uint32_t wheel = 0; wheel < wheelCount; ++wheel)
+        {
+            const JPH::WheelSettings *settings = wheels[wheel]->GetSettings();
+            const JPH::RVec3 origin = bodyPosition + rotation * settings->mPosition;
+            const JPH::Vec3 direction = rotation * settings->mSuspensionDirection;
+
+            JPH::Body *body = nullptr;
+            JPH::SubShapeID subShape;
+            JPH::RVec3 contactPosition;
+            JPH::Vec3 contactNormal;
+            float suspensionLength = 0.0f;
+            const bool hit =
+                measurement.tester->Collide(physicsSystem, constraint, wheel, origin, direction, vehicleBody.GetID(),
+                                            body, subShape, contactPosition, contactNormal, suspensionLength);
+            if (!firstPass || !hit)
+                continue;
+
+            measurement.contacts++;
+            measurement.lengths[probe * wheelCount + wheel] = suspensionLength;
+            measurement.normalAngle += std::acos(std::clamp(contactNormal.Dot(-direction), -1.0f, 1.0f));
+            if (surface.groundHeight.has_value())
+            {
+                const float expected = static_cast<float>(origin.GetY()) - *surface.groundHeight - settings->mRadius;
+                measurement.lengthError += std::abs(suspensionLength - expected);
+            }
+        }
+    }
+    measurement.elapsedNanoseconds +=
+        std::chrono::duration<float, std::nano>(std::chrono::steady_clock::now() - start).count();
+    measurement.pass++;
+}
+
+WheelTesterBenchmark::Result WheelTesterBenchmark::ToResult(const Measurement &measurement, uint32_t wheelCount)
+{
+    const auto &lengths = measurement.lengths;
+    float jitter = 0.0f;
+    uint32_t jitterSamples = 0;
+    for (uint32_t probe = 1; probe < PROBE_COUNT; ++probe)
+    {
+        for (uint32_t wheel = 0; wheel < wheelCount; ++wheel)
+        {
+            const float previous = lengths[(probe - 1) * wheelCount + wheel];
+            const float current = lengths[probe * wheelCount + wheel];
+            if (previous < 0.0f || current < 0.0f)
+                continue;
+            jitter += std::abs(current - previous);
+            jitterSamples++;
+        }
+    }
+
+    const uint32_t probes = PROBE_COUNT * wheelCount;
+    const uint32_t contacts = measurement.contacts;
+    Result result;
+    result.surface = measurement.surface.name;
+    result.tester = measurement.type;
+    result.nanosecondsPerWheel = measurement.elapsedNanoseconds / (PASS_COUNT * probes);
+    result.contactRatio = static_cast<float>(contacts) / probes;
+    result.meanLengthError = contacts > 0 ? measurement.lengthError / contacts : 0.0f;
+    result.meanLengthJitter = jitterSamples > 0 ? jitter / jitterSamples : 0.0f;
+    result.meanNormalAngle = contacts > 0 ? JPH::RadiansToDegrees(measurement.normalAngle / contacts) : 0.0f;
+    return result;
+}
+
+static JPH::BodyID CreateRoughGround(JPH::BodyInterface &bodyInterface)
+{
+    // Long bumps plus a few centimeters of gravel, the same every run
+    std::vector<float> samples(HEIGHTFIELD_SAMPLES * HEIGHTFIELD_SAMPLES);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> gravel(-0.03f, 0.03f);
+    for (uint32_t z = 0; z < HEIGHTFIELD_SAMPLES; ++z)
+    {
+        for (uint32_t x = 0; x < HEIGHTFIELD_SAMPLES; ++x)
+        {
+            samples[z * HEIGHTFIELD_SAMPLES + x] = 0.06f * std::sin(x * HEIGHTFIELD_SPACING * 1.7f) *
+                                                       std::cos(z * HEIGHTFIELD_SPACING * 1.3f) +
+                                                   gravel(random);
+        }
+    }
+
+    JPH::HeightFieldShapeSettings settings(samples.data(), JPH::Vec3::sZero(),
+                                           JPH::Vec3(HEIGHTFIELD_SPACING, 1.0f, HEIGHTFIELD_SPACING),
+                                           HEIGHTFIELD_SAMPLES);
+    JPH::ShapeSettings::ShapeResult shape = settings.Create();
+    if (shape.HasError())
+    {
+        ES::Utils::Log::Error(fmt::format("Wheel tester benchmark: heightfield failed: {}", shape.GetError().c_str()));
+        return JPH::BodyID();
+    }
+    JPH::BodyCreationSettings bodySettings(shape.Get(), JPH::RVec3(HEIGHTFIELD_ORIGIN, 0.0f, HEIGHTFIELD_ORIGIN),
+                                           JPH::Quat::sIdentity(), JPH::EMotionType::Static,
+                                           ES::Plugin::Physics::Utils::Layers::NON_MOVING);
+    return bodyInterface.CreateAndAddBody(bodySettings, JPH::EActivation::DontActivate);
+}
+
+bool WheelTesterBenchmark::Start(ES::Engine::Core &core) const
+{
+    bool found = false;
+    core.GetRegistry()
+        .view<ES::Plugin::Physics::Component::WheeledVehicle3D, ES::Plugin::Physics::Component::RigidBody3D>()
+        .each([&](entt::entity entity, auto &wheeledVehicle, auto &rigidBody) {
+            if (!found && wheeledVehicle.vehicleConstraint != nullptr && rigidBody.body != nullptr)
+            {
+                vehicle = entity;
+                found = true;
+            }
+        });
+    if (!found)
+        return false;
+
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+    const JPH::VehicleConstraint &constraint =
+        *core.GetRegistry().get<ES::Plugin::Physics::Component::WheeledVehicle3D>(vehicle).vehicleConstraint;
+    const JPH::Body &vehicleBody = *core.GetRegistry().get<ES::Plugin::Physics::Component::RigidBody3D>(vehicle).body;
+
+    roughGround = CreateRoughGround(physicsSystem.GetBodyInterface());
+    if (roughGround.IsInvalid())
+    {
+        state = State::DONE;
+        return false;
+    }
+
+    // Probes start with the wheel attachments REST_LENGTH plus a wheel radius above the
+    // reference height, and sweep along +X
+    float wheelRadius = 0.0f;
+    float attachmentHeight = 0.0f;
+    for (const JPH::Wheel *wheel : constraint.GetWheels())
+    {
+        wheelRadius = std::max(wheelRadius, wheel->GetSettings()->mRadius);
+        attachmentHeight = wheel->GetSettings()->mPosition.GetY();
+    }
+    const float clearance = REST_LENGTH + wheelRadius - attachmentHeight;
+    const float roughStart = HEIGHTFIELD_ORIGIN + 2.0f;
+    const float roughCenter = HEIGHTFIELD_ORIGIN + HEIGHTFIELD_SAMPLES * HEIGHTFIELD_SPACING * 0.5f;
+    const std::array<Surface, 2> surfaces = {
+        Surface{"flat", JPH::RVec3(-6.0f, FLOOR_HEIGHT + clearance, 0.0f), FLOOR_HEIGHT},
+        Surface{"rough", JPH::RVec3(roughStart, clearance, roughCenter), std::nullopt},
+    };
+
+    measurements.clear();
+    for (const Surface &surface : surfaces)
+    {
+        for (WheelCollisionTesterType type : WHEEL_COLLISION_TESTER_TYPES)
+        {
+            WheelCollisionTesterSettings settings;
+            settings.type = type;
+            Measurement measurement;
+            measurement.surface = surface;
+            measurement.type = type;
+            measurement.tester = CreateWheelCollisionTester(settings, vehicleBody.GetObjectLayer(), wheelRadius);
+            measurements.push_back(std::move(measurement));
+        }
+    }
+    current = 0;
+    state = State::RUNNING;
+    ES::Utils::Log::Info(fmt::format("Wheel tester benchmark: {} passes over {} testers, one pass per tick",
+                                     PASS_COUNT * measurements.size(), measurements.size()));
+    return true;
+}
+
+void WheelTesterBenchmark::Finish(ES::Engine::Core &core) const
+{
+    auto &bodyInterface =
+        core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem().GetBodyInterface();
+    bodyInterface.RemoveBody(roughGround);
+    bodyInterface.DestroyBody(roughGround);
+    roughGround = JPH::BodyID();
+    state = State::DONE;
+
+    for (const Result &result : results)
+    {
+        ES::Utils::Log::Info(fmt::format(
+            "Wheel tester {:>13} on {:<5}: {:7.0f} ns/wheel, {:5.1f}% contact, {:.4f} m error, {:.4f} m jitter, "
+            "{:4.1f} deg normal",
+            ToString(result.tester), result.surface, result.nanosecondsPerWheel, result.contactRatio * 100.0f,
+            result.meanLengthError, result.meanLengthJitter, result.meanNormalAngle));
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(csvPath).parent_path(), ec);
+    std::ofstream file(csvPath, std::ios::trunc);
+    if (!file)
+    {
+        ES::Utils::Log::Warn(fmt::format("Wheel tester benchmark: cannot write {}", csvPath));
+        return;
+    }
+    file << "surface,tester,ns_per_wheel,contact_ratio,mean_length_error,mean_length_jitter,mean_normal_angle_deg\n";
+    for (const Result &result : results)
+    {
+        file << fmt::format("{},{},{:.1f},{:.4f},{:.5f},{:.5f},{:.3f}\n", result.surface, ToString(result.tester),
+                            result.nanosecondsPerWheel, result.contactRatio, result.meanLengthError,
+                            result.meanLengthJitter, result.meanNormalAngle);
+    }
+    ES::Utils::Log::Info(fmt::format("Wheel tester benchmark written to {}", csvPath));
+}
+
+void WheelTesterBenchmark::operator()(ES::Engine::Core &core) const
+{
+    if (state == State::DONE)
+        return;
+    if (state == State::WAITING)
+    {
+        results.clear();
+        Start(core);
+        return;
+    }
+
+    auto &registry = core.GetRegistry();
+    const auto *wheeledVehicle = registry.valid(vehicle)
+                                     ? registry.try_get<ES::Plugin::Physics::Component::WheeledVehicle3D>(vehicle)
+                                     : nullptr;
+    const auto *rigidBody =
+        registry.valid(vehicle) ? registry.try_get<ES::Plugin::Physics::Component::RigidBody3D>(vehicle) : nullptr;
+    if (wheeledVehicle == nullptr || wheeledVehicle->vehicleConstraint == nullptr || rigidBody == nullptr ||
+        rigidBody->body == nullptr)
+    {
+        ES::Utils::Log::Warn("Wheel tester benchmark: the vehicle went away, results are partial");
+        Finish(core);
+        return;
+    }
+
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+    const JPH::VehicleConstraint &constraint = *wheeledVehicle->vehicleConstraint;
+    Measurement &measurement = measurements[current];
+    MeasurePass(physicsSystem, constraint, *rigidBody->body, measurement);
+    if (measurement.pass < PASS_COUNT)
+        return;
+
+    results.push_back(ToResult(measurement, static_cast<uint32_t>(constraint.GetWheels().size())));
+    // The tester and the probe lengths are not needed anymore
+    measurement = Measurement();
+    if (++current == measurements.size())
+        Finish(core);
+}
+
+void RegisterWheelTesterBenchmarkFromEnvironment(ES::Engine::Core &core)
+{
+    if (std::getenv("ES_WHEEL_TESTER_BENCHMARK") == nullptr)
+        return;
+    core.RegisterSystem<ES::Engine::Scheduler::FixedTimeUpdate>(WheelTesterBenchmark());
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Engine.hpp"
+#include "WheelCollisionTester.hpp"
+
+#include <Jolt/Physics/Body/BodyID.h>
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Compares the wheel collision testers on the demo car: every tester probes the same
+// sweep of wheel positions over the flat floor and over a rough heightfield, and
+// reports its cost per wheel and how well the suspension follows the ground.
+// Starts on the first fixed tick where a WheeledVehicle3D exists, then runs one timed
+// pass of one tester per tick, so the run is spread over many ticks instead of
+// stalling a single one.
+class WheelTesterBenchmark
+{
+  public:
+    struct Result {
+        std::string surface;
+        WheelCollisionTesterType tester = WheelCollisionTesterType::RAY;
+        float nanosecondsPerWheel = 0.0f;
+        // Fraction of the probes that found ground within the suspension travel
+        float contactRatio = 0.0f;
+        // Mean distance between the suspension length and the exact one, flat floor only
+        float meanLengthError = 0.0f;
+        // Mean change of suspension length between two neighbouring probes
+        float meanLengthJitter = 0.0f;
+        // Mean angle between the contact normal and up, in degrees
+        float meanNormalAngle = 0.0f;
+    };
+
+    explicit WheelTesterBenchmark(std::string csvPath = "cache/benchmark/wheel_testers.csv")
+        : csvPath(std::move(csvPath))
+    {
+    }
+
+    void operator()(ES::Engine::Core &core) const;
+
+    inline bool IsDone() const { return state == State::DONE; }
+    inline const std::vector<Result> &GetResults() const { return results; }
+
+  private:
+    enum class State {
+        WAITING,
+        RUNNING,
+        DONE,
+    };
+
+    struct Surface {
+        const char *name;
+        JPH::RVec3 start;
+        // Exact ground height, only known on the flat floor
+        std::optional<float> groundHeight;
+    };
+
+    // One tester on one surface, accumulated over its passes
+    struct Measurement {
+        Surface surface;
+        WheelCollisionTesterType type = WheelCollisionTesterType::RAY;
+        JPH::Ref<JPH::VehicleCollisionTester> tester;
+        uint32_t pass = 0;
+        float elapsedNanoseconds = 0.0f;
+        // Quality numbers, from the first pass only
+        std::vector<float> lengths;
+        uint32_t contacts = 0;
+        float lengthError = 0.0f;
+        float normalAngle = 0.0f;
+    };
+
+    static void MeasurePass(JPH::PhysicsSystem &physicsSystem, const JPH::VehicleConstraint &constraint,
+                            const JPH::Body &vehicleBody, Measurement &measurement);
+    static Result ToResult(const Measurement &measurement, uint32_t wheelCount);
+
+    bool Start(ES::Engine::Core &core) const;
+    void Finish(ES::Engine::Core &core) const;
+
+    std::string csvPath;
+    mutable State state = State::WAITING;
+    mutable entt::entity vehicle = entt::null;
+    mutable JPH::BodyID roughGround;
+    mutable std::vector<Measurement> measurements;
+    mutable std::size_t current = 0;
+    mutable std::vector<Result> results;
+};
+
+// Registers a WheelTesterBenchmark when ES_WHEEL_TESTER_BENCHMARK is set
+void RegisterWheelTesterBenchmarkFromEnvironment(ES::Engine::Core &core);
@@ -0,0 +1,294 @@
+#include "LapTiming.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "WheeledVehicle3D.hpp"
+#include "ai/RacingLine.hpp"
+#include "ghost/GhostKeys.hpp"
+#include "ghost/GhostRecorder.hpp"
+#include "physics/JoltGlm.hpp"
+
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+// Gate box: across the track, tall enough for any car, thin along the track
+constexpr float GATE_HALF_WIDTH = 10.0f;
+constexpr float GATE_HALF_HEIGHT = 3.0f;
+constexpr float GATE_HALF_THICKNESS = 0.25f;
+constexpr const char *TIMING_DIRECTORY = "cache/timing";
+
+JPH::ValidateResult LapTiming::Listener::OnContactValidate(const JPH::Body &body1, const JPH::Body &body2,
+                                                           JPH::RVec3Arg baseOffset,
+                                                           const JPH::CollideShapeResult &result)
+{
+    if (previous != nullptr)
+        return previous->OnContactValidate(body1, body2, baseOffset, result);
+    return JPH::ValidateResult::AcceptAllContactsForThisBodyPair;
+}
+
+void LapTiming::Listener::OnContactAdded(const JPH::Body &body1, const JPH::Body &body2,
+                                         const JPH::ContactManifold &manifold, JPH::ContactSettings &settings)
+{
+    if (previous != nullptr)
+        previous->OnContactAdded(body1, body2, manifold, settings);
+    if (!body1.IsSensor() && !body2.IsSensor())
+        return;
+
+    for (uint32_t gate = 0; gate < gates.size(); ++gate)
+    {
+        const JPH::Body *car = body1.GetID() == gates[gate] ? &body2 : body2.GetID() == gates[gate] ? &body1 : nullptr;
+        // Cars on the reduced LOD are kinematic and count as well
+        if (car == nullptr || car->IsStatic())
+            continue;
+        std::lock_guard lock(mutex);
+        crossings.push_back(Crossing{gate, car->GetID(), manifold.mPenetrationDepth});
+        return;
+    }
+}
+
+void LapTiming::Listener::OnContactPersisted(const JPH::Body &body1, const JPH::Body &body2,
+                                             const JPH::ContactManifold &manifold, JPH::ContactSettings &settings)
+{
+    if (previous != nullptr)
+        previous->OnContactPersisted(body1, body2, manifold, settings);
+}
+
+void LapTiming::Listener::OnContactRemoved(const JPH::SubShapeIDPair &pair)
+{
+    if (previous != nullptr)
+        previous->OnContactRemoved(pair);
+}
+
+LapTiming::LapTiming() : listener(std::make_unique<Listener>()) {}
+
+void LapTiming::BuildGates(ES::Engine::Core &core, const RacingLine &line, uint32_t gateCount)
+{
+    Clear(core);
+    if (line.IsEmpty() || gateCount == 0)
+    {
+        ES::Utils::Log::Warn("LapTiming: no racing line, lap timing is disabled");
+        return;
+    }
+
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+    auto &bodyInterface = physicsSystem.GetBodyInterface();
+    if (physicsSystem.GetContactListener() != listener.get())
+    {
+        listener->previous = physicsSystem.GetContactListener();
+        physicsSystem.SetContactListener(listener.get());
+    }
+
+    const JPH::RefConst<JPH::Shape> shape =
+        new JPH::BoxShape(JPH::Vec3(GATE_HALF_WIDTH, GATE_HALF_HEIGHT, GATE_HALF_THICKNESS));
+    for (uint32_t g = 0; g < gateCount; ++g)
+    {
+        const uint32_t sample = g * line.GetSampleCount() / gateCount;
+        const glm::vec3 forward = glm::normalize(line.GetTangent(sample));
+        // The box's thin axis is Z, turned to follow the line
+        const glm::quat rotation = glm::angleAxis(std::atan2(forward.x, forward.z), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        JPH::BodyCreationSettings settings(shape, ToJolt(line.GetPosition(sample)), ToJolt(rotation),
+                                           JPH::EMotionType::Static, ES::Plugin::Physics::Utils::Layers::NON_MOVING);
+        settings.mIsSensor = true;
+        // Static sensors only see dynamic bodies otherwise
+        settings.mCollideKinematicVsNonDynamic = true;
+        const JPH::BodyID body = bodyInterface.CreateAndAddBody(settings, JPH::EActivation::DontActivate);
+        if (body.IsInvalid())
+        {
+            ES::Utils::Log::Error("LapTiming: out of bodies for the timing gates");
+            break;
+        }
+        gates.push_back(Gate{body, forward});
+        listener->gates.push_back(body);
+    }
+    splits.reserve(1024);
+    ES::Utils::Log::Info(fmt::format("LapTiming: {} gates on a {:.0f} m lap", gates.size(), line.GetLength()));
+}
+
+void LapTiming::Clear(ES::Engine::Core &core)
+{
+    if (!splits.empty())
+    {
+        const auto stamp = std::chrono::duration_cast<std::chrono::seconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+        WriteCsv(fmt::format("{}/session_{}.csv", TIMING_DIRECTORY, stamp));
+    }
+
+    auto &physicsSystem = core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem();
+    auto &bodyInterface = physicsSystem.GetBodyInterface();
+    for (const Gate &gate : gates)
+    {
+        bodyInterface.RemoveBody(gate.body);
+        bodyInterface.DestroyBody(gate.body);
+    }
+    if (physicsSystem.GetContactListener() == listener.get())
+        physicsSystem.SetContactListener(listener->previous);
+
+    gates.clear();
+    listener->gates.clear();
+    listener->crossings.clear();
+    cars.clear();
+    splits.clear();
+    time = 0.0;
+}
+
+const LapTiming::Car *LapTiming::GetCar(entt::entity entity) const
+{
+    for (const auto &[body, car] : cars)
+    {
+        if (car.entity == entity)
+            return &car;
+    }
+    return nullptr;
+}
+
+void LapTiming::Cross(ES::Engine::Core &core, Car &car, uint32_t gate, double crossingTime)
+{
+    const auto carId = static_cast<uint32_t>(entt::to_integral(car.entity));
+    const auto gateCount = static_cast<uint32_t>(gates.size());
+
+    if (gate != 0)
+    {
+        if (!car.started)
+            return;
+        // Gates crossed out of order: the lap goes on but does not count
+        if (gate != car.nextGate)
+            car.invalid = true;
+        else
+            splits.push_back(Split{carId, car.lap, static_cast<uint8_t>(gate - 1), !car.invalid,
+                                   static_cast<float>(crossingTime - car.sectorStart)});
+        car.sectorStart = crossingTime;
+        car.nextGate = static_cast<uint8_t>((gate + 1) % gateCount);
+        return;
+    }
+
+    auto &recorder = core.GetResource<GhostRecorder>();
+    const bool recorded = recorder.IsRecording() && static_cast<entt::entity>(recorder.GetVehicle()) == car.entity;
+    if (car.started)
+    {
+        if (car.nextGate != 0)
+            car.invalid = true;
+        else
+            splits.push_back(Split{carId, car.lap, static_cast<uint8_t>(gateCount - 1), !car.invalid,
+                                   static_cast<float>(crossingTime - car.sectorStart)});
+
+        const auto lapTime = static_cast<float>(crossingTime - car.lapStart);
+        splits.push_back(Split{carId, car.lap, LAP, !car.invalid, lapTime});
+        if (car.invalid)
+        {
+            ES::Utils::Log::Info(fmt::format("Car {} lap {}: {:.3f}s, not counted", carId, car.lap, lapTime));
+        }
+        else
+        {
+            car.lastLap = lapTime;
+            car.bestLap = car.bestLap > 0.0f ? std::min(car.bestLap, lapTime) : lapTime;
+            ES::Utils::Log::Info(
+                fmt::format("Car {} lap {}: {:.3f}s, best {:.3f}s", carId, car.lap, lapTime, car.bestLap));
+        }
+    }
+
+    // Ghost laps follow the timing line: valid laps are kept, the others restart
+    if (recorded && car.started && !car.invalid)
+    {
+        FinishGhostLap(core);
+    }
+    else if (recorded)
+    {
+        const ES::Engine::Entity vehicle = recorder.GetVehicle();
+        recorder.Cancel();
+        recorder.Start(vehicle);
+    }
+
+    car.started = true;
+    car.invalid = false;
+    car.lap++;
+    car.lapStart = crossingTime;
+    car.sectorStart = crossingTime;
+    car.nextGate = static_cast<uint8_t>(1 % gateCount);
+}
+
+void LapTiming::Update(ES::Engine::Core &core)
+{
+    if (gates.empty())
+        return;
+
+    const float deltaTime = core.GetScheduler<ES::Engine::Scheduler::FixedTimeUpdate>().GetTickRate();
+    time += deltaTime;
+
+    crossings.clear();
+    {
+        std::lock_guard lock(listener->mutex);
+        std::swap(crossings, listener->crossings);
+    }
+    if (crossings.empty())
+        return;
+
+    auto &registry = core.GetRegistry();
+    const auto &bodyInterface =
+        core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem().GetBodyInterface();
+    for (const Crossing &crossing : crossings)
+    {
+        Car &car = cars[crossing.car.GetIndexAndSequenceNumber()];
+        if (car.entity == entt::null)
+        {
+            registry
+                .view<ES::Plugin::Physics::Component::WheeledVehicle3D, ES::Plugin::Physics::Component::RigidBody3D>()
+                .each([&car, &crossing](entt::entity entity, auto &, auto &rigidBody) {
+                    if (rigidBody.body != nullptr && rigidBody.body->GetID() == crossing.car)
+                        car.entity = entity;
+                });
+            // Anything but a car going through a gate
+            if (car.entity == entt::null)
+            {
+                cars.erase(crossing.car.GetIndexAndSequenceNumber());
+                continue;
+            }
+        }
+
+        // The contact showed up at the end of the step, already penetration deep in
+        // the gate: at the car's speed through it, it entered that long ago
+        const Gate &gate = gates[crossing.gate];
+        const float speed = glm::dot(ToGlm(bodyInterface.GetLinearVelocity(crossing.car)), gate.forward);
+        if (speed <= 0.0f)
+            continue;
+        const double since = std::clamp(crossing.penetration / speed, 0.0f, deltaTime);
+        Cross(core, car, crossing.gate, time - since);
+    }
+}
+
+bool LapTiming::WriteCsv(const std::string &path) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        ES::Utils::Log::Warn(fmt::format("LapTiming: cannot write {}", path));
+        return false;
+    }
+    file << "car,lap,sector,valid,time\n";
+    for (const Split &split : splits)
+    {
+        if (split.sector == LAP)
+            file << fmt::format("{},{},lap,{},{:.4f}\n", split.car, split.lap, split.valid, split.time);
+        else
+            file << fmt::format("{},{},{},{},{:.4f}\n", split.car, split.lap, split.sector + 1, split.valid,
+                                split.time);
+    }
+    ES::Utils::Log::Info(fmt::format("LapTiming: {} splits written to {}", splits.size(), path));
+    return true;
+}
+
+void UpdateLapTiming(ES::Engine::Core &core)
+{
+    core.GetResource<LapTiming>().Update(core);
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "Engine.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+#include <Jolt/Physics/Collision/ContactListener.h>
+
+#include <glm/glm.hpp>
+
+#include <entt/entt.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class RacingLine;
+
+// Lap and sector times on physics time.
+//
+// Gates are Jolt sensor bodies across the track, the first one is the start/finish
+// line. Their contact callbacks report which car entered which gate, so no car is
+// ever tested against a gate on the CPU side. The crossing is placed inside the tick
+// from the penetration depth and the car's speed through the gate, which gives
+// sub-tick times without keeping any history.
+//
+// Every split lands in one flat table for the session, written out as CSV when the
+// session ends.
+class LapTiming
+{
+  public:
+    static constexpr uint8_t LAP = 0xFF;
+
+    // One row of the session table. sector is LAP for a full lap.
+    struct Split {
+        uint32_t car;
+        uint16_t lap;
+        uint8_t sector;
+        uint8_t valid;
+        float time;
+    };
+
+    struct Car {
+        entt::entity entity = entt::null;
+        uint16_t lap = 0;
+        uint8_t nextGate = 0;
+        bool started = false;
+        // A gate was skipped, the lap is not counted
+        bool invalid = false;
+        double lapStart = 0.0;
+        double sectorStart = 0.0;
+        float lastLap = 0.0f;
+        float bestLap = 0.0f;
+    };
+
+    LapTiming();
+
+    LapTiming(LapTiming &&) = default;
+    LapTiming &operator=(LapTiming &&) = default;
+
+    // Places the start/finish line at the first sample of the line and the other
+    // gates evenly along it, and hooks the sensor callbacks
+    void BuildGates(ES::Engine::Core &core, const RacingLine &line, uint32_t gateCount = 3);
+    // Removes the gates and saves the session table
+    void Clear(ES::Engine::Core &core);
+
+    // Turns the crossings reported during this tick's step into splits
+    void Update(ES::Engine::Core &core);
+
+    // Physics time since the gates were built
+    inline double GetTime() const { return time; }
+    const Car *GetCar(entt::entity entity) const;
+    inline const std::vector<Split> &GetSplits() const { return splits; }
+
+    bool WriteCsv(const std::string &path) const;
+
+  private:
+    struct Gate {
+        JPH::BodyID body;
+        // Direction the cars are expected to cross in
+        glm::vec3 forward;
+    };
+
+    struct Crossing {
+        uint32_t gate;
+        JPH::BodyID car;
+        float penetration;
+    };
+
+    // Called on the physics threads: forwards everything to the listener that was
+    // installed before, and queues the gate crossings
+    class Listener final : public JPH::ContactListener
+    {
+      public:
+        JPH::ValidateResult OnContactValidate(const JPH::Body &body1, const JPH::Body &body2,
+                                              JPH::RVec3Arg baseOffset,
+                                              const JPH::CollideShapeResult &result) override;
+        void OnContactAdded(const JPH::Body &body1, const JPH::Body &body2, const JPH::ContactManifold &manifold,
+                            JPH::ContactSettings &settings) override;
+        void OnContactPersisted(const JPH::Body &body1, const JPH::Body &body2,
+                                const JPH::ContactManifold &manifold, JPH::ContactSettings &settings) override;
+        void OnContactRemoved(const JPH::SubShapeIDPair &pair) override;
+
+        JPH::ContactListener *previous = nullptr;
+        // Written on the main thread between steps only
+        std::vector<JPH::BodyID> gates;
+        std::mutex mutex;
+        std::vector<Crossing> crossings;
+    };
+
+    void Cross(ES::Engine::Core &core, Car &car, uint32_t gate, double crossingTime);
+
+    std::vector<Gate> gates;
+    std::unique_ptr<Listener> listener;
+    // Keyed by BodyID::GetIndexAndSequenceNumber
+    std::unordered_map<uint32_t, Car> cars;
+    std::vector<Crossing> crossings;
+    std::vector<Split> splits;
+    double time = 0.0;
+};
+
+void UpdateLapTiming(ES::Engine::Core &core);
@@ -0,0 +1,227 @@
+#include "DynamicAabbTree.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+int32_t DynamicAabbTree::AllocateNode()
+{
+    if (freeList == NULL_NODE)
+    {
+        nodes.emplace_back();
+        return static_cast<int32_t>(nodes.size() - 1);
+    }
+    int32_t index = freeList;
+    freeList = nodes[index].parentOrNext;
+    nodes[index] = Node();
+    return index;
+}
+
+void DynamicAabbTree::FreeNode(int32_t index)
+{
+    nodes[index].parentOrNext = freeList;
+    nodes[index].height = -1;
+    freeList = index;
+}
+
+int32_t DynamicAabbTree::CreateProxy(const Aabb &aabb, uint32_t userData)
+{
+    int32_t proxy = AllocateNode();
+    nodes[proxy].aabb = {aabb.min - glm::vec3(margin), aabb.max + glm::vec3(margin)};
+    nodes[proxy].userData = userData;
+    nodes[proxy].height = 0;
+    InsertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+}
+
+void DynamicAabbTree::DestroyProxy(int32_t proxy)
+{
+    assert(nodes[proxy].IsLeaf());
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    proxyCount--;
+}
+
+bool DynamicAabbTree::MoveProxy(int32_t proxy, const Aabb &aabb)
+{
+    if (nodes[proxy].aabb.Contains(aabb))
+        return false;
+
+    RemoveLeaf(proxy);
+    nodes[proxy].aabb = {aabb.min - glm::vec3(margin), aabb.max + glm::vec3(margin)};
+    InsertLeaf(proxy);
+    return true;
+}
+
+void DynamicAabbTree::InsertLeaf(int32_t leaf)
+{
+    if (root == NULL_NODE)
+    {
+        root = leaf;
+        nodes[root].parentOrNext = NULL_NODE;
+        return;
+    }
+
+    // Find the best sibling using the surface area heuristic
+    const Aabb leafAabb = nodes[leaf].aabb;
+    int32_t index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        const Node &node = nodes[index];
+        float area = node.aabb.SurfaceArea();
+        float combinedArea = Aabb::Union(node.aabb, leafAabb).SurfaceArea();
+
+        // Cost of creating a new parent for this node and the new leaf
+        float cost = 2.0f * combinedArea;
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int32_t child) {
+            float childCost = Aabb::Union(leafAabb, nodes[child].aabb).SurfaceArea();
+            if (!nodes[child].IsLeaf())
+                childCost -= nodes[child].aabb.SurfaceArea();
+            return childCost + inheritanceCost;
+        };
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+    int32_t sibling = index;
+
+    int32_t oldParent = nodes[sibling].parentOrNext;
+    int32_t newParent = AllocateNode();
+    nodes[newParent].parentOrNext = oldParent;
+    nodes[newParent].aabb = Aabb::Union(leafAabb, nodes[sibling].aabb);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parentOrNext = newParent;
+    nodes[leaf].parentOrNext = newParent;
+
+    if (oldParent == NULL_NODE)
+        root = newParent;
+    else if (nodes[oldParent].child1 == sibling)
+        nodes[oldParent].child1 = newParent;
+    else
+        nodes[oldParent].child2 = newParent;
+
+    // Walk back up the tree fixing heights and bounds
+    index = nodes[leaf].parentOrNext;
+    while (index != NULL_NODE)
+    {
+        index = Balance(index);
+        int32_t child1 = nodes[index].child1;
+        int32_t child2 = nodes[index].child2;
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[index].aabb = Aabb::Union(nodes[child1].aabb, nodes[child2].aabb);
+        index = nodes[index].parentOrNext;
+    }
+}
+
+void DynamicAabbTree::RemoveLeaf(int32_t leaf)
+{
+    if (leaf == root)
+    {
+        root = NULL_NODE;
+        return;
+    }
+
+    int32_t parent = nodes[leaf].parentOrNext;
+    int32_t grandParent = nodes[parent].parentOrNext;
+    int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent == NULL_NODE)
+    {
+        root = sibling;
+        nodes[sibling].parentOrNext = NULL_NODE;
+        FreeNode(parent);
+        return;
+    }
+
+    // Destroy the parent and connect the sibling to the grand parent
+    if (nodes[grandParent].child1 == parent)
+        nodes[grandParent].child1 = sibling;
+    else
+        nodes[grandParent].child2 = sibling;
+    nodes[sibling].parentOrNext = grandParent;
+    FreeNode(parent);
+
+    int32_t index = grandParent;
+    while (index != NULL_NODE)
+    {
+        index = Balance(index);
+        int32_t child1 = nodes[index].child1;
+        int32_t child2 = nodes[index].child2;
+        nodes[index].aabb = Aabb::Union(nodes[child1].aabb, nodes[child2].aabb);
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        index = nodes[index].parentOrNext;
+    }
+}
+
+// Performs a left or right rotation if node A is imbalanced, returns the new subtree root
+int32_t DynamicAabbTree::Balance(int32_t iA)
+{
+    Node &A = nodes[iA];
+    if (A.IsLeaf() || A.height < 2)
+        return iA;
+
+    int32_t iB = A.child1;
+    int32_t iC = A.child2;
+    Node &B = nodes[iB];
+    Node &C = nodes[iC];
+    int32_t balance = C.height - B.height;
+
+    auto rotateUp = [&](int32_t iUp, Node &up, Node &other, bool upIsChild2) {
+        int32_t iF = up.child1;
+        int32_t iG = up.child2;
+        Node &F = nodes[iF];
+        Node &G = nodes[iG];
+
+        // Swap A and the promoted node
+        up.child1 = iA;
+        up.parentOrNext = A.parentOrNext;
+        A.parentOrNext = iUp;
+
+        if (up.parentOrNext != NULL_NODE)
+        {
+            if (nodes[up.parentOrNext].child1 == iA)
+                nodes[up.parentOrNext].child1 = iUp;
+            else
+                nodes[up.parentOrNext].child2 = iUp;
+        }
+        else
+        {
+            root = iUp;
+        }
+
+        // Keep the taller grandchild under the promoted node
+        int32_t iKeep = F.height > G.height ? iF : iG;
+        int32_t iMove = F.height > G.height ? iG : iF;
+        up.child2 = iKeep;
+        if (upIsChild2)
+            A.child2 = iMove;
+        else
+            A.child1 = iMove;
+        nodes[iMove].parentOrNext = iA;
+
+        A.aabb = Aabb::Union(other.aabb, nodes[iMove].aabb);
+        up.aabb = Aabb::Union(A.aabb, nodes[iKeep].aabb);
+        A.height = 1 + std::max(other.height, nodes[iMove].height);
+        up.height = 1 + std::max(A.height, nodes[iKeep].height);
+    };
+
+    if (balance > 1)
+    {
+        rotateUp(iC, C, B, true);
+        return iC;
+    }
+    if (balance < -1)
+    {
+        rotateUp(iB, B, C, false);
+        return iB;
+    }
+    return iA;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct Aabb {
+    glm::vec3 min;
+    glm::vec3 max;
+
+    inline bool Contains(const Aabb &other) const
+    {
+        return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+    }
+
+    inline float SurfaceArea() const
+    {
+        glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    static inline Aabb Union(const Aabb &a, const Aabb &b) { return {glm::min(a.min, b.min), glm::max(a.max, b.max)}; }
+};
+
+// Bounding volume hierarchy over dynamic proxies (same design as Box2D's b2DynamicTree).
+// Leaves store a "fat" AABB enlarged by a margin, so a proxy moving by a small amount
+// does not touch the tree; only proxies leaving their fat AABB are re-inserted.
+// The tree is kept balanced with AVL-style rotations.
+class DynamicAabbTree {
+  public:
+    static constexpr int32_t NULL_NODE = -1;
+
+    explicit DynamicAabbTree(float margin = 0.5f) : margin(margin) {}
+
+    int32_t CreateProxy(const Aabb &aabb, uint32_t userData);
+    void DestroyProxy(int32_t proxy);
+
+    // Returns true if the proxy was re-inserted in the tree
+    bool MoveProxy(int32_t proxy, const Aabb &aabb);
+
+    inline uint32_t GetUserData(int32_t proxy) const { return nodes[proxy].userData; }
+    inline const Aabb &GetFatAabb(int32_t proxy) const { return nodes[proxy].aabb; }
+    inline uint32_t GetProxyCount() const { return proxyCount; }
+
+    // Walks the tree, calling classify(aabb) on each visited node. classify returns
+    // 0 to cull the subtree, 1 if the subtree must be tested further and 2 if it is
+    // fully accepted. visit(userData) is called for every accepted leaf.
+    // Returns the number of visited nodes.
+    template <typename Classify, typename Visit> uint32_t Query(Classify &&classify, Visit &&visit) const
+    {
+        if (root == NULL_NODE)
+            return 0;
+        uint32_t visited = 0;
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            int32_t index = stack.back();
+            stack.pop_back();
+            const Node &node = nodes[index];
+            visited++;
+            int result = classify(node.aabb);
+            if (result == 0)
+                continue;
+            if (result == 2)
+            {
+                visited += VisitAll(index, visit);
+                continue;
+            }
+            if (node.IsLeaf())
+            {
+                visit(node.userData);
+                continue;
+            }
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+        return visited;
+    }
+
+  private:
+    struct Node {
+        Aabb aabb;
+        uint32_t userData = 0;
+        // Parent when allocated, next free node otherwise
+        int32_t parentOrNext = NULL_NODE;
+        int32_t child1 = NULL_NODE;
+        int32_t child2 = NULL_NODE;
+        int32_t height = 0;
+
+        inline bool IsLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    int32_t AllocateNode();
+    void FreeNode(int32_t index);
+    void InsertLeaf(int32_t leaf);
+    void RemoveLeaf(int32_t leaf);
+    int32_t Balance(int32_t index);
+
+    template <typename Visit> uint32_t VisitAll(int32_t index, Visit &&visit) const
+    {
+        const Node &node = nodes[index];
+        if (node.IsLeaf())
+        {
+            visit(node.userData);
+            return 0;
+        }
+        return 2 + VisitAll(node.child1, visit) + VisitAll(node.child2, visit);
+    }
+
+    float margin;
+    int32_t root = NULL_NODE;
+    int32_t freeList = NULL_NODE;
+    uint32_t proxyCount = 0;
+    std::vector<Node> nodes;
+    mutable std::vector<int32_t> stack;
+};
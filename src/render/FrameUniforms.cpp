@@ -0,0 +1,105 @@
+#include "FrameUniforms.hpp"
+
+#include "Logger.hpp"
+#include "Object.hpp"
+
+static_assert(sizeof(FrameUniforms::FrameBlock) % 16 == 0, "FrameBlock must match the std140 layout");
+static_assert(sizeof(FrameUniforms::MaterialEntry) == 48, "MaterialEntry must match the std140 layout");
+
+void FrameUniforms::Init()
+{
+    glGenBuffers(1, &frameBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, frameBuffer);
+
+    glGenBuffers(1, &materialBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialEntry) * MAX_MATERIALS, nullptr, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, materialBuffer);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameUniforms::Shutdown()
+{
+    glDeleteBuffers(1, &frameBuffer);
+    glDeleteBuffers(1, &materialBuffer);
+    frameBuffer = 0;
+    materialBuffer = 0;
+    materialIndices.clear();
+}
+
+void FrameUniforms::Update(ES::Engine::Core &core)
+{
+    auto &camera = core.GetResource<ES::Plugin::OpenGL::Resource::Camera>();
+
+    frame.view = camera.view;
+    frame.projection = camera.projection;
+    frame.viewProjection = camera.projection * camera.view;
+    frame.camPos = glm::vec4(camera.viewer.getViewPoint(), 1.0f);
+    frame.ambientColor = glm::vec4(0.0f);
+    frame.pointLightCount = glm::ivec4(0);
+
+    // Lights are scene entities shared by every program, not duplicated per shader
+    core.GetRegistry()
+        .view<ES::Plugin::Object::Component::Transform, ES::Plugin::OpenGL::Component::Light>()
+        .each([this](auto, auto &transform, auto &light) {
+            if (light.type == ES::Plugin::OpenGL::Component::Light::Type::AMBIENT)
+            {
+                frame.ambientColor += glm::vec4(light.color, 0.0f);
+                return;
+            }
+            auto &count = frame.pointLightCount.x;
+            if (count >= static_cast<int>(MAX_POINT_LIGHTS))
+                return;
+            frame.pointLights[count].position = glm::vec4(transform.position, 1.0f);
+            frame.pointLights[count].color = glm::vec4(light.color, 1.0f);
+            count++;
+        });
+
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+uint32_t FrameUniforms::GetMaterialIndex(ES::Engine::Core &core, entt::id_type material)
+{
+    if (auto it = materialIndices.find(material); it != materialIndices.end())
+        return it->second;
+
+    auto index = static_cast<uint32_t>(materialIndices.size());
+    if (index >= MAX_MATERIALS)
+    {
+        ES::Utils::Log::Error(fmt::format("FrameUniforms: material table is full ({} entries)", MAX_MATERIALS));
+        return 0;
+    }
+
+    const auto &source = core.GetResource<ES::Plugin::OpenGL::Resource::MaterialCache>().Get(material);
+    MaterialEntry entry;
+    entry.ka = glm::vec4(source.Ka, 0.0f);
+    entry.kd = glm::vec4(source.Kd, 0.0f);
+    entry.ks = glm::vec4(source.Ks, source.Shiness);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, index * sizeof(MaterialEntry), sizeof(MaterialEntry), &entry);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    materialIndices.emplace(material, index);
+    return index;
+}
+
+void InitFrameUniforms(ES::Engine::Core &core)
+{
+    core.GetResource<FrameUniforms>().Init();
+}
+
+void UpdateFrameUniforms(ES::Engine::Core &core)
+{
+    core.GetResource<FrameUniforms>().Update(core);
+}
+
+void ShutdownFrameUniforms(ES::Engine::Core &core)
+{
+    core.GetResource<FrameUniforms>().Shutdown();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Core.hpp"
+#include "OpenGL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+
+// Owns the std140 uniform blocks shared by every demo program:
+// - "Frame" (binding FRAME_BLOCK_BINDING): camera and lights, written once per frame
+// - "Materials" (binding MATERIAL_BLOCK_BINDING): material table, written when a material is first used
+// Programs only declare the blocks with the matching layout(binding = N), no per-program setup is needed.
+class FrameUniforms {
+  public:
+    static constexpr GLuint FRAME_BLOCK_BINDING = 1;
+    static constexpr GLuint MATERIAL_BLOCK_BINDING = 2;
+    static constexpr uint32_t MAX_POINT_LIGHTS = 8;
+    static constexpr uint32_t MAX_MATERIALS = 256;
+
+    struct PointLight {
+        glm::vec4 position;
+        glm::vec4 color;
+    };
+
+    // Mirrors the "Frame" block, std140
+    struct FrameBlock {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;
+        glm::vec4 camPos;
+        glm::vec4 ambientColor;
+        glm::ivec4 pointLightCount;
+        PointLight pointLights[MAX_POINT_LIGHTS];
+    };
+
+    // Mirrors one entry of the "Materials" block, std140. ks.w holds the shininess.
+    struct MaterialEntry {
+        glm::vec4 ka;
+        glm::vec4 kd;
+        glm::vec4 ks;
+    };
+
+    FrameUniforms() = default;
+    FrameUniforms(FrameUniforms &&) = default;
+    FrameUniforms &operator=(FrameUniforms &&) = default;
+
+    // Must be called once a GL context exists
+    void Init();
+    void Shutdown();
+
+    // Gathers camera and light entities and uploads the frame block
+    void Update(ES::Engine::Core &core);
+
+    // Index of the material in the material table, uploading it on first use
+    uint32_t GetMaterialIndex(ES::Engine::Core &core, entt::id_type material);
+
+    inline const FrameBlock &GetFrameBlock() const { return frame; }
+
+  private:
+    GLuint frameBuffer = 0;
+    GLuint materialBuffer = 0;
+    FrameBlock frame = {};
+    std::unordered_map<entt::id_type, uint32_t> materialIndices;
+};
+
+void InitFrameUniforms(ES::Engine::Core &core);
+
+void UpdateFrameUniforms(ES::Engine::Core &core);
+
+void ShutdownFrameUniforms(ES::Engine::Core &core);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "DynamicAabbTree.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+// View frustum as six inward-facing planes, extracted from a view-projection matrix
+struct Frustum {
+    enum class Result {
+        OUTSIDE = 0,
+        INTERSECT = 1,
+        INSIDE = 2,
+    };
+
+    std::array<glm::vec4, 6> planes;
+
+    explicit Frustum(const glm::mat4 &viewProjection)
+    {
+        auto row = [&viewProjection](int i) {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+        planes[0] = row(3) + row(0); // left
+        planes[1] = row(3) - row(0); // right
+        planes[2] = row(3) + row(1); // bottom
+        planes[3] = row(3) - row(1); // top
+        planes[4] = row(3) + row(2); // near
+        planes[5] = row(3) - row(2); // far
+        for (auto &plane : planes)
+            plane /= glm::length(glm::vec3(plane));
+    }
+
+    Result Classify(const Aabb &aabb) const
+    {
+        Result result = Result::INSIDE;
+        for (const auto &plane : planes)
+        {
+            glm::vec3 normal(plane);
+            // Corner furthest along the plane normal, and the opposite one
+            glm::vec3 positive = glm::mix(aabb.min, aabb.max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+            glm::vec3 negative = glm::mix(aabb.max, aabb.min, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+            if (glm::dot(normal, positive) + plane.w < 0.0f)
+                return Result::OUTSIDE;
+            if (glm::dot(normal, negative) + plane.w < 0.0f)
+                result = Result::INTERSECT;
+        }
+        return result;
+    }
+};
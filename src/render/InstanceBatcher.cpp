@@ -0,0 +1,246 @@
+#include "InstanceBatcher.hpp"
+
+#include "Logger.hpp"
+#include "FrameUniforms.hpp"
+#include "InstancedModel.hpp"
+#include "MeshBuffer.hpp"
+#include "RenderCulling.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+// Upper bound on how long the CPU waits for the GPU to release a region
+constexpr GLuint64 FENCE_TIMEOUT_NS = 1'000'000'000;
+
+void InstanceBatcher::Init()
+{
+    // The instance index attribute reads a buffer of that many integers
+    maxInstances = std::min(maxInstances, MeshBuffer::INSTANCE_INDEX_CAPACITY);
+
+    GLint alignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    regionSize = maxInstances * sizeof(InstanceData);
+    regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, regionSize * FRAME_REGIONS, nullptr, flags);
+    mappedInstances = static_cast<uint8_t *>(
+        glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, regionSize * FRAME_REGIONS, flags));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glGenBuffers(1, &commandBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferStorage(GL_DRAW_INDIRECT_BUFFER, maxInstances * sizeof(DrawCommand) * FRAME_REGIONS, nullptr, flags);
+    mappedCommands = static_cast<DrawCommand *>(
+        glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, maxInstances * sizeof(DrawCommand) * FRAME_REGIONS, flags));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    if (mappedInstances == nullptr || mappedCommands == nullptr)
+        ES::Utils::Log::Error("InstanceBatcher: failed to map the instance or command buffer");
+}
+
+void InstanceBatcher::Shutdown()
+{
+    for (auto &fence : regionFences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (instanceBuffer != 0)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glDeleteBuffers(1, &instanceBuffer);
+        instanceBuffer = 0;
+        mappedInstances = nullptr;
+    }
+    if (commandBuffer != 0)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glDeleteBuffers(1, &commandBuffer);
+        commandBuffer = 0;
+        mappedCommands = nullptr;
+    }
+    batches.clear();
+    batchIndices.clear();
+}
+
+void InstanceBatcher::Collect(ES::Engine::Core &core, const std::vector<entt::entity> &entities)
+{
+    for (auto &batch : batches)
+        batch.instances.clear();
+
+    auto &frameUniforms = core.GetResource<FrameUniforms>();
+    auto &meshBuffer = core.GetResource<MeshBuffer>();
+    auto view = core.GetRegistry()
+                    .view<ES::Plugin::Object::Component::Transform, ES::Plugin::Object::Component::Mesh,
+                          InstancedModel>();
+
+    for (auto entity : entities)
+    {
+        if (!view.contains(entity))
+            continue;
+        auto [transform, mesh, instancedModel] = view.get(entity);
+
+        BatchKey key{instancedModel.modelId, instancedModel.shaderId, instancedModel.materialId};
+        auto [it, inserted] = batchIndices.try_emplace(key, batches.size());
+        if (inserted)
+            batches.push_back(Batch{key, {}, 0, frameUniforms.GetMaterialIndex(core, key.material)});
+        auto &batch = batches[it->second];
+        // Uploads the mesh again if it was released since the batch was created
+        if (batch.instances.empty())
+            meshBuffer.Acquire(key.model, mesh);
+
+        glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), transform.position) *
+                                glm::mat4_cast(transform.rotation) * glm::scale(glm::mat4(1.0f), transform.scale);
+        glm::mat4 normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(modelMatrix))));
+        batch.instances.push_back({modelMatrix, normalMatrix, glm::uvec4(batch.materialIndex, 0, 0, 0)});
+    }
+}
+
+void InstanceBatcher::Draw(ES::Engine::Core &core)
+{
+    DrawBatches(core, nullptr, 1);
+}
+
+void InstanceBatcher::Draw(ES::Engine::Core &core, ES::Plugin::OpenGL::Utils::ShaderProgram &program, uint32_t copies)
+{
+    DrawBatches(core, &program, copies);
+}
+
+void InstanceBatcher::DrawBatches(ES::Engine::Core &core, ES::Plugin::OpenGL::Utils::ShaderProgram *program,
+                                  uint32_t copies)
+{
+    stats = {};
+    if (mappedInstances == nullptr || mappedCommands == nullptr)
+        return;
+
+    GLsync &fence = regionFences[currentRegion];
+    if (fence != nullptr)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    const auto &meshBuffer = core.GetResource<MeshBuffer>();
+
+    // Pack every batch contiguously into this frame's region
+    auto *region = reinterpret_cast<InstanceData *>(mappedInstances + currentRegion * regionSize);
+    uint32_t written = 0;
+    drawOrder.clear();
+    for (uint32_t i = 0; i < batches.size(); ++i)
+    {
+        auto &batch = batches[i];
+        auto count = std::min<std::size_t>(batch.instances.size(), maxInstances - written);
+        if (count < batch.instances.size())
+        {
+            ES::Utils::Log::Warn(fmt::format("InstanceBatcher: more than {} instances, dropping {}", maxInstances,
+                                             batch.instances.size() - count));
+            batch.instances.resize(count);
+        }
+        batch.firstInstance = written;
+        std::memcpy(region + written, batch.instances.data(), count * sizeof(InstanceData));
+        written += static_cast<uint32_t>(count);
+
+        const MeshAllocation *mesh = meshBuffer.Find(batch.key.model);
+        if (count > 0 && mesh != nullptr && mesh->indexCount > 0)
+            drawOrder.push_back(i);
+    }
+    if (drawOrder.empty())
+        return;
+
+    // One multi-draw per run of batches sharing a program and a vertex layout
+    auto drawKey = [&](uint32_t batch) {
+        return std::make_pair(program == nullptr ? batches[batch].key.shader : entt::id_type{0},
+                              meshBuffer.Find(batches[batch].key.model)->layout);
+    };
+    std::sort(drawOrder.begin(), drawOrder.end(),
+              [&](uint32_t lhs, uint32_t rhs) { return drawKey(lhs) < drawKey(rhs); });
+
+    DrawCommand *commands = mappedCommands + currentRegion * maxInstances;
+    for (uint32_t i = 0; i < drawOrder.size(); ++i)
+    {
+        const auto &batch = batches[drawOrder[i]];
+        const MeshAllocation &mesh = *meshBuffer.Find(batch.key.model);
+        const auto instanceCount = static_cast<uint32_t>(batch.instances.size()) * copies;
+        commands[i] = DrawCommand{mesh.indexCount, instanceCount, mesh.firstIndex,
+                                  static_cast<GLint>(mesh.baseVertex), batch.firstInstance};
+        stats.instances += instanceCount;
+        stats.triangles += static_cast<uint64_t>(mesh.indexCount / 3) * instanceCount;
+    }
+    stats.commands = static_cast<uint32_t>(drawOrder.size());
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, INSTANCE_BUFFER_BINDING, instanceBuffer,
+                      currentRegion * regionSize, regionSize);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+
+    auto &shaderManager = core.GetResource<ES::Plugin::OpenGL::Resource::ShaderManager>();
+    ES::Plugin::OpenGL::Utils::ShaderProgram *sp = program;
+    if (sp != nullptr)
+        sp->Use();
+    for (uint32_t first = 0; first < drawOrder.size();)
+    {
+        const auto key = drawKey(drawOrder[first]);
+        uint32_t last = first + 1;
+        while (last < drawOrder.size() && drawKey(drawOrder[last]) == key)
+            ++last;
+
+        if (program == nullptr)
+        {
+            if (sp != nullptr)
+                sp->Disable();
+            sp = &shaderManager.Get(key.first);
+            sp->Use();
+        }
+
+        glBindVertexArray(meshBuffer.GetVertexArray(key.second));
+        // Every `copies` consecutive instances read the same instance data
+        if (copies > 1)
+            glVertexBindingDivisor(MeshBuffer::INSTANCE_INDEX_BINDING, copies);
+        const std::size_t offset = (static_cast<std::size_t>(currentRegion) * maxInstances + first) *
+                                   sizeof(DrawCommand);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void *>(offset),
+                                    static_cast<GLsizei>(last - first), 0);
+        if (copies > 1)
+            glVertexBindingDivisor(MeshBuffer::INSTANCE_INDEX_BINDING, 1);
+
+        stats.drawCalls++;
+        first = last;
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    if (sp != nullptr)
+        sp->Disable();
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    currentRegion = (currentRegion + 1) % FRAME_REGIONS;
+}
+
+void InitInstanceBatcher(ES::Engine::Core &core)
+{
+    core.GetResource<InstanceBatcher>().Init();
+}
+
+void RenderInstanceBatches(ES::Engine::Core &core)
+{
+    auto &batcher = core.GetResource<InstanceBatcher>();
+    batcher.Collect(core, core.GetResource<RenderCulling>().GetVisible());
+    batcher.Draw(core);
+}
+
+void ShutdownInstanceBatcher(ES::Engine::Core &core)
+{
+    core.GetResource<InstanceBatcher>().Shutdown();
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Core.hpp"
+#include "Object.hpp"
+#include "OpenGL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Groups InstancedModel entities by (model, shader, material) into batches, and draws
+// all the batches sharing a shader with one glMultiDrawElementsIndirect: the meshes
+// live in the MeshBuffer's shared buffers, and materials are per instance. Instance
+// data and draw commands are written into persistently mapped buffers split into
+// FRAME_REGIONS regions, fenced so the CPU never overwrites a region the GPU is still
+// reading. Camera, lights and materials come from the FrameUniforms blocks.
+class InstanceBatcher {
+  public:
+    struct InstanceData {
+        glm::mat4 modelMatrix;
+        glm::mat4 normalMatrix;
+        // x: index in the FrameUniforms material table
+        glm::uvec4 params;
+    };
+
+    struct Stats {
+        uint32_t drawCalls = 0;
+        // Indirect commands, one per batch
+        uint32_t commands = 0;
+        uint32_t instances = 0;
+        uint64_t triangles = 0;
+    };
+
+    static constexpr uint32_t FRAME_REGIONS = 3;
+    static constexpr GLuint INSTANCE_BUFFER_BINDING = 0;
+
+    explicit InstanceBatcher(uint32_t maxInstancesPerFrame = 16384) : maxInstances(maxInstancesPerFrame) {}
+
+    InstanceBatcher(InstanceBatcher &&) = default;
+    InstanceBatcher &operator=(InstanceBatcher &&) = default;
+
+    // Must be called once a GL context exists
+    void Init();
+    void Shutdown();
+
+    // Rebuilds the batches from the given InstancedModel entities, usually the
+    // camera-visible set produced by RenderCulling
+    void Collect(ES::Engine::Core &core, const std::vector<entt::entity> &entities);
+    // Uploads the instance data and the draw commands, and issues one draw per shader
+    void Draw(ES::Engine::Core &core);
+    // Same, with one program, so one draw, for every batch and each instance drawn
+    // `copies` times in a row, for depth passes. The copy is gl_InstanceID % copies.
+    void Draw(ES::Engine::Core &core, ES::Plugin::OpenGL::Utils::ShaderProgram &program, uint32_t copies);
+
+    inline const Stats &GetStats() const { return stats; }
+
+  private:
+    // Layout read by glMultiDrawElementsIndirect
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    struct BatchKey {
+        entt::id_type model;
+        entt::id_type shader;
+        entt::id_type material;
+
+        bool operator==(const BatchKey &other) const = default;
+    };
+
+    struct BatchKeyHash {
+        std::size_t operator()(const BatchKey &key) const
+        {
+            std::size_t seed = key.model;
+            seed ^= key.shader + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= key.material + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+
+    struct Batch {
+        BatchKey key;
+        std::vector<InstanceData> instances;
+        uint32_t firstInstance = 0;
+        uint32_t materialIndex = 0;
+    };
+
+    void DrawBatches(ES::Engine::Core &core, ES::Plugin::OpenGL::Utils::ShaderProgram *program, uint32_t copies);
+
+    uint32_t maxInstances;
+    GLuint instanceBuffer = 0;
+    uint8_t *mappedInstances = nullptr;
+    std::size_t regionSize = 0;
+    uint32_t currentRegion = 0;
+    std::array<GLsync, FRAME_REGIONS> regionFences = {};
+    // Same regions and fences as the instances, one command per instance at most
+    GLuint commandBuffer = 0;
+    DrawCommand *mappedCommands = nullptr;
+
+    // Batches are kept across frames so their instance vectors keep their capacity
+    std::vector<Batch> batches;
+    std::unordered_map<BatchKey, std::size_t, BatchKeyHash> batchIndices;
+    // Non-empty batches in draw order
+    std::vector<uint32_t> drawOrder;
+    Stats stats;
+};
+
+void InitInstanceBatcher(ES::Engine::Core &core);
+
+void RenderInstanceBatches(ES::Engine::Core &core);
+
+void ShutdownInstanceBatcher(ES::Engine::Core &core);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+#include <string>
+
+// Replaces the ShaderHandle/MaterialHandle/ModelHandle trio for entities drawn by
+// the InstanceBatcher. Entities sharing the same (model, shader, material) are
+// drawn with a single instanced draw call. The model name identifies the mesh:
+// every entity using a given model name must carry the same Mesh.
+struct InstancedModel {
+    std::string model;
+    std::string shader;
+    std::string material;
+    entt::id_type modelId;
+    entt::id_type shaderId;
+    entt::id_type materialId;
+
+    InstancedModel(const std::string &model_, const std::string &shader_, const std::string &material_)
+        : model(model_), shader(shader_), material(material_),
+          modelId(entt::hashed_string::value(model_.c_str())), shaderId(entt::hashed_string::value(shader_.c_str())),
+          materialId(entt::hashed_string::value(material_.c_str()))
+    {
+    }
+};
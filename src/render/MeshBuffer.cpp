@@ -0,0 +1,268 @@
+#include "MeshBuffer.hpp"
+
+#include "InstancedModel.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+// Attribute locations and vertex buffer binding points of the shared VAOs
+constexpr GLuint POSITION_ATTRIBUTE = 0;
+constexpr GLuint NORMAL_ATTRIBUTE = 1;
+constexpr GLuint INSTANCE_INDEX_ATTRIBUTE = 2;
+constexpr GLuint VERTEX_BINDING = 0;
+
+uint32_t MeshBuffer::GetStride(VertexLayout layout)
+{
+    switch (layout)
+    {
+    case VertexLayout::POSITION_NORMAL:
+    default: return 6 * sizeof(float);
+    }
+}
+
+// An immutable buffer of the given size, optionally starting with the content of
+// another one. The caller deletes the old buffer.
+static GLuint CreateStorage(GLsizeiptr size, GLuint copyFrom, GLsizeiptr copySize)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    if (copyFrom != 0 && copySize > 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, copyFrom);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, copySize);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return buffer;
+}
+
+void MeshBuffer::Init(ES::Engine::Core &core)
+{
+    auto &registry = core.GetRegistry();
+    users.clear();
+    for (auto entity : registry.view<InstancedModel>())
+        OnInstancedModelConstructed(registry, entity);
+    registry.on_construct<InstancedModel>().connect<&MeshBuffer::OnInstancedModelConstructed>(*this);
+    registry.on_destroy<InstancedModel>().connect<&MeshBuffer::OnInstancedModelDestroyed>(*this);
+
+    std::vector<uint32_t> identity(INSTANCE_INDEX_CAPACITY);
+    std::iota(identity.begin(), identity.end(), 0u);
+    glGenBuffers(1, &instanceIndexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceIndexBuffer);
+    glBufferStorage(GL_ARRAY_BUFFER, identity.size() * sizeof(uint32_t), identity.data(), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    for (std::size_t i = 0; i < pools.size(); ++i)
+    {
+        auto &pool = pools[i];
+        const auto layout = static_cast<VertexLayout>(i);
+        pool.vertices = RangeAllocator(initialVertices);
+        pool.indices = RangeAllocator(initialIndices);
+        pool.vertexBuffer = CreateStorage(static_cast<GLsizeiptr>(initialVertices) * GetStride(layout), 0, 0);
+        pool.indexBuffer = CreateStorage(static_cast<GLsizeiptr>(initialIndices) * sizeof(uint32_t), 0, 0);
+        CreateVertexArray(pool, layout);
+    }
+}
+
+void MeshBuffer::Shutdown()
+{
+    for (auto &pool : pools)
+    {
+        glDeleteVertexArrays(1, &pool.vao);
+        glDeleteBuffers(1, &pool.vertexBuffer);
+        glDeleteBuffers(1, &pool.indexBuffer);
+        pool = Pool();
+    }
+    glDeleteBuffers(1, &instanceIndexBuffer);
+    instanceIndexBuffer = 0;
+    allocations.clear();
+}
+
+void MeshBuffer::CreateVertexArray(Pool &pool, VertexLayout layout)
+{
+    glGenVertexArrays(1, &pool.vao);
+    glBindVertexArray(pool.vao);
+
+    switch (layout)
+    {
+    case VertexLayout::POSITION_NORMAL:
+    default:
+        glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+        glVertexAttribFormat(POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(POSITION_ATTRIBUTE, VERTEX_BINDING);
+        glEnableVertexAttribArray(NORMAL_ATTRIBUTE);
+        glVertexAttribFormat(NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
+        glVertexAttribBinding(NORMAL_ATTRIBUTE, VERTEX_BINDING);
+        break;
+    }
+    glBindVertexBuffer(VERTEX_BINDING, pool.vertexBuffer, 0, GetStride(layout));
+
+    glEnableVertexAttribArray(INSTANCE_INDEX_ATTRIBUTE);
+    glVertexAttribIFormat(INSTANCE_INDEX_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0);
+    glVertexAttribBinding(INSTANCE_INDEX_ATTRIBUTE, INSTANCE_INDEX_BINDING);
+    glBindVertexBuffer(INSTANCE_INDEX_BINDING, instanceIndexBuffer, 0, sizeof(uint32_t));
+    glVertexBindingDivisor(INSTANCE_INDEX_BINDING, 1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.indexBuffer);
+    glBindVertexArray(0);
+}
+
+void MeshBuffer::GrowVertices(Pool &pool, VertexLayout layout, uint32_t size)
+{
+    // The appended space alone is enough, whatever is free at the end already
+    uint32_t capacity = std::max(pool.vertices.GetCapacity(), 1u);
+    while (capacity - pool.vertices.GetCapacity() < size)
+        capacity *= 2;
+
+    const GLsizeiptr stride = GetStride(layout);
+    GLuint buffer = CreateStorage(capacity * stride, pool.vertexBuffer, pool.vertices.GetCapacity() * stride);
+    glDeleteBuffers(1, &pool.vertexBuffer);
+    pool.vertexBuffer = buffer;
+    pool.vertices.Grow(capacity);
+
+    glBindVertexArray(pool.vao);
+    glBindVertexBuffer(VERTEX_BINDING, pool.vertexBuffer, 0, static_cast<GLsizei>(stride));
+    glBindVertexArray(0);
+    grows++;
+}
+
+void MeshBuffer::GrowIndices(Pool &pool, uint32_t size)
+{
+    uint32_t capacity = std::max(pool.indices.GetCapacity(), 1u);
+    while (capacity - pool.indices.GetCapacity() < size)
+        capacity *= 2;
+
+    GLuint buffer = CreateStorage(static_cast<GLsizeiptr>(capacity) * sizeof(uint32_t), pool.indexBuffer,
+                                  static_cast<GLsizeiptr>(pool.indices.GetCapacity()) * sizeof(uint32_t));
+    glDeleteBuffers(1, &pool.indexBuffer);
+    pool.indexBuffer = buffer;
+    pool.indices.Grow(capacity);
+
+    // The element buffer binding is part of the VAO state
+    glBindVertexArray(pool.vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.indexBuffer);
+    glBindVertexArray(0);
+    grows++;
+}
+
+const MeshAllocation &MeshBuffer::Acquire(entt::id_type model, const ES::Plugin::Object::Component::Mesh &mesh,
+                                          VertexLayout layout)
+{
+    if (auto it = allocations.find(model); it != allocations.end())
+        return it->second;
+
+    MeshAllocation allocation;
+    allocation.layout = layout;
+    allocation.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    allocation.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    if (allocation.vertexCount == 0 || allocation.indexCount == 0)
+        return allocations.emplace(model, MeshAllocation{layout}).first->second;
+
+    auto &pool = pools[static_cast<std::size_t>(layout)];
+    allocation.baseVertex = pool.vertices.Allocate(allocation.vertexCount);
+    if (allocation.baseVertex == RangeAllocator::INVALID)
+    {
+        GrowVertices(pool, layout, allocation.vertexCount);
+        allocation.baseVertex = pool.vertices.Allocate(allocation.vertexCount);
+    }
+    allocation.firstIndex = pool.indices.Allocate(allocation.indexCount);
+    if (allocation.firstIndex == RangeAllocator::INVALID)
+    {
+        GrowIndices(pool, allocation.indexCount);
+        allocation.firstIndex = pool.indices.Allocate(allocation.indexCount);
+    }
+
+    // Interleaved position/normal, matching the attribute formats of the VAO
+    staging.clear();
+    staging.reserve(mesh.vertices.size() * 6);
+    for (std::size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+        const glm::vec3 normal = i < mesh.normals.size() ? mesh.normals[i] : glm::vec3(0.0f);
+        staging.insert(staging.end(), {mesh.vertices[i].x, mesh.vertices[i].y, mesh.vertices[i].z, normal.x,
+                                       normal.y, normal.z});
+    }
+
+    const GLsizeiptr stride = GetStride(layout);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.vertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.baseVertex * stride, staging.size() * sizeof(float),
+                    staging.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(allocation.firstIndex) * sizeof(uint32_t),
+                    mesh.indices.size() * sizeof(uint32_t), mesh.indices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    return allocations.emplace(model, allocation).first->second;
+}
+
+const MeshAllocation *MeshBuffer::Find(entt::id_type model) const
+{
+    auto it = allocations.find(model);
+    return it != allocations.end() ? &it->second : nullptr;
+}
+
+void MeshBuffer::Release(entt::id_type model)
+{
+    auto it = allocations.find(model);
+    if (it == allocations.end())
+        return;
+
+    // Draws already submitted keep reading the old content: the GL orders the next
+    // glBufferSubData into these ranges after them
+    auto &pool = pools[static_cast<std::size_t>(it->second.layout)];
+    if (it->second.vertexCount > 0 && it->second.indexCount > 0)
+    {
+        pool.vertices.Free(it->second.baseVertex, it->second.vertexCount);
+        pool.indices.Free(it->second.firstIndex, it->second.indexCount);
+    }
+    allocations.erase(it);
+}
+
+void MeshBuffer::OnInstancedModelConstructed(entt::registry &registry, entt::entity entity)
+{
+    users[registry.get<InstancedModel>(entity).modelId]++;
+}
+
+void MeshBuffer::OnInstancedModelDestroyed(entt::registry &registry, entt::entity entity)
+{
+    const entt::id_type model = registry.get<InstancedModel>(entity).modelId;
+    auto it = users.find(model);
+    if (it == users.end() || --it->second > 0)
+        return;
+    users.erase(it);
+    Release(model);
+}
+
+MeshBuffer::Stats MeshBuffer::GetStats() const
+{
+    Stats stats;
+    stats.meshes = static_cast<uint32_t>(allocations.size());
+    stats.grows = grows;
+    for (const auto &pool : pools)
+    {
+        stats.vertexCapacity += pool.vertices.GetCapacity();
+        stats.vertexUsed += pool.vertices.GetUsed();
+        stats.indexCapacity += pool.indices.GetCapacity();
+        stats.indexUsed += pool.indices.GetUsed();
+        stats.freeRanges += pool.vertices.GetFreeRangeCount() + pool.indices.GetFreeRangeCount();
+        stats.fragmentation = std::max(
+            {stats.fragmentation, pool.vertices.GetFragmentation(), pool.indices.GetFragmentation()});
+    }
+    return stats;
+}
+
+void InitMeshBuffer(ES::Engine::Core &core)
+{
+    auto &meshBuffer = core.GetResource<MeshBuffer>();
+    meshBuffer.Init(core);
+    const auto stats = meshBuffer.GetStats();
+    ES::Utils::Log::Info(fmt::format("MeshBuffer: room for {} vertices and {} indices", stats.vertexCapacity,
+                                     stats.indexCapacity));
+}
+
+void ShutdownMeshBuffer(ES::Engine::Core &core)
+{
+    core.GetResource<MeshBuffer>().Shutdown();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Core.hpp"
+#include "Object.hpp"
+#include "OpenGL.hpp"
+#include "RangeAllocator.hpp"
+
+#include <entt/entt.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Vertex formats of the shared buffers. Each one has its own pool and VAO.
+enum class VertexLayout : uint8_t {
+    // vec3 position, vec3 normal: attribute locations 0 and 1
+    POSITION_NORMAL,
+    COUNT,
+};
+
+// Where a mesh lives in its layout's pool, in elements. Indices are relative to
+// baseVertex, as glDrawElementsBaseVertex and the indirect commands expect.
+struct MeshAllocation {
+    VertexLayout layout = VertexLayout::POSITION_NORMAL;
+    uint32_t baseVertex = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+// Every mesh's vertices and indices, sub-allocated from a vertex buffer and an index
+// buffer per layout with a RangeAllocator each. A pool that runs out of space doubles,
+// copying its content on the GPU. Meshes sharing a layout share one VAO, so any
+// number of them can be drawn by a single glMultiDrawElementsIndirect, and
+// releasing a mesh makes its ranges available to the next one. A model is released
+// when the last entity whose InstancedModel names it is destroyed.
+//
+// The VAOs also read attribute location 2, a uint per instance from a buffer of
+// consecutive integers: with the baseInstance of a draw command, it is the index of
+// the instance in the InstanceBatcher's buffer, which GLSL 4.40 has no built-in for.
+class MeshBuffer {
+  public:
+    static constexpr uint32_t INSTANCE_INDEX_CAPACITY = 1u << 16;
+    // Vertex buffer binding point of the instance index, for glVertexBindingDivisor
+    static constexpr GLuint INSTANCE_INDEX_BINDING = 1;
+
+    struct Stats {
+        uint32_t meshes = 0;
+        uint32_t vertexCapacity = 0;
+        uint32_t vertexUsed = 0;
+        uint32_t indexCapacity = 0;
+        uint32_t indexUsed = 0;
+        uint32_t freeRanges = 0;
+        // Of the vertex and index free space, the more scattered one
+        float fragmentation = 0.0f;
+        uint32_t grows = 0;
+    };
+
+    explicit MeshBuffer(uint32_t initialVertices = 1u << 18, uint32_t initialIndices = 1u << 20)
+        : initialVertices(initialVertices), initialIndices(initialIndices)
+    {
+    }
+
+    MeshBuffer(MeshBuffer &&) = default;
+    MeshBuffer &operator=(MeshBuffer &&) = default;
+
+    // Must be called once a GL context exists, starts counting the users of each model
+    void Init(ES::Engine::Core &core);
+    void Shutdown();
+
+    // The allocation of the model, uploading the mesh on first use
+    const MeshAllocation &Acquire(entt::id_type model, const ES::Plugin::Object::Component::Mesh &mesh,
+                                  VertexLayout layout = VertexLayout::POSITION_NORMAL);
+    // nullptr when the model was never acquired or has been released
+    const MeshAllocation *Find(entt::id_type model) const;
+    // Frees the model's ranges, for geometry streamed out
+    void Release(entt::id_type model);
+
+    inline GLuint GetVertexArray(VertexLayout layout) const { return pools[static_cast<std::size_t>(layout)].vao; }
+    Stats GetStats() const;
+
+  private:
+    struct Pool {
+        GLuint vao = 0;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        RangeAllocator vertices;
+        RangeAllocator indices;
+    };
+
+    static uint32_t GetStride(VertexLayout layout);
+
+    void OnInstancedModelConstructed(entt::registry &registry, entt::entity entity);
+    void OnInstancedModelDestroyed(entt::registry &registry, entt::entity entity);
+
+    void CreateVertexArray(Pool &pool, VertexLayout layout);
+    // Doubles the vertex or index buffer until size more elements fit
+    void GrowVertices(Pool &pool, VertexLayout layout, uint32_t size);
+    void GrowIndices(Pool &pool, uint32_t size);
+
+    uint32_t initialVertices;
+    uint32_t initialIndices;
+    std::array<Pool, static_cast<std::size_t>(VertexLayout::COUNT)> pools;
+    GLuint instanceIndexBuffer = 0;
+    std::unordered_map<entt::id_type, MeshAllocation> allocations;
+    // Entities carrying an InstancedModel of each model
+    std::unordered_map<entt::id_type, uint32_t> users;
+    // Interleaved vertices of the mesh being uploaded, kept for its capacity
+    std::vector<float> staging;
+    uint32_t grows = 0;
+};
+
+void InitMeshBuffer(ES::Engine::Core &core);
+
+void ShutdownMeshBuffer(ES::Engine::Core &core);
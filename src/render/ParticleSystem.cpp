@@ -0,0 +1,401 @@
+#include "ParticleSystem.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "WheeledVehicle3D.hpp"
+#include "physics/WheelContact.hpp"
+#include "task/TaskScheduler.hpp"
+
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Math/Vec4.h>
+#include <Jolt/Physics/Collision/PhysicsMaterial.h>
+#include <Jolt/Physics/Vehicle/VehicleConstraint.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string_view>
+
+// Upper bound on how long the CPU waits for the GPU to release a region
+constexpr GLuint64 FENCE_TIMEOUT_NS = 1'000'000'000;
+// Particles per job, a multiple of the SIMD width
+constexpr uint32_t CHUNK_SIZE = 8192;
+
+struct MaterialParams {
+    // Slip speed, in m/s, above which a wheel emits
+    float slipThreshold;
+    // Particles per second for each m/s of slip above the threshold
+    float rate;
+    float lifetimeMin;
+    float lifetimeMax;
+    float sizeMin;
+    float sizeMax;
+    // Size at the end of the life, relative to the start size
+    float growth;
+    float alpha;
+    // Vertical acceleration, smoke rises and dust settles
+    float lift;
+    // Velocity damping rate, per second
+    float drag;
+    // Fraction of the car's velocity the particles start with
+    float inherit;
+    float spread;
+    glm::vec3 tint;
+};
+
+static const std::array<MaterialParams, ParticleSystem::MATERIAL_COUNT> MATERIALS = {{
+    // SMOKE
+    {4.0f, 60.0f, 1.5f, 3.0f, 0.3f, 0.5f, 6.0f, 0.35f, 0.6f, 0.8f, 0.15f, 0.8f, glm::vec3(0.8f, 0.8f, 0.82f)},
+    // DUST
+    {1.5f, 80.0f, 0.6f, 1.4f, 0.2f, 0.4f, 3.5f, 0.5f, -2.0f, 1.5f, 0.3f, 1.5f, glm::vec3(0.55f, 0.45f, 0.3f)},
+}};
+
+// Loose surfaces throw dust instead of smoke. The demo tells them apart by the
+// name given to the Jolt material of the ground.
+static bool IsLooseSurface(const JPH::PhysicsMaterial *material)
+{
+    if (material == nullptr)
+        return false;
+    const std::string_view name = material->GetDebugName();
+    return name == "Dirt" || name == "Grass" || name == "Gravel" || name == "Sand";
+}
+
+static JPH::Vec4 Load(const std::vector<float> &stream, uint32_t index)
+{
+    return JPH::Vec4::sLoadFloat4(reinterpret_cast<const JPH::Float4 *>(&stream[index]));
+}
+
+static void Store(std::vector<float> &stream, uint32_t index, JPH::Vec4Arg value)
+{
+    value.StoreFloat4(reinterpret_cast<JPH::Float4 *>(&stream[index]));
+}
+
+ParticleSystem::ParticleSystem(uint32_t smokeCapacity, uint32_t dustCapacity)
+{
+    const std::array<uint32_t, MATERIAL_COUNT> capacities = {smokeCapacity, dustCapacity};
+    for (uint32_t m = 0; m < MATERIAL_COUNT; ++m)
+    {
+        Pool &pool = pools[m];
+        pool.capacity = (capacities[m] + 3) & ~3u;
+        for (auto *stream : {&pool.positionX, &pool.positionY, &pool.positionZ, &pool.velocityX, &pool.velocityY,
+                             &pool.velocityZ, &pool.age, &pool.inverseLifetime, &pool.startSize, &pool.startAlpha,
+                             &pool.seed, &pool.size, &pool.alpha})
+            stream->assign(pool.capacity, 0.0f);
+    }
+}
+
+void ParticleSystem::Init()
+{
+    GLint alignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    regionSize = (pools[0].capacity + pools[1].capacity) * sizeof(GpuParticle);
+    regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &particleBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, regionSize * FRAME_REGIONS, nullptr, flags);
+    mappedParticles = static_cast<uint8_t *>(
+        glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, regionSize * FRAME_REGIONS, flags));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Quad corners come from gl_VertexID, the core profile still wants a VAO bound
+    glGenVertexArrays(1, &emptyVao);
+
+    if (mappedParticles == nullptr)
+        ES::Utils::Log::Error("ParticleSystem: failed to map the particle buffer");
+}
+
+void ParticleSystem::Shutdown()
+{
+    for (auto &fence : regionFences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (particleBuffer != 0)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glDeleteBuffers(1, &particleBuffer);
+        particleBuffer = 0;
+        mappedParticles = nullptr;
+    }
+    if (emptyVao != 0)
+    {
+        glDeleteVertexArrays(1, &emptyVao);
+        emptyVao = 0;
+    }
+}
+
+void ParticleSystem::Emit(Material material, const glm::vec3 &position, const glm::vec3 &velocity, float size)
+{
+    Pool &pool = pools[static_cast<uint32_t>(material)];
+    if (pool.count >= pool.capacity)
+    {
+        stats.dropped++;
+        return;
+    }
+
+    const MaterialParams &params = MATERIALS[static_cast<uint32_t>(material)];
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const uint32_t i = pool.count++;
+    pool.positionX[i] = position.x;
+    pool.positionY[i] = position.y;
+    pool.positionZ[i] = position.z;
+    pool.velocityX[i] = velocity.x;
+    pool.velocityY[i] = velocity.y;
+    pool.velocityZ[i] = velocity.z;
+    pool.age[i] = 0.0f;
+    pool.inverseLifetime[i] = 1.0f / (params.lifetimeMin + (params.lifetimeMax - params.lifetimeMin) * unit(random));
+    pool.startSize[i] = size;
+    pool.startAlpha[i] = params.alpha;
+    pool.seed[i] = unit(random);
+    pool.size[i] = size;
+    pool.alpha[i] = 0.0f;
+    stats.spawned++;
+}
+
+void ParticleSystem::Simulate(Pool &pool, Material material, uint32_t first, uint32_t last, float deltaTime) const
+{
+    using JPH::Vec4;
+
+    const MaterialParams &params = MATERIALS[static_cast<uint32_t>(material)];
+    const Vec4 dt = Vec4::sReplicate(deltaTime);
+    const Vec4 drag = Vec4::sReplicate(std::exp(-params.drag * deltaTime));
+    const Vec4 lift = Vec4::sReplicate(params.lift * deltaTime);
+    const Vec4 growth = Vec4::sReplicate(params.growth - 1.0f);
+    const Vec4 fadeIn = Vec4::sReplicate(8.0f);
+    const Vec4 one = Vec4::sReplicate(1.0f);
+
+    for (uint32_t i = first; i < last; i += 4)
+    {
+        // Integration
+        const Vec4 velocityX = Load(pool.velocityX, i) * drag;
+        const Vec4 velocityY = (Load(pool.velocityY, i) + lift) * drag;
+        const Vec4 velocityZ = Load(pool.velocityZ, i) * drag;
+        Store(pool.velocityX, i, velocityX);
+        Store(pool.velocityY, i, velocityY);
+        Store(pool.velocityZ, i, velocityZ);
+        Store(pool.positionX, i, Vec4::sFusedMultiplyAdd(velocityX, dt, Load(pool.positionX, i)));
+        Store(pool.positionY, i, Vec4::sFusedMultiplyAdd(velocityY, dt, Load(pool.positionY, i)));
+        Store(pool.positionZ, i, Vec4::sFusedMultiplyAdd(velocityZ, dt, Load(pool.positionZ, i)));
+
+        const Vec4 age = Load(pool.age, i) + dt;
+        Store(pool.age, i, age);
+        const Vec4 life = Vec4::sMin(age * Load(pool.inverseLifetime, i), one);
+
+        // Size over life: grows linearly from the start size
+        Store(pool.size, i, Load(pool.startSize, i) * Vec4::sFusedMultiplyAdd(growth, life, one));
+
+        // Fade: a quick fade in hides the spawn, then a quadratic fade out
+        const Vec4 fadeOut = one - life;
+        Store(pool.alpha, i, Load(pool.startAlpha, i) * Vec4::sMin(life * fadeIn, one) * fadeOut * fadeOut);
+    }
+}
+
+void ParticleSystem::RemoveDead(Pool &pool)
+{
+    const JPH::Vec4 one = JPH::Vec4::sReplicate(1.0f);
+    const auto move = [&pool](uint32_t from, uint32_t to) {
+        for (auto *stream : {&pool.positionX, &pool.positionY, &pool.positionZ, &pool.velocityX, &pool.velocityY,
+                             &pool.velocityZ, &pool.age, &pool.inverseLifetime, &pool.startSize, &pool.startAlpha,
+                             &pool.seed, &pool.size, &pool.alpha})
+            (*stream)[to] = (*stream)[from];
+    };
+
+    // Backwards, so the particle moved into a hole has already been checked. Four
+    // particles are tested at once, most groups have no dead lane at all.
+    for (int32_t group = static_cast<int32_t>((pool.count + 3) / 4) - 1; group >= 0; --group)
+    {
+        const uint32_t base = static_cast<uint32_t>(group) * 4;
+        const uint32_t lanes = std::min(4u, pool.count - base);
+        const JPH::Vec4 life = Load(pool.age, base) * Load(pool.inverseLifetime, base);
+        const int dead = JPH::Vec4::sGreaterOrEqual(life, one).GetTrues() & ((1 << lanes) - 1);
+        if (dead == 0)
+            continue;
+        for (int32_t lane = static_cast<int32_t>(lanes) - 1; lane >= 0; --lane)
+        {
+            if ((dead & (1 << lane)) == 0)
+                continue;
+            pool.count--;
+            if (base + lane != pool.count)
+                move(pool.count, base + lane);
+        }
+    }
+}
+
+void ParticleSystem::Update(ES::Engine::Core &core)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const float deltaTime = core.GetScheduler<ES::Engine::Scheduler::FixedTimeUpdate>().GetTickRate();
+    auto &bodyInterface =
+        core.GetResource<ES::Plugin::Physics::Resource::PhysicsManager>().GetPhysicsSystem().GetBodyInterface();
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> signedUnit(-1.0f, 1.0f);
+
+    stats.spawned = 0;
+    stats.dropped = 0;
+
+    // Emission, O(wheels) plus the particles spawned
+    core.GetRegistry()
+        .view<ES::Plugin::Physics::Component::WheeledVehicle3D, ES::Plugin::Physics::Component::RigidBody3D>()
+        .each([&](auto &vehicle, auto &rigidBody) {
+            if (vehicle.vehicleConstraint == nullptr || rigidBody.body == nullptr)
+                return;
+            const auto wheelCount = static_cast<uint32_t>(vehicle.vehicleConstraint->GetWheels().size());
+            for (uint32_t w = 0; w < wheelCount; ++w)
+            {
+                const WheelContact contact = GetWheelContact(*rigidBody.body, *vehicle.vehicleConstraint->GetWheel(w));
+                if (!contact.hasContact)
+                    continue;
+                const Material material = IsLooseSurface(bodyInterface.GetMaterial(contact.groundBody,
+                                                                                   contact.groundSubShape))
+                                              ? Material::DUST
+                                              : Material::SMOKE;
+                const MaterialParams &params = MATERIALS[static_cast<uint32_t>(material)];
+                const float excess = contact.slipSpeed - params.slipThreshold;
+                if (excess <= 0.0f)
+                    continue;
+
+                // Fractional counts are resolved randomly so low rates still emit on average
+                const auto count = static_cast<uint32_t>(excess * params.rate * deltaTime + unit(random));
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    // Spread over the distance covered this tick instead of one clump per tick
+                    const glm::vec3 position =
+                        contact.position + contact.normal * 0.05f - contact.velocity * (deltaTime * unit(random));
+                    const glm::vec3 jitter(signedUnit(random), unit(random), signedUnit(random));
+                    const glm::vec3 velocity = contact.velocity * params.inherit + jitter * params.spread;
+                    Emit(material, position, velocity,
+                         params.sizeMin + (params.sizeMax - params.sizeMin) * unit(random));
+                }
+            }
+        });
+
+    // Simulation, chunked over the workers
+    auto &jobSystem = core.GetResource<TaskScheduler>().GetJobSystem();
+    JPH::JobSystem::Barrier *barrier = jobSystem.CreateBarrier();
+    for (uint32_t m = 0; m < MATERIAL_COUNT; ++m)
+    {
+        Pool &pool = pools[m];
+        const uint32_t padded = (pool.count + 3) & ~3u;
+        for (uint32_t first = 0; first < padded; first += CHUNK_SIZE)
+        {
+            const uint32_t last = std::min(first + CHUNK_SIZE, padded);
+            JPH::JobSystem::JobHandle job = jobSystem.CreateJob(
+                "ParticleChunk", JPH::Color::sGrey, [this, &pool, m, first, last, deltaTime] {
+                    Simulate(pool, static_cast<Material>(m), first, last, deltaTime);
+                });
+            barrier->AddJob(job);
+        }
+    }
+    jobSystem.WaitForJobs(barrier);
+    jobSystem.DestroyBarrier(barrier);
+
+    for (uint32_t m = 0; m < MATERIAL_COUNT; ++m)
+    {
+        RemoveDead(pools[m]);
+        stats.alive[m] = pools[m].count;
+    }
+    stats.updateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ParticleSystem::Pack(const Pool &pool, GpuParticle *destination, uint32_t first, uint32_t last) const
+{
+    for (uint32_t i = first; i < last; ++i)
+    {
+        destination[i].positionSize = glm::vec4(pool.positionX[i], pool.positionY[i], pool.positionZ[i], pool.size[i]);
+        destination[i].params =
+            glm::vec4(pool.alpha[i], pool.age[i] * pool.inverseLifetime[i], pool.seed[i], 0.0f);
+    }
+}
+
+void ParticleSystem::Draw(ES::Engine::Core &core)
+{
+    stats.drawCalls = 0;
+    if (mappedParticles == nullptr || (pools[0].count == 0 && pools[1].count == 0))
+        return;
+
+    GLsync &fence = regionFences[currentRegion];
+    if (fence != nullptr)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    // Each material owns a fixed range of the region, packed in parallel
+    auto *region = reinterpret_cast<GpuParticle *>(mappedParticles + currentRegion * regionSize);
+    std::array<uint32_t, MATERIAL_COUNT> offsets = {0, pools[0].capacity};
+    auto &jobSystem = core.GetResource<TaskScheduler>().GetJobSystem();
+    JPH::JobSystem::Barrier *barrier = jobSystem.CreateBarrier();
+    for (uint32_t m = 0; m < MATERIAL_COUNT; ++m)
+    {
+        const Pool &pool = pools[m];
+        GpuParticle *destination = region + offsets[m];
+        for (uint32_t first = 0; first < pool.count; first += CHUNK_SIZE)
+        {
+            const uint32_t last = std::min(first + CHUNK_SIZE, pool.count);
+            JPH::JobSystem::JobHandle job = jobSystem.CreateJob(
+                "ParticlePack", JPH::Color::sGrey,
+                [this, &pool, destination, first, last] { Pack(pool, destination, first, last); });
+            barrier->AddJob(job);
+        }
+    }
+    jobSystem.WaitForJobs(barrier);
+    jobSystem.DestroyBarrier(barrier);
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, PARTICLE_BUFFER_BINDING, particleBuffer, currentRegion * regionSize,
+                      regionSize);
+
+    using namespace entt;
+    auto &sp = core.GetResource<ES::Plugin::OpenGL::Resource::ShaderManager>().Get("particle"_hs);
+    sp.Use();
+    // Premultiplied alpha, drawn after the opaque geometry without writing depth
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    glBindVertexArray(emptyVao);
+    for (uint32_t m = 0; m < MATERIAL_COUNT; ++m)
+    {
+        if (pools[m].count == 0)
+            continue;
+        const glm::vec3 &tint = MATERIALS[m].tint;
+        glUniform1i(sp.GetUniform("ParticleOffset"), static_cast<GLint>(offsets[m]));
+        glUniform3f(sp.GetUniform("Tint"), tint.r, tint.g, tint.b);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(pools[m].count));
+        stats.drawCalls++;
+    }
+    glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    sp.Disable();
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    currentRegion = (currentRegion + 1) % FRAME_REGIONS;
+}
+
+void InitParticleSystem(ES::Engine::Core &core)
+{
+    core.GetResource<ParticleSystem>().Init();
+}
+
+void UpdateParticles(ES::Engine::Core &core)
+{
+    core.GetResource<ParticleSystem>().Update(core);
+}
+
+void RenderParticles(ES::Engine::Core &core)
+{
+    core.GetResource<ParticleSystem>().Draw(core);
+}
+
+void ShutdownParticleSystem(ES::Engine::Core &core)
+{
+    core.GetResource<ParticleSystem>().Shutdown();
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Core.hpp"
+#include "OpenGL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Tyre smoke and dust kicked up by sliding wheels.
+//
+// Particles live in fixed-capacity pools, one per material, stored as one array per
+// attribute so the update kernels process four particles per SIMD instruction. The
+// update is split in chunks over the TaskScheduler workers; dead particles are
+// swap-removed afterwards, nothing is allocated once the pools exist. Each material
+// is drawn with one instanced call of camera-facing quads, read from a persistently
+// mapped buffer fenced per frame like the InstanceBatcher one.
+class ParticleSystem {
+  public:
+    enum class Material : uint32_t {
+        SMOKE,
+        DUST,
+    };
+    static constexpr uint32_t MATERIAL_COUNT = 2;
+
+    // Mirrors one entry of the particle shader storage buffer, std430
+    struct GpuParticle {
+        // xyz: world position, w: size
+        glm::vec4 positionSize;
+        // x: alpha, y: age over lifetime, z: per particle random in [0, 1)
+        glm::vec4 params;
+    };
+
+    struct Stats {
+        std::array<uint32_t, MATERIAL_COUNT> alive = {};
+        uint32_t spawned = 0;
+        // Particles not spawned because their pool was full
+        uint32_t dropped = 0;
+        uint32_t drawCalls = 0;
+        float updateMs = 0.0f;
+    };
+
+    static constexpr uint32_t FRAME_REGIONS = 3;
+    static constexpr GLuint PARTICLE_BUFFER_BINDING = 3;
+
+    explicit ParticleSystem(uint32_t smokeCapacity = 131072, uint32_t dustCapacity = 32768);
+
+    ParticleSystem(ParticleSystem &&) = default;
+    ParticleSystem &operator=(ParticleSystem &&) = default;
+
+    // Must be called once a GL context exists
+    void Init();
+    void Shutdown();
+
+    // Emits from every sliding wheel and advances all particles by one tick
+    void Update(ES::Engine::Core &core);
+    void Draw(ES::Engine::Core &core);
+
+    void Emit(Material material, const glm::vec3 &position, const glm::vec3 &velocity, float size);
+
+    inline const Stats &GetStats() const { return stats; }
+
+  private:
+    // Structure of arrays. Sizes are rounded up to a multiple of 4 so the kernels
+    // never need a scalar tail; lanes past count hold stale values and are ignored.
+    struct Pool {
+        uint32_t capacity = 0;
+        uint32_t count = 0;
+        std::vector<float> positionX, positionY, positionZ;
+        std::vector<float> velocityX, velocityY, velocityZ;
+        std::vector<float> age, inverseLifetime;
+        std::vector<float> startSize, startAlpha, seed;
+        // Written by the kernel, read when packing for the GPU
+        std::vector<float> size, alpha;
+    };
+
+    void Simulate(Pool &pool, Material material, uint32_t first, uint32_t last, float deltaTime) const;
+    void RemoveDead(Pool &pool);
+    void Pack(const Pool &pool, GpuParticle *destination, uint32_t first, uint32_t last) const;
+
+    std::array<Pool, MATERIAL_COUNT> pools;
+    std::minstd_rand random;
+
+    GLuint particleBuffer = 0;
+    GLuint emptyVao = 0;
+    uint8_t *mappedParticles = nullptr;
+    std::size_t regionSize = 0;
+    uint32_t currentRegion = 0;
+    std::array<GLsync, FRAME_REGIONS> regionFences = {};
+    Stats stats;
+};
+
+void InitParticleSystem(ES::Engine::Core &core);
+
+void UpdateParticles(ES::Engine::Core &core);
+
+void RenderParticles(ES::Engine::Core &core);
+
+void ShutdownParticleSystem(ES::Engine::Core &core);
@@ -0,0 +1,89 @@
+#include "RangeAllocator.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+RangeAllocator::RangeAllocator(uint32_t capacity)
+{
+    Grow(capacity);
+}
+
+uint32_t RangeAllocator::Allocate(uint32_t size)
+{
+    if (size == 0)
+        return INVALID;
+
+    auto best = freeRanges.end();
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+    {
+        if (it->second >= size && (best == freeRanges.end() || it->second < best->second))
+        {
+            best = it;
+            if (best->second == size)
+                break;
+        }
+    }
+    if (best == freeRanges.end())
+        return INVALID;
+
+    const uint32_t offset = best->first;
+    const uint32_t remaining = best->second - size;
+    freeRanges.erase(best);
+    if (remaining > 0)
+        freeRanges.emplace(offset + size, remaining);
+    used += size;
+    return offset;
+}
+
+void RangeAllocator::Free(uint32_t offset, uint32_t size)
+{
+    if (size == 0)
+        return;
+    used -= size;
+
+    auto next = freeRanges.lower_bound(offset);
+    if (next != freeRanges.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            size += previous->second;
+            freeRanges.erase(previous);
+        }
+    }
+    if (next != freeRanges.end() && offset + size == next->first)
+    {
+        size += next->second;
+        freeRanges.erase(next);
+    }
+    freeRanges.emplace(offset, size);
+}
+
+void RangeAllocator::Grow(uint32_t newCapacity)
+{
+    if (newCapacity <= capacity)
+        return;
+    const uint32_t added = newCapacity - capacity;
+    // Counted as used for a moment, Free merges it with a free range at the end
+    used += added;
+    const uint32_t offset = capacity;
+    capacity = newCapacity;
+    Free(offset, added);
+}
+
+uint32_t RangeAllocator::GetLargestFreeRange() const
+{
+    uint32_t largest = 0;
+    for (const auto &[offset, size] : freeRanges)
+        largest = std::max(largest, size);
+    return largest;
+}
+
+float RangeAllocator::GetFragmentation() const
+{
+    const uint32_t freeSpace = capacity - used;
+    if (freeSpace == 0)
+        return 0.0f;
+    return 1.0f - static_cast<float>(GetLargestFreeRange()) / static_cast<float>(freeSpace);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+
+// Sub-allocates [0, capacity) in ranges of any size, for elements of a GPU buffer.
+// Free ranges are kept sorted by offset and merged with their neighbours when freed;
+// allocations take the smallest free range that fits.
+class RangeAllocator {
+  public:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    explicit RangeAllocator(uint32_t capacity = 0);
+
+    // Offset of the new range, INVALID when no free range is large enough
+    uint32_t Allocate(uint32_t size);
+    void Free(uint32_t offset, uint32_t size);
+    // Appends [capacity, newCapacity) as free space
+    void Grow(uint32_t newCapacity);
+
+    inline uint32_t GetCapacity() const { return capacity; }
+    inline uint32_t GetUsed() const { return used; }
+    inline uint32_t GetFreeRangeCount() const { return static_cast<uint32_t>(freeRanges.size()); }
+    uint32_t GetLargestFreeRange() const;
+    // 0 when all the free space is one range, close to 1 when it is scattered in
+    // small ranges
+    float GetFragmentation() const;
+
+  private:
+    // Offset to size
+    std::map<uint32_t, uint32_t> freeRanges;
+    uint32_t capacity = 0;
+    uint32_t used = 0;
+};
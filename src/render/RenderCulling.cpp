@@ -0,0 +1,118 @@
+#include "RenderCulling.hpp"
+
+#include "Frustum.hpp"
+#include "InstancedModel.hpp"
+#include "Object.hpp"
+#include "OpenGL.hpp"
+#include "physics/TransformSync.hpp"
+
+static Aabb ComputeMeshBounds(const ES::Plugin::Object::Component::Mesh &mesh)
+{
+    if (mesh.vertices.empty())
+        return {glm::vec3(0.0f), glm::vec3(0.0f)};
+
+    Aabb bounds{mesh.vertices[0], mesh.vertices[0]};
+    for (const auto &vertex : mesh.vertices)
+    {
+        bounds.min = glm::min(bounds.min, vertex);
+        bounds.max = glm::max(bounds.max, vertex);
+    }
+    return bounds;
+}
+
+Aabb TransformAabb(const Aabb &local, const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale)
+{
+    glm::vec3 center = (local.min + local.max) * 0.5f * scale;
+    glm::vec3 extents = (local.max - local.min) * 0.5f * glm::abs(scale);
+    glm::mat3 rotationMatrix = glm::mat3_cast(rotation);
+
+    glm::mat3 absRotation;
+    for (int i = 0; i < 3; ++i)
+        absRotation[i] = glm::abs(rotationMatrix[i]);
+
+    glm::vec3 worldCenter = position + rotationMatrix * center;
+    glm::vec3 worldExtents = absRotation * extents;
+    return {worldCenter - worldExtents, worldCenter + worldExtents};
+}
+
+void RenderCulling::Init(ES::Engine::Core &core)
+{
+    core.GetRegistry().on_destroy<CullProxy>().connect<&RenderCulling::OnCullProxyDestroyed>(*this);
+}
+
+void RenderCulling::OnCullProxyDestroyed(entt::registry &registry, entt::entity entity)
+{
+    tree.DestroyProxy(registry.get<CullProxy>(entity).proxy);
+}
+
+void RenderCulling::Update(ES::Engine::Core &core)
+{
+    using ES::Plugin::Object::Component::Mesh;
+    using ES::Plugin::Object::Component::Transform;
+
+    auto &registry = core.GetRegistry();
+    stats = {};
+
+    // Track renderables created since the last frame
+    pending.clear();
+    for (auto entity : registry.view<Transform, Mesh, InstancedModel>(entt::exclude<CullProxy>))
+        pending.push_back(entity);
+    for (auto entity : pending)
+    {
+        const auto &transform = registry.get<Transform>(entity);
+        CullProxy proxy;
+        proxy.localBounds = ComputeMeshBounds(registry.get<Mesh>(entity));
+        proxy.position = transform.position;
+        proxy.rotation = transform.rotation;
+        proxy.scale = transform.scale;
+        proxy.proxy = tree.CreateProxy(
+            TransformAabb(proxy.localBounds, transform.position, transform.rotation, transform.scale),
+            entt::to_integral(entity));
+        ES::Engine::Entity(entity).AddComponent<CullProxy>(core, proxy);
+    }
+
+    // Refit the proxies whose transform was marked dirty; small moves stay inside the fat AABB
+    for (entt::entity entity : core.GetResource<TransformSync>().GetDirty())
+    {
+        if (!registry.valid(entity) || !registry.all_of<Transform, CullProxy>(entity))
+            continue;
+        const auto &transform = registry.get<Transform>(entity);
+        auto &proxy = registry.get<CullProxy>(entity);
+        if (transform.position == proxy.position && transform.rotation == proxy.rotation &&
+            transform.scale == proxy.scale)
+            continue;
+        proxy.position = transform.position;
+        proxy.rotation = transform.rotation;
+        proxy.scale = transform.scale;
+        stats.moved++;
+        if (tree.MoveProxy(proxy.proxy,
+                           TransformAabb(proxy.localBounds, transform.position, transform.rotation, transform.scale)))
+            stats.reinserted++;
+    }
+
+    auto cull = [this](const glm::mat4 &viewProjection, std::vector<entt::entity> &out) {
+        Frustum frustum(viewProjection);
+        out.clear();
+        stats.nodesVisited += tree.Query(
+            [&frustum](const Aabb &aabb) { return static_cast<int>(frustum.Classify(aabb)); },
+            [&out](uint32_t userData) { out.push_back(static_cast<entt::entity>(userData)); });
+    };
+
+    auto &camera = core.GetResource<ES::Plugin::OpenGL::Resource::Camera>();
+    cull(camera.projection * camera.view, visible);
+    cull(core.GetResource<ES::Plugin::OpenGL::Resource::DirectionalLight>().lightSpaceMatrix, shadowCasters);
+
+    stats.proxies = tree.GetProxyCount();
+    stats.cameraVisible = static_cast<uint32_t>(visible.size());
+    stats.lightVisible = static_cast<uint32_t>(shadowCasters.size());
+}
+
+void InitRenderCulling(ES::Engine::Core &core)
+{
+    core.GetResource<RenderCulling>().Init(core);
+}
+
+void UpdateRenderCulling(ES::Engine::Core &core)
+{
+    core.GetResource<RenderCulling>().Update(core);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Core.hpp"
+#include "DynamicAabbTree.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <entt/entt.hpp>
+
+#include <vector>
+
+// Added by RenderCulling to every renderable it tracks
+struct CullProxy {
+    int32_t proxy = DynamicAabbTree::NULL_NODE;
+    // Mesh bounds in model space
+    Aabb localBounds;
+    // Transform the proxy was last refitted with
+    glm::vec3 position;
+    glm::quat rotation;
+    glm::vec3 scale;
+};
+
+// Keeps InstancedModel entities in a DynamicAabbTree and produces, every frame, the
+// list of entities inside the camera frustum and the list of shadow casters inside
+// the directional light frustum. Only the entities in the TransformSync dirty list
+// are refitted.
+class RenderCulling {
+  public:
+    struct Stats {
+        uint32_t proxies = 0;
+        uint32_t moved = 0;
+        uint32_t reinserted = 0;
+        uint32_t cameraVisible = 0;
+        uint32_t lightVisible = 0;
+        uint32_t nodesVisited = 0;
+    };
+
+    RenderCulling() = default;
+    RenderCulling(RenderCulling &&) = default;
+    RenderCulling &operator=(RenderCulling &&) = default;
+
+    // Hooks the removal of proxies to the destruction of their entities
+    void Init(ES::Engine::Core &core);
+
+    // Tracks new renderables, refits the dirty ones and culls against both frusta
+    void Update(ES::Engine::Core &core);
+
+    inline const std::vector<entt::entity> &GetVisible() const { return visible; }
+    inline const std::vector<entt::entity> &GetShadowCasters() const { return shadowCasters; }
+    inline const Stats &GetStats() const { return stats; }
+
+  private:
+    void OnCullProxyDestroyed(entt::registry &registry, entt::entity entity);
+
+    DynamicAabbTree tree;
+    std::vector<entt::entity> visible;
+    std::vector<entt::entity> shadowCasters;
+    std::vector<entt::entity> pending;
+    Stats stats;
+};
+
+// World space bounds of a model space box under the given transform
+Aabb TransformAabb(const Aabb &local, const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale);
+
+void InitRenderCulling(ES::Engine::Core &core);
+
+void UpdateRenderCulling(ES::Engine::Core &core);
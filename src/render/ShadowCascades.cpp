@@ -0,0 +1,389 @@
+#include "ShadowCascades.hpp"
+
+#include "InstancedModel.hpp"
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "RenderCulling.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static_assert(sizeof(ShadowCascades::ShadowBlock) % 16 == 0, "ShadowBlock must match the std140 layout");
+
+// Depth offsets applied while drawing casters, against acne on lit slopes
+constexpr float POLYGON_OFFSET_FACTOR = 2.0f;
+constexpr float POLYGON_OFFSET_UNITS = 4.0f;
+// Subtracted from the compared depth when sampling
+constexpr float SAMPLE_DEPTH_BIAS = 0.0005f;
+// Below this, the sun is considered to have moved and the static cache is redrawn
+constexpr float SUN_MOVED_COSINE = 0.9999f;
+
+glm::mat4 ShadowCascades::LightBounds::Projection() const
+{
+    return glm::ortho(min.x, max.x, min.y, max.y, nearDistance, farDistance);
+}
+
+static GLuint CreateDepthTarget(GLuint &texture, uint32_t size, bool compare)
+{
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, size, size);
+    const GLint filter = compare ? GL_LINEAR : GL_NEAREST;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (compare)
+    {
+        // Hardware PCF: texture() returns the lit fraction of the 2x2 footprint
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        ES::Utils::Log::Error(fmt::format("ShadowCascades: {0}x{0} depth target is incomplete", size));
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return framebuffer;
+}
+
+void ShadowCascades::Init(ES::Engine::Core &core)
+{
+    casters.Init();
+
+    glGenBuffers(1, &blockBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, blockBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ShadowBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SHADOW_BLOCK_BINDING, blockBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    atlasFramebuffer = CreateDepthTarget(atlas, settings.cascadeResolution * 2, true);
+    staticFramebuffer = CreateDepthTarget(staticDepth, settings.staticResolution, false);
+    glGenVertexArrays(1, &emptyVertexArray);
+
+    glActiveTexture(GL_TEXTURE0 + ATLAS_UNIT);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glActiveTexture(GL_TEXTURE0 + STATIC_DEPTH_UNIT);
+    glBindTexture(GL_TEXTURE_2D, staticDepth);
+    glActiveTexture(GL_TEXTURE0);
+
+    auto &registry = core.GetRegistry();
+    registry.on_construct<ES::Plugin::Physics::Component::RigidBody3D>()
+        .connect<&ShadowCascades::OnStaticSetChanged>(*this);
+    registry.on_destroy<ES::Plugin::Physics::Component::RigidBody3D>()
+        .connect<&ShadowCascades::OnStaticSetChanged>(*this);
+}
+
+void ShadowCascades::Shutdown()
+{
+    casters.Shutdown();
+    glDeleteBuffers(1, &blockBuffer);
+    glDeleteFramebuffers(1, &atlasFramebuffer);
+    glDeleteFramebuffers(1, &staticFramebuffer);
+    glDeleteTextures(1, &atlas);
+    glDeleteTextures(1, &staticDepth);
+    glDeleteVertexArrays(1, &emptyVertexArray);
+    blockBuffer = atlasFramebuffer = staticFramebuffer = atlas = staticDepth = emptyVertexArray = 0;
+}
+
+void ShadowCascades::OnStaticSetChanged(entt::registry &, entt::entity)
+{
+    staticDirty = true;
+}
+
+void ShadowCascades::Fit(ES::Engine::Core &core)
+{
+    auto &light = core.GetResource<ES::Plugin::OpenGL::Resource::DirectionalLight>();
+    auto &camera = core.GetResource<ES::Plugin::OpenGL::Resource::Camera>();
+
+    // The light view's backward axis points at the sun
+    const glm::vec3 direction =
+        glm::normalize(glm::vec3(light.lightView[0][2], light.lightView[1][2], light.lightView[2][2]));
+    if (glm::dot(direction, sunDirection) < SUN_MOVED_COSINE)
+    {
+        sunDirection = direction;
+        const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        lightView = glm::lookAt(glm::vec3(0.0f), -direction, up);
+        staticDirty = true;
+    }
+
+    // View distances of the camera's clip planes, from its perspective projection
+    const glm::mat4 &projection = camera.projection;
+    const float cameraNear = projection[3][2] / (projection[2][2] - 1.0f);
+    const float cameraFar = projection[3][2] / (projection[2][2] + 1.0f);
+    const float shadowFar = std::min(cameraFar, settings.shadowDistance);
+
+    const glm::mat4 inverse = glm::inverse(projection * camera.view);
+    std::array<glm::vec3, 4> nearCorners;
+    std::array<glm::vec3, 4> farCorners;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        const glm::vec2 ndc((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f);
+        const glm::vec4 nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+        const glm::vec4 farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+        nearCorners[i] = glm::vec3(nearPoint) / nearPoint.w;
+        farCorners[i] = glm::vec3(farPoint) / farPoint.w;
+    }
+
+    const float texel = 1.0f / static_cast<float>(settings.cascadeResolution);
+    const bool hasStatic = !staticCasters.empty();
+    LightBounds all;
+    all.min = glm::vec2(std::numeric_limits<float>::max());
+    all.max = glm::vec2(std::numeric_limits<float>::lowest());
+    all.nearDistance = std::numeric_limits<float>::max();
+    all.farDistance = std::numeric_limits<float>::lowest();
+
+    float sliceStart = cameraNear;
+    for (uint32_t c = 0; c < CASCADE_COUNT; ++c)
+    {
+        const float fraction = static_cast<float>(c + 1) / static_cast<float>(CASCADE_COUNT);
+        const float logSplit = cameraNear * std::pow(shadowFar / cameraNear, fraction);
+        const float uniformSplit = cameraNear + (shadowFar - cameraNear) * fraction;
+        const float sliceEnd = glm::mix(uniformSplit, logSplit, settings.splitBlend);
+
+        // Bounding sphere of the slice: its size does not change when the camera turns
+        std::array<glm::vec3, 8> corners;
+        glm::vec3 center(0.0f);
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const glm::vec3 ray = farCorners[i] - nearCorners[i];
+            corners[i] = nearCorners[i] + ray * ((sliceStart - cameraNear) / (cameraFar - cameraNear));
+            corners[i + 4] = nearCorners[i] + ray * ((sliceEnd - cameraNear) / (cameraFar - cameraNear));
+            center += (corners[i] + corners[i + 4]) / 8.0f;
+        }
+        float radius = 0.0f;
+        for (const glm::vec3 &corner : corners)
+            radius = std::max(radius, glm::length(corner - center));
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // Moves in whole texels only
+        glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+        const float step = 2.0f * radius * texel;
+        lightCenter.x = std::floor(lightCenter.x / step) * step;
+        lightCenter.y = std::floor(lightCenter.y / step) * step;
+
+        LightBounds &cascade = cascades[c];
+        cascade.min = glm::vec2(lightCenter) - radius;
+        cascade.max = glm::vec2(lightCenter) + radius;
+        // Casters between the sun and the slice count too
+        const float sphereNear = -lightCenter.z - radius;
+        cascade.nearDistance =
+            hasStatic ? std::min(sphereNear, staticBounds.nearDistance) : sphereNear - settings.depthMargin;
+        cascade.farDistance = -lightCenter.z + radius;
+
+        const glm::mat4 viewProjection = cascade.Projection() * lightView;
+        // Clip space to this cascade's quarter of the atlas, depth to [0, 1]
+        const glm::vec3 tile(static_cast<float>(c % 2), static_cast<float>(c / 2), 0.0f);
+        const glm::mat4 toAtlas = glm::translate(glm::mat4(1.0f), glm::vec3(0.25f, 0.25f, 0.5f) + tile * 0.5f) *
+                                  glm::scale(glm::mat4(1.0f), glm::vec3(0.25f, 0.25f, 0.5f));
+        block.cascadeViewProjection[c] = viewProjection;
+        block.cascadeAtlas[c] = toAtlas * viewProjection;
+        block.cascadeSplits[c] = sliceEnd;
+
+        all.min = glm::min(all.min, cascade.min);
+        all.max = glm::max(all.max, cascade.max);
+        all.nearDistance = std::min(all.nearDistance, cascade.nearDistance);
+        all.farDistance = std::max(all.farDistance, cascade.farDistance);
+        sliceStart = sliceEnd;
+    }
+
+    block.sunDirection = glm::vec4(sunDirection, 0.0f);
+    block.sunColor = glm::vec4(settings.sunColor, 1.0f);
+    block.params = glm::vec4(0.5f * texel, SAMPLE_DEPTH_BIAS, 0.0f, 0.0f);
+    glBindBuffer(GL_UNIFORM_BUFFER, blockBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShadowBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    light.lightView = lightView;
+    light.lightProjection = all.Projection();
+    light.lightSpaceMatrix = light.lightProjection * light.lightView;
+}
+
+void ShadowCascades::RenderStaticCache(ES::Engine::Core &core)
+{
+    using ES::Plugin::Physics::Component::RigidBody3D;
+
+    staticDirty = false;
+    staticCasters.clear();
+    auto &registry = core.GetRegistry();
+
+    glm::vec3 lightMin(std::numeric_limits<float>::max());
+    glm::vec3 lightMax(std::numeric_limits<float>::lowest());
+    registry.view<InstancedModel, CullProxy, RigidBody3D>().each(
+        [&](entt::entity entity, auto &, const CullProxy &proxy, const RigidBody3D &rigidBody) {
+            const bool isStatic = rigidBody.body != nullptr && !rigidBody.body->IsSensor() &&
+                                  rigidBody.body->GetObjectLayer() == ES::Plugin::Physics::Utils::Layers::NON_MOVING;
+            if (!isStatic)
+            {
+                registry.remove<StaticShadowCaster>(entity);
+                return;
+            }
+            registry.emplace_or_replace<StaticShadowCaster>(entity);
+            staticCasters.push_back(entity);
+
+            const Aabb bounds = TransformAabb(proxy.localBounds, proxy.position, proxy.rotation, proxy.scale);
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                const glm::vec3 corner((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y,
+                                       (i & 4) ? bounds.max.z : bounds.min.z);
+                const glm::vec3 lightCorner = glm::vec3(lightView * glm::vec4(corner, 1.0f));
+                lightMin = glm::min(lightMin, lightCorner);
+                lightMax = glm::max(lightMax, lightCorner);
+            }
+        });
+
+    stats.staticCasters = static_cast<uint32_t>(staticCasters.size());
+    stats.staticRebuilds++;
+    if (staticCasters.empty())
+        return;
+
+    staticBounds.min = glm::vec2(lightMin);
+    staticBounds.max = glm::vec2(lightMax);
+    // Light view z is negative in front: distances are its opposite
+    staticBounds.nearDistance = -lightMax.z - settings.depthMargin;
+    staticBounds.farDistance = -lightMin.z + 1.0f;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, staticFramebuffer);
+    glViewport(0, 0, static_cast<GLsizei>(settings.staticResolution), static_cast<GLsizei>(settings.staticResolution));
+    glDepthMask(GL_TRUE);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    using namespace entt;
+    auto &program = core.GetResource<ES::Plugin::OpenGL::Resource::ShaderManager>().Get("shadowStatic"_hs);
+    program.Use();
+    const glm::mat4 viewProjection = staticBounds.Projection() * lightView;
+    glUniformMatrix4fv(program.GetUniform("LightViewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+    casters.Collect(core, staticCasters);
+    casters.Draw(core, program, 1);
+
+    ES::Utils::Log::Info(fmt::format("ShadowCascades: {} static casters cached", staticCasters.size()));
+}
+
+void ShadowCascades::Composite(ES::Engine::Core &core)
+{
+    const auto size = static_cast<GLsizei>(settings.cascadeResolution);
+    glBindFramebuffer(GL_FRAMEBUFFER, atlasFramebuffer);
+    glDepthMask(GL_TRUE);
+    if (staticCasters.empty())
+    {
+        glViewport(0, 0, size * 2, size * 2);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        return;
+    }
+
+    using namespace entt;
+    auto &program = core.GetResource<ES::Plugin::OpenGL::Resource::ShaderManager>().Get("shadowComposite"_hs);
+    program.Use();
+    // Every texel is written, whatever was there
+    glDepthFunc(GL_ALWAYS);
+    glBindVertexArray(emptyVertexArray);
+    glUniform4f(program.GetUniform("CacheBounds"), staticBounds.min.x, staticBounds.min.y, staticBounds.max.x,
+                staticBounds.max.y);
+    for (uint32_t c = 0; c < CASCADE_COUNT; ++c)
+    {
+        const LightBounds &cascade = cascades[c];
+        const GLint x = static_cast<GLint>(c % 2) * size;
+        const GLint y = static_cast<GLint>(c / 2) * size;
+        glViewport(x, y, size, size);
+        glUniform4f(program.GetUniform("TileRect"), static_cast<float>(x), static_cast<float>(y),
+                    static_cast<float>(size), 0.0f);
+        glUniform4f(program.GetUniform("CascadeBounds"), cascade.min.x, cascade.min.y, cascade.max.x, cascade.max.y);
+        glUniform4f(program.GetUniform("DepthRanges"), cascade.nearDistance, cascade.farDistance,
+                    staticBounds.nearDistance, staticBounds.farDistance);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+    program.Disable();
+}
+
+void ShadowCascades::RenderDynamic(ES::Engine::Core &core)
+{
+    auto &registry = core.GetRegistry();
+    dynamicCasters.clear();
+    for (entt::entity entity : core.GetResource<RenderCulling>().GetShadowCasters())
+    {
+        if (!registry.all_of<StaticShadowCaster>(entity))
+            dynamicCasters.push_back(entity);
+    }
+    stats.dynamicCasters = static_cast<uint32_t>(dynamicCasters.size());
+    if (dynamicCasters.empty())
+        return;
+
+    const auto size = static_cast<GLsizei>(settings.cascadeResolution);
+    glViewport(0, 0, size * 2, size * 2);
+    for (GLenum plane = 0; plane < 4; ++plane)
+        glEnable(GL_CLIP_DISTANCE0 + plane);
+
+    using namespace entt;
+    auto &program = core.GetResource<ES::Plugin::OpenGL::Resource::ShaderManager>().Get("shadowCascade"_hs);
+    casters.Collect(core, dynamicCasters);
+    casters.Draw(core, program, CASCADE_COUNT);
+
+    for (GLenum plane = 0; plane < 4; ++plane)
+        glDisable(GL_CLIP_DISTANCE0 + plane);
+    stats.drawCalls += casters.GetStats().drawCalls;
+    stats.triangles += casters.GetStats().triangles;
+}
+
+void ShadowCascades::Render(ES::Engine::Core &core)
+{
+    stats.dynamicCasters = 0;
+    stats.drawCalls = 0;
+    stats.triangles = 0;
+    if (atlasFramebuffer == 0)
+        return;
+
+    GLint viewport[4] = {};
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+
+    if (staticDirty)
+    {
+        RenderStaticCache(core);
+        stats.drawCalls += casters.GetStats().drawCalls;
+        stats.triangles += casters.GetStats().triangles;
+    }
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    // The static depth is already offset
+    Composite(core);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    RenderDynamic(core);
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void InitShadowCascades(ES::Engine::Core &core)
+{
+    core.GetResource<ShadowCascades>().Init(core);
+}
+
+void FitShadowCascades(ES::Engine::Core &core)
+{
+    core.GetResource<ShadowCascades>().Fit(core);
+}
+
+void RenderShadowCascades(ES::Engine::Core &core)
+{
+    core.GetResource<ShadowCascades>().Render(core);
+}
+
+void ShutdownShadowCascades(ES::Engine::Core &core)
+{
+    core.GetResource<ShadowCascades>().Shutdown();
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Core.hpp"
+#include "InstanceBatcher.hpp"
+#include "OpenGL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <entt/entt.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Added by ShadowCascades to the renderables on NON_MOVING bodies, which are drawn
+// into the static cache instead of the cascades
+struct StaticShadowCaster {};
+
+// Directional light shadows in CASCADE_COUNT cascades fitted to the camera frustum.
+//
+// All cascades share one light orientation and live in the quarters of one depth
+// atlas. Each cascade is a square fitted around the bounding sphere of its slice of
+// the view frustum, and snapped to its own texels, so the shadow edges stay still
+// while the camera moves and turns.
+//
+// The static geometry (the floor and everything on a NON_MOVING body) is drawn once
+// into a large cached depth map covering its bounds, and drawn again only when a
+// rigid body is added or removed or the light turns. Every frame, each cascade starts
+// as a copy of its part of the cache, remapped to its depth range, and only the
+// dynamic shadow casters from RenderCulling are drawn on top, all of them into all
+// cascades with a single multi-draw.
+//
+// The sun's direction comes from the DirectionalLight resource. Its color, the
+// cascade matrices and the atlas lookup go to the programs through the "Shadows"
+// block (binding SHADOW_BLOCK_BINDING), the atlas through texture unit ATLAS_UNIT.
+class ShadowCascades {
+  public:
+    static constexpr uint32_t CASCADE_COUNT = 4;
+    static constexpr GLuint SHADOW_BLOCK_BINDING = 3;
+    static constexpr GLuint ATLAS_UNIT = 5;
+    static constexpr GLuint STATIC_DEPTH_UNIT = 6;
+
+    struct Settings {
+        // Texels per cascade side, the atlas is twice that
+        uint32_t cascadeResolution = 2048;
+        uint32_t staticResolution = 4096;
+        // No shadows farther from the camera
+        float shadowDistance = 150.0f;
+        // Between uniform (0) and logarithmic (1) splits
+        float splitBlend = 0.75f;
+        // Room above and below the static bounds for the dynamic casters
+        float depthMargin = 30.0f;
+        glm::vec3 sunColor = glm::vec3(1.0f);
+    };
+
+    // Mirrors the "Shadows" block, std140
+    struct ShadowBlock {
+        glm::mat4 cascadeViewProjection[CASCADE_COUNT];
+        // World to atlas texture coordinates and depth
+        glm::mat4 cascadeAtlas[CASCADE_COUNT];
+        // View distance each cascade ends at
+        glm::vec4 cascadeSplits;
+        // Towards the sun
+        glm::vec4 sunDirection;
+        glm::vec4 sunColor;
+        // x: atlas texel size, y: depth bias
+        glm::vec4 params;
+    };
+
+    struct Stats {
+        uint32_t staticCasters = 0;
+        uint32_t dynamicCasters = 0;
+        uint32_t drawCalls = 0;
+        uint64_t triangles = 0;
+        // Times the static cache was drawn since startup
+        uint32_t staticRebuilds = 0;
+    };
+
+    explicit ShadowCascades(const Settings &settings = Settings()) : settings(settings) {}
+
+    ShadowCascades(ShadowCascades &&) = default;
+    ShadowCascades &operator=(ShadowCascades &&) = default;
+
+    // Must be called once a GL context exists
+    void Init(ES::Engine::Core &core);
+    void Shutdown();
+
+    // Fits the cascades to the camera and sets the DirectionalLight's lightSpaceMatrix
+    // to their union, so the shadow casters RenderCulling finds cover all of them
+    void Fit(ES::Engine::Core &core);
+    // Redraws the static cache if needed, then the cascades
+    void Render(ES::Engine::Core &core);
+
+    inline const ShadowBlock &GetShadowBlock() const { return block; }
+    inline const Stats &GetStats() const { return stats; }
+
+  private:
+    // Orthographic bounds in light view space: distance along the light, not z
+    struct LightBounds {
+        glm::vec2 min = glm::vec2(0.0f);
+        glm::vec2 max = glm::vec2(0.0f);
+        float nearDistance = 0.0f;
+        float farDistance = 1.0f;
+
+        glm::mat4 Projection() const;
+    };
+
+    void OnStaticSetChanged(entt::registry &registry, entt::entity entity);
+
+    void RenderStaticCache(ES::Engine::Core &core);
+    void Composite(ES::Engine::Core &core);
+    void RenderDynamic(ES::Engine::Core &core);
+
+    Settings settings;
+    ShadowBlock block = {};
+    GLuint blockBuffer = 0;
+    GLuint atlas = 0;
+    GLuint atlasFramebuffer = 0;
+    GLuint staticDepth = 0;
+    GLuint staticFramebuffer = 0;
+    // Bound for the buffer-less composite triangle
+    GLuint emptyVertexArray = 0;
+
+    // Its own instance buffer and batches, the camera pass keeps the InstanceBatcher's
+    InstanceBatcher casters;
+    std::vector<entt::entity> staticCasters;
+    std::vector<entt::entity> dynamicCasters;
+    bool staticDirty = true;
+
+    glm::mat4 lightView = glm::mat4(1.0f);
+    // Zero until the first Fit
+    glm::vec3 sunDirection = glm::vec3(0.0f);
+    LightBounds staticBounds;
+    std::array<LightBounds, CASCADE_COUNT> cascades;
+    Stats stats;
+};
+
+void InitShadowCascades(ES::Engine::Core &core);
+
+void FitShadowCascades(ES::Engine::Core &core);
+
+void RenderShadowCascades(ES::Engine::Core &core);
+
+void ShutdownShadowCascades(ES::Engine::Core &core);
@@ -0,0 +1,247 @@
+#include "SkidMarks.hpp"
+
+#include "JoltPhysics.hpp"
+#include "Logger.hpp"
+#include "WheeledVehicle3D.hpp"
+#include "physics/WheelContact.hpp"
+
+#include <Jolt/Physics/Vehicle/VehicleConstraint.h>
+
+#include <algorithm>
+#include <cstddef>
+
+// Upper bound on a wait for the GPU to finish with a frame
+constexpr GLuint64 FENCE_TIMEOUT_NS = 1'000'000'000;
+// Slip speed, in m/s, from which a tyre leaves rubber
+constexpr float SLIP_THRESHOLD = 3.0f;
+// Slip above the threshold at which the mark is fully dark
+constexpr float SLIP_FULL = 8.0f;
+constexpr float MAX_ALPHA = 0.75f;
+// A quad is added every this many meters of trail
+constexpr float SEGMENT_LENGTH = 0.3f;
+// Longer jumps are teleports or rewinds: the trail restarts instead of bridging them
+constexpr float MAX_SEGMENT_LENGTH = 3.0f;
+// Lifted off the ground to stay clear of the track surface
+constexpr float GROUND_OFFSET = 0.01f;
+
+void SkidMarks::Init()
+{
+    if (capacity <= GUARD_QUADS)
+    {
+        ES::Utils::Log::Error(fmt::format("SkidMarks: capacity must exceed {} quads", GUARD_QUADS));
+        return;
+    }
+
+    const GLsizeiptr vertexBytes = static_cast<GLsizeiptr>(capacity) * 4 * sizeof(Vertex);
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferStorage(GL_ARRAY_BUFFER, vertexBytes, nullptr, flags);
+    mappedVertices = static_cast<Vertex *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexBytes, flags));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, alpha)));
+
+    // Every slot is a quad of its own, the index buffer never changes
+    std::vector<uint32_t> indices;
+    indices.reserve(static_cast<std::size_t>(capacity) * 6);
+    for (uint32_t quad = 0; quad < capacity; ++quad)
+    {
+        const uint32_t base = quad * 4;
+        indices.insert(indices.end(), {base, base + 1, base + 2, base + 2, base + 1, base + 3});
+    }
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (mappedVertices == nullptr)
+        ES::Utils::Log::Error("SkidMarks: failed to map the vertex ring");
+}
+
+void SkidMarks::Shutdown()
+{
+    for (auto &frame : frameFences)
+    {
+        if (frame.fence != nullptr)
+        {
+            glDeleteSync(frame.fence);
+            frame.fence = nullptr;
+        }
+    }
+    if (vertexBuffer != 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &vertexBuffer);
+        glDeleteBuffers(1, &indexBuffer);
+        glDeleteVertexArrays(1, &vao);
+        vertexBuffer = 0;
+        indexBuffer = 0;
+        vao = 0;
+        mappedVertices = nullptr;
+    }
+    written = 0;
+    trails.clear();
+}
+
+void SkidMarks::WaitForSlot(uint64_t serial)
+{
+    // A frame drew quads [head - (capacity - GUARD_QUADS), head): writing quad `serial`
+    // reuses the slot of quad serial - capacity, which that draw reads once serial
+    // reaches head + GUARD_QUADS
+    for (auto &frame : frameFences)
+    {
+        if (frame.fence == nullptr || serial < frame.head + GUARD_QUADS)
+            continue;
+        glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        glDeleteSync(frame.fence);
+        frame.fence = nullptr;
+        stats.fenceWaits++;
+    }
+}
+
+void SkidMarks::AddQuad(const Trail &from, const glm::vec3 &left, const glm::vec3 &right, float alpha)
+{
+    WaitForSlot(written);
+    Vertex *quad = mappedVertices + (written % capacity) * 4;
+    quad[0] = {from.left, from.alpha};
+    quad[1] = {from.right, from.alpha};
+    quad[2] = {left, alpha};
+    quad[3] = {right, alpha};
+    written++;
+    stats.quadsAdded++;
+}
+
+void SkidMarks::Update(ES::Engine::Core &core)
+{
+    stats.wheelsMarking = 0;
+    stats.quadsAdded = 0;
+    if (mappedVertices == nullptr)
+        return;
+
+    core.GetRegistry()
+        .view<ES::Plugin::Physics::Component::WheeledVehicle3D, ES::Plugin::Physics::Component::RigidBody3D>()
+        .each([this](entt::entity entity, auto &vehicle, auto &rigidBody) {
+            if (vehicle.vehicleConstraint == nullptr || rigidBody.body == nullptr)
+                return;
+
+            const std::size_t first = static_cast<std::size_t>(entt::to_entity(entity)) * MAX_WHEELS;
+            if (first + MAX_WHEELS > trails.size())
+                trails.resize(first + MAX_WHEELS);
+
+            const auto wheelCount =
+                std::min<uint32_t>(static_cast<uint32_t>(vehicle.vehicleConstraint->GetWheels().size()), MAX_WHEELS);
+            for (uint32_t w = 0; w < wheelCount; ++w)
+            {
+                Trail &trail = trails[first + w];
+                const JPH::Wheel &wheel = *vehicle.vehicleConstraint->GetWheel(w);
+                const WheelContact contact = GetWheelContact(*rigidBody.body, wheel);
+                if (!contact.hasContact || contact.slipSpeed < SLIP_THRESHOLD)
+                {
+                    trail.active = false;
+                    continue;
+                }
+                stats.wheelsMarking++;
+
+                const glm::vec3 center = contact.position + contact.normal * GROUND_OFFSET;
+                const glm::vec3 across = contact.lateral * (wheel.GetSettings()->mWidth * 0.5f);
+                const float alpha =
+                    MAX_ALPHA * std::clamp((contact.slipSpeed - SLIP_THRESHOLD) / (SLIP_FULL - SLIP_THRESHOLD), 0.2f,
+                                           1.0f);
+
+                // A reused entity slot or a jump starts a new trail
+                const float length = trail.active ? glm::distance(center, trail.center) : 0.0f;
+                if (!trail.active || trail.vehicle != entity || length > MAX_SEGMENT_LENGTH)
+                {
+                    trail = Trail{entity, true, center, center - across, center + across, alpha};
+                    continue;
+                }
+                if (length < SEGMENT_LENGTH)
+                    continue;
+
+                AddQuad(trail, center - across, center + across, alpha);
+                trail.center = center;
+                trail.left = center - across;
+                trail.right = center + across;
+                trail.alpha = alpha;
+            }
+        });
+}
+
+void SkidMarks::Draw(ES::Engine::Core &core)
+{
+    stats.quads = 0;
+    if (mappedVertices == nullptr || written == 0)
+        return;
+
+    // The drawable quads, oldest first, as at most two ranges of the ring
+    const uint64_t drawable = std::min<uint64_t>(written, capacity - GUARD_QUADS);
+    const uint64_t oldest = written - drawable;
+    const auto start = static_cast<uint32_t>(oldest % capacity);
+    const auto firstCount = static_cast<uint32_t>(std::min<uint64_t>(drawable, capacity - start));
+    std::array<GLsizei, 2> counts = {static_cast<GLsizei>(firstCount * 6),
+                                     static_cast<GLsizei>((drawable - firstCount) * 6)};
+    std::array<const void *, 2> offsets = {reinterpret_cast<const void *>(start * 6 * sizeof(uint32_t)), nullptr};
+    const GLsizei ranges = counts[1] > 0 ? 2 : 1;
+
+    using namespace entt;
+    auto &sp = core.GetResource<ES::Plugin::OpenGL::Resource::ShaderManager>().Get("skid"_hs);
+    sp.Use();
+    // The shader fades quads by how far behind the write head their slot is
+    glUniform1i(sp.GetUniform("HeadSlot"), static_cast<GLint>(written % capacity));
+    glUniform1i(sp.GetUniform("Capacity"), static_cast<GLint>(capacity));
+    glUniform1i(sp.GetUniform("Drawable"), static_cast<GLint>(capacity - GUARD_QUADS));
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(-1.0f, -1.0f);
+    glBindVertexArray(vao);
+    glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), ranges);
+    glBindVertexArray(0);
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    sp.Disable();
+    stats.quads = static_cast<uint32_t>(drawable);
+
+    FrameFence &frame = frameFences[currentFence];
+    if (frame.fence != nullptr)
+    {
+        glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        glDeleteSync(frame.fence);
+    }
+    frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame.head = written;
+    currentFence = (currentFence + 1) % FRAME_FENCES;
+}
+
+void InitSkidMarks(ES::Engine::Core &core)
+{
+    core.GetResource<SkidMarks>().Init();
+}
+
+void UpdateSkidMarks(ES::Engine::Core &core)
+{
+    core.GetResource<SkidMarks>().Update(core);
+}
+
+void RenderSkidMarks(ES::Engine::Core &core)
+{
+    core.GetResource<SkidMarks>().Draw(core);
+}
+
+void ShutdownSkidMarks(ES::Engine::Core &core)
+{
+    core.GetResource<SkidMarks>().Shutdown();
+}
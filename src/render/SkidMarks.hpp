@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Core.hpp"
+#include "OpenGL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <entt/entt.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Rubber left on the track by sliding tyres.
+//
+// Each wheel that slips past the threshold extends its trail by one quad, written
+// straight into a persistently mapped vertex ring buffer. When the ring is full the
+// oldest quads are overwritten, so memory stays fixed however long the race runs,
+// and the whole ring is drawn with one call. The newest GUARD_QUADS slots ahead of
+// the write head are left out of every draw: the CPU only waits on a frame fence
+// when it writes faster than the GPU consumes that margin.
+class SkidMarks {
+  public:
+    // Mirrors the vertex layout of the skid shader
+    struct Vertex {
+        glm::vec3 position;
+        float alpha;
+    };
+
+    struct Stats {
+        uint32_t wheelsMarking = 0;
+        uint32_t quadsAdded = 0;
+        // Quads currently drawn
+        uint32_t quads = 0;
+        uint32_t fenceWaits = 0;
+    };
+
+    static constexpr uint32_t MAX_WHEELS = 8;
+    static constexpr uint32_t GUARD_QUADS = 4096;
+    static constexpr uint32_t FRAME_FENCES = 3;
+
+    explicit SkidMarks(uint32_t capacityQuads = 65536) : capacity(capacityQuads) {}
+
+    SkidMarks(SkidMarks &&) = default;
+    SkidMarks &operator=(SkidMarks &&) = default;
+
+    // Must be called once a GL context exists
+    void Init();
+    void Shutdown();
+
+    // Extends the trail of every sliding wheel, O(wheels)
+    void Update(ES::Engine::Core &core);
+    void Draw(ES::Engine::Core &core);
+
+    inline const Stats &GetStats() const { return stats; }
+
+  private:
+    struct Trail {
+        entt::entity vehicle = entt::null;
+        bool active = false;
+        glm::vec3 center;
+        glm::vec3 left;
+        glm::vec3 right;
+        float alpha = 0.0f;
+    };
+
+    struct FrameFence {
+        GLsync fence = nullptr;
+        // Quads written when the frame was drawn
+        uint64_t head = 0;
+    };
+
+    void AddQuad(const Trail &from, const glm::vec3 &left, const glm::vec3 &right, float alpha);
+    void WaitForSlot(uint64_t serial);
+
+    uint32_t capacity;
+    GLuint vao = 0;
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    Vertex *mappedVertices = nullptr;
+    // Quads ever written, the ring slot of quad n is n % capacity
+    uint64_t written = 0;
+    std::array<FrameFence, FRAME_FENCES> frameFences = {};
+    uint32_t currentFence = 0;
+
+    // Indexed by entity slot * MAX_WHEELS + wheel
+    std::vector<Trail> trails;
+    Stats stats;
+};
+
+void InitSkidMarks(ES::Engine::Core &core);
+
+void UpdateSkidMarks(ES::Engine::Core &core);
+
+void RenderSkidMarks(ES::Engine::Core &core);
+
+void ShutdownSkidMarks(ES::Engine::Core &core);
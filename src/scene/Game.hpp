@@ -7,11 +7,22 @@
 #include "CreateVehicle.hpp"
 
 #include "Timer.hpp"
+#include "ai/AiDriver.hpp"
+#include "font/HudText.hpp"
+#include "ghost/GhostKeys.hpp"
+#include "ghost/GhostPlayer.hpp"
+#include "ghost/GhostRecorder.hpp"
+#include "perf/PerfOverlay.hpp"
+#include "perf/RenderBenchmark.hpp"
+#include "physics/PhysicsSnapshot.hpp"
+#include "race/LapTiming.hpp"
 
 using namespace ES::Plugin;
 
 struct StartupCircuitTimer {
     Timer timer;
+    // Player car, the one the lap recording follows
+    ES::Engine::Entity vehicle;
 };
 
 struct GameChrono {
@@ -20,17 +31,10 @@ struct GameChrono {
 
 void AddChronoDisplay(ES::Engine::Core &core)
 {
-    core.GetResource<ES::Plugin::OpenGL::Resource::FontManager>().Add(
-        entt::hashed_string("tomorrow"),
-        ES::Plugin::OpenGL::Utils::Font("asset/font/Tomorrow-Medium.ttf", 32)
-    );
-
+    // Drawn from the cached atlas, recreating the scene rasterizes nothing
     auto timeElapsedText = ES::Engine::Entity::Create(core);
 
-    timeElapsedText.AddComponent<ES::Plugin::UI::Component::Text>(core, "Time elapsed: 0.0s", glm::vec2(10.0f, 10.0f), 1.0f, ES::Plugin::Colors::Utils::WHITE_COLOR);
-    timeElapsedText.AddComponent<ES::Plugin::OpenGL::Component::FontHandle>(core, "tomorrow");
-    timeElapsedText.AddComponent<ES::Plugin::OpenGL::Component::ShaderHandle>(core, "textDefault");
-    timeElapsedText.AddComponent<ES::Plugin::OpenGL::Component::TextHandle>(core, "chronoText");
+    timeElapsedText.AddComponent<HudText>(core, HudText{"Time elapsed: 0.0s", glm::vec2(10.0f, 10.0f), 1.0f, glm::vec3(1.0f)});
     timeElapsedText.AddComponent<GameChrono>(core, Timer(1.f).SetInfinite(true));
 }
 
@@ -43,13 +47,21 @@ void UpdateTextTime(ES::Engine::Core &core)
         .each([&dt](auto, auto &chrono) {
             chrono.timer.Update(dt);
         });
+    // Once the recorded car has crossed the start line, show its lap on physics time
+    auto &timing = core.GetResource<LapTiming>();
+    auto &recorder = core.GetResource<GhostRecorder>();
+    const LapTiming::Car *car = recorder.IsRecording() ? timing.GetCar(static_cast<entt::entity>(recorder.GetVehicle())) : nullptr;
+
     core.GetRegistry()
-        .view<ES::Plugin::OpenGL::Component::TextHandle, ES::Plugin::UI::Component::Text, GameChrono>()
-        .each([](auto, auto &textHandle, auto &text, auto &chrono) {
-            if (textHandle.name == "chronoText")
-            {
-                text.text = fmt::format("Time elapsed: {:.2f}s", chrono.timer.elapsed);
-            }
+        .view<HudText, GameChrono>()
+        .each([&timing, car](auto, auto &text, auto &chrono) {
+            // Formatted in place: the string keeps its capacity from one frame to the next
+            text.text.clear();
+            if (car != nullptr && car->started)
+                fmt::format_to(std::back_inserter(text.text), "Lap {}: {:.2f}s  Best: {:.3f}s", car->lap,
+                               timing.GetTime() - car->lapStart, car->bestLap);
+            else
+                fmt::format_to(std::back_inserter(text.text), "Time elapsed: {:.2f}s", chrono.timer.elapsed);
         });
 }
 
@@ -66,6 +78,11 @@ void StartupCircuitTimerUpdate(ES::Engine::Core &core)
             }
             if (timer.Completed()) {
                 ES::Utils::Log::Info(fmt::format("Circuit timer completed after {} seconds", timer.elapsed));
+                // "Restart from checkpoint" goes back to the start of the run
+                core.GetResource<PhysicsSnapshotRing>().CaptureCheckpoint(core);
+                // Ghosts and the lap recording start with the race
+                core.GetResource<GhostRecorder>().Start(startupCircuitTimer.vehicle);
+                core.GetResource<GhostPlayer>().Restart();
                 ES::Engine::Entity(e).Destroy(core);
                 core.RegisterSystem<ES::Engine::Scheduler::Update>(UpdateTextTime);
             }
@@ -80,40 +97,48 @@ public:
 protected:
     void _onCreate(ES::Engine::Core &core) final
     {
-        CreateFloor(core);
-        CreateVehicle(core);
-
-        AddLights(core, "default");
-        AddLights(core, "noTextureLightShadow");
-        CreateStartChrono(core);
+        auto &aiDrivers = core.GetResource<AiDriverSystem>();
+        // Large AI fields run on a longer line, the floor has to cover it
+        CreateFloor(core, std::max(20.0f, aiDrivers.GetLine().GetExtent() + 10.0f));
+        ES::Engine::Entity player = CreateVehicle(core);
+        aiDrivers.Spawn(core, aiDrivers.GetSettings().carCount);
+        core.GetResource<LapTiming>().BuildGates(core, aiDrivers.GetLine());
+
+        AddLights(core);
+        CreateStartChrono(core, player);
         AddChronoDisplay(core);
+        core.GetResource<PerfOverlay>().CreateText(core);
+
+        // Ghosts move with the frame time, the benchmark images must not
+        if (!core.GetResource<RenderBenchmark>().IsEnabled())
+            core.GetResource<GhostPlayer>().LoadDirectory(core, GHOST_DIRECTORY);
     }
 
     void _onDestroy(ES::Engine::Core &core) final
     {
+        core.GetResource<PhysicsSnapshotRing>().Clear();
+        core.GetResource<GhostRecorder>().Cancel();
+        core.GetResource<GhostPlayer>().Clear();
+        core.GetResource<LapTiming>().Clear(core);
         core.ClearEntities();
     }
 
 private:
-    void CreateStartChrono(ES::Engine::Core &core)
+    void CreateStartChrono(ES::Engine::Core &core, ES::Engine::Entity player)
     {
         ES::Engine::Entity chrono = core.CreateEntity();
 
-        chrono.AddComponent<StartupCircuitTimer>(core, Timer(1.f).SetIterations(3));
+        chrono.AddComponent<StartupCircuitTimer>(core, StartupCircuitTimer{Timer(1.f).SetIterations(3), player});
 
         core.RegisterSystem<ES::Engine::Scheduler::Update>(StartupCircuitTimerUpdate);
     }
 
-    void AddLights(ES::Engine::Core &core, const std::string &shaderName)
+    // Lights are shared by every program through the FrameUniforms "Frame" block.
+    // The sun is the DirectionalLight, lit and shadowed through ShadowCascades.
+    void AddLights(ES::Engine::Core &core)
     {
         ES::Engine::Entity ambient_light = core.CreateEntity();
-        ambient_light.AddComponent<OpenGL::Component::ShaderHandle>(core, shaderName);
         ambient_light.AddComponent<Object::Component::Transform>(core);
         ambient_light.AddComponent<OpenGL::Component::Light>(core, OpenGL::Component::Light::Type::AMBIENT, glm::vec3(0.2f, 0.2f, 0.2f));
-
-        ES::Engine::Entity light_1 = core.CreateEntity();
-        light_1.AddComponent<OpenGL::Component::ShaderHandle>(core, shaderName);
-        light_1.AddComponent<Object::Component::Transform>(core, glm::vec3(3.0f, 20.0f, 0.0f));
-        light_1.AddComponent<OpenGL::Component::Light>(core, OpenGL::Component::Light::Type::POINT, glm::vec3(1.f, 1.f, 1.f));
     }
 };
\ No newline at end of file
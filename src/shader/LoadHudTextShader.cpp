@@ -0,0 +1,18 @@
+#include "LoadHudTextShader.hpp"
+
+#include "OpenGL.hpp"
+
+void LoadHudTextShader(ES::Engine::Core &core)
+{
+    // This "using" allow to use "_hs" compile time hashing for strings
+    using namespace entt;
+    using namespace ES::Plugin;
+    const std::string vertexShader = "asset/shader/text/hud_text.vs";
+    const std::string fragmentShader = "asset/shader/text/hud_text.fs";
+    auto &shaderManager = core.GetResource<OpenGL::Resource::ShaderManager>();
+    OpenGL::Utils::ShaderProgram &sp = shaderManager.Add("hudText"_hs);
+    sp.Create();
+    sp.InitFromFiles(vertexShader, fragmentShader);
+    // The atlas is on texture unit 0
+    sp.AddUniform("Projection");
+}
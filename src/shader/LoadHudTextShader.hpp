@@ -0,0 +1,5 @@
+#pragma once
+
+#include "Core.hpp"
+
+void LoadHudTextShader(ES::Engine::Core &core);
@@ -0,0 +1,18 @@
+#include "LoadInstancedShader.hpp"
+
+#include "OpenGL.hpp"
+
+void LoadInstancedShader(ES::Engine::Core &core)
+{
+    // This "using" allow to use "_hs" compile time hashing for strings
+    using namespace entt;
+    using namespace ES::Plugin;
+    const std::string vertexShader = "asset/shader/instanced/instanced.vs";
+    const std::string fragmentShader = "asset/shader/instanced/instanced.fs";
+    auto &shaderManager = core.GetResource<OpenGL::Resource::ShaderManager>();
+    OpenGL::Utils::ShaderProgram &sp = shaderManager.Add("instanced"_hs);
+    sp.Create();
+    sp.InitFromFiles(vertexShader, fragmentShader);
+    // No uniforms: camera, lights and materials come from the FrameUniforms blocks,
+    // instances from the InstanceBatcher's buffer
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "Core.hpp"
+
+void LoadInstancedShader(ES::Engine::Core &core);
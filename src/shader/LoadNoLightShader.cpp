@@ -3,7 +3,6 @@
 #include "LoadNoLightShader.hpp"
 
 #include "OpenGL.hpp"
-#include "Camera.hpp" // TODO: remove when camera is in OpenGL
 
 void LoadNoLightShader(ES::Engine::Core &core)
 {
@@ -25,9 +24,5 @@ void LoadNoLightShader(ES::Engine::Core &core)
     sp.AddUniform("Material.Ks");
     sp.AddUniform("Material.Shiness");
 
-    sp.AddUniform("CamPos");
-
-	sp.Use();
-    glUniform3fv(sp.GetUniform("CamPos"), 1, glm::value_ptr(core.GetResource<OpenGL::Resource::Camera>().viewer.getViewPoint()));
-	sp.Disable();
+    // CamPos comes from the "Frame" uniform block, updated every frame by FrameUniforms
 }
@@ -0,0 +1,19 @@
+#include "LoadParticleShader.hpp"
+
+#include "OpenGL.hpp"
+
+void LoadParticleShader(ES::Engine::Core &core)
+{
+    // This "using" allow to use "_hs" compile time hashing for strings
+    using namespace entt;
+    using namespace ES::Plugin;
+    const std::string vertexShader = "asset/shader/particle/particle.vs";
+    const std::string fragmentShader = "asset/shader/particle/particle.fs";
+    auto &shaderManager = core.GetResource<OpenGL::Resource::ShaderManager>();
+    OpenGL::Utils::ShaderProgram &sp = shaderManager.Add("particle"_hs);
+    sp.Create();
+    sp.InitFromFiles(vertexShader, fragmentShader);
+    // The camera comes from the FrameUniforms block, particles from ParticleSystem's buffer
+    sp.AddUniform("ParticleOffset");
+    sp.AddUniform("Tint");
+}
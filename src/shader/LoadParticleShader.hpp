@@ -0,0 +1,5 @@
+#pragma once
+
+#include "Core.hpp"
+
+void LoadParticleShader(ES::Engine::Core &core);
@@ -0,0 +1,30 @@
+#include "LoadShadowShaders.hpp"
+
+#include "OpenGL.hpp"
+
+void LoadShadowShaders(ES::Engine::Core &core)
+{
+    // This "using" allow to use "_hs" compile time hashing for strings
+    using namespace entt;
+    using namespace ES::Plugin;
+    const std::string depthFragmentShader = "asset/shader/shadow/shadow.fs";
+    auto &shaderManager = core.GetResource<OpenGL::Resource::ShaderManager>();
+
+    OpenGL::Utils::ShaderProgram &staticDepth = shaderManager.Add("shadowStatic"_hs);
+    staticDepth.Create();
+    staticDepth.InitFromFiles("asset/shader/shadow/shadow_static.vs", depthFragmentShader);
+    staticDepth.AddUniform("LightViewProjection");
+
+    // Cascade matrices come from the ShadowCascades "Shadows" block
+    OpenGL::Utils::ShaderProgram &cascadeDepth = shaderManager.Add("shadowCascade"_hs);
+    cascadeDepth.Create();
+    cascadeDepth.InitFromFiles("asset/shader/shadow/shadow_cascade.vs", depthFragmentShader);
+
+    OpenGL::Utils::ShaderProgram &composite = shaderManager.Add("shadowComposite"_hs);
+    composite.Create();
+    composite.InitFromFiles("asset/shader/shadow/shadow_composite.vs", "asset/shader/shadow/shadow_composite.fs");
+    composite.AddUniform("TileRect");
+    composite.AddUniform("CascadeBounds");
+    composite.AddUniform("CacheBounds");
+    composite.AddUniform("DepthRanges");
+}
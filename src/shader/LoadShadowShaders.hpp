@@ -0,0 +1,5 @@
+#pragma once
+
+#include "Core.hpp"
+
+void LoadShadowShaders(ES::Engine::Core &core);
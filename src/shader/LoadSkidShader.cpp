@@ -0,0 +1,20 @@
+#include "LoadSkidShader.hpp"
+
+#include "OpenGL.hpp"
+
+void LoadSkidShader(ES::Engine::Core &core)
+{
+    // This "using" allow to use "_hs" compile time hashing for strings
+    using namespace entt;
+    using namespace ES::Plugin;
+    const std::string vertexShader = "asset/shader/skid/skid.vs";
+    const std::string fragmentShader = "asset/shader/skid/skid.fs";
+    auto &shaderManager = core.GetResource<OpenGL::Resource::ShaderManager>();
+    OpenGL::Utils::ShaderProgram &sp = shaderManager.Add("skid"_hs);
+    sp.Create();
+    sp.InitFromFiles(vertexShader, fragmentShader);
+    // Ring position, to fade the oldest quads before they are overwritten
+    sp.AddUniform("HeadSlot");
+    sp.AddUniform("Capacity");
+    sp.AddUniform("Drawable");
+}
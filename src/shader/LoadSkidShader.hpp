@@ -0,0 +1,5 @@
+#pragma once
+
+#include "Core.hpp"
+
+void LoadSkidShader(ES::Engine::Core &core);
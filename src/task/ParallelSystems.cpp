@@ -0,0 +1,57 @@
+#include "ParallelSystems.hpp"
+
+#include "TaskScheduler.hpp"
+
+#include <algorithm>
+#include <utility>
+
+static bool Overlaps(const std::vector<entt::id_type> &a, const std::vector<entt::id_type> &b)
+{
+    return std::any_of(a.begin(), a.end(), [&b](entt::id_type id) { return std::find(b.begin(), b.end(), id) != b.end(); });
+}
+
+bool ParallelSystems::Access::ConflictsWith(const Access &other) const
+{
+    return Overlaps(writes, other.writes) || Overlaps(writes, other.reads) || Overlaps(reads, other.writes);
+}
+
+ParallelSystems &ParallelSystems::Add(const char *name, System system, const Access &access)
+{
+    uint32_t wave = 0;
+    for (const Entry &entry : entries)
+    {
+        if (entry.access.ConflictsWith(access))
+            wave = std::max(wave, entry.wave + 1);
+    }
+    if (wave >= waves.size())
+        waves.resize(wave + 1);
+    waves[wave].push_back(static_cast<uint32_t>(entries.size()));
+    entries.push_back(Entry{name, std::move(system), access, wave});
+    return *this;
+}
+
+void ParallelSystems::operator()(ES::Engine::Core &core) const
+{
+    for (const auto &wave : waves)
+    {
+        if (wave.size() == 1)
+        {
+            entries[wave.front()].system(core);
+            continue;
+        }
+
+        // The calling thread takes the first system, the others go to the workers
+        JPH::JobSystem &jobSystem = core.GetResource<TaskScheduler>().GetJobSystem();
+        JPH::JobSystem::Barrier *barrier = jobSystem.CreateBarrier();
+        for (std::size_t i = 1; i < wave.size(); ++i)
+        {
+            const Entry &entry = entries[wave[i]];
+            JPH::JobSystem::JobHandle job =
+                jobSystem.CreateJob(entry.name, JPH::Color::sGreen, [&entry, &core] { entry.system(core); });
+            barrier->AddJob(job);
+        }
+        entries[wave.front()].system(core);
+        jobSystem.WaitForJobs(barrier);
+        jobSystem.DestroyBarrier(barrier);
+    }
+}
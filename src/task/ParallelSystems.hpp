@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Engine.hpp"
+
+#include <entt/entt.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// A group of systems registered as one, which runs the ones that do not conflict at
+// the same time on the TaskScheduler. Each system declares the components and
+// resources it reads and writes. A system runs after every earlier system of the
+// group it conflicts with, so registration order is kept wherever it matters.
+class ParallelSystems
+{
+  public:
+    using System = std::function<void(ES::Engine::Core &)>;
+
+    class Access
+    {
+      public:
+        template <typename... T> Access &Read()
+        {
+            (reads.push_back(entt::type_hash<T>::value()), ...);
+            return *this;
+        }
+
+        template <typename... T> Access &Write()
+        {
+            (writes.push_back(entt::type_hash<T>::value()), ...);
+            return *this;
+        }
+
+        bool ConflictsWith(const Access &other) const;
+
+      private:
+        std::vector<entt::id_type> reads;
+        std::vector<entt::id_type> writes;
+    };
+
+    ParallelSystems &Add(const char *name, System system, const Access &access);
+
+    void operator()(ES::Engine::Core &core) const;
+
+    inline uint32_t GetWaveCount() const { return static_cast<uint32_t>(waves.size()); }
+
+  private:
+    struct Entry {
+        const char *name;
+        System system;
+        Access access;
+        uint32_t wave;
+    };
+
+    std::vector<Entry> entries;
+    // Indices into entries, the systems of one wave run concurrently
+    std::vector<std::vector<uint32_t>> waves;
+};
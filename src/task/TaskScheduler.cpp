@@ -0,0 +1,156 @@
+#include "TaskScheduler.hpp"
+
+#include "memory/AllocationStats.hpp"
+
+#include <chrono>
+
+// Worker index of the current thread in the job system it belongs to
+static thread_local const WorkStealingJobSystem *currentSystem = nullptr;
+static thread_local uint32_t currentWorker = 0;
+
+WorkStealingJobSystem::WorkStealingJobSystem(uint32_t maxJobs, uint32_t maxBarriers, uint32_t threadCount)
+    : JPH::JobSystemWithBarrier(maxBarriers)
+{
+    jobPool.Init(maxJobs, maxJobs);
+
+    threadCount = std::max(1u, threadCount);
+    workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+        workers.push_back(std::make_unique<Worker>());
+    // Started once every deque exists, a worker may steal from any of them
+    for (uint32_t i = 0; i < threadCount; ++i)
+        workers[i]->thread = std::thread([this, i] { Run(i); });
+}
+
+WorkStealingJobSystem::~WorkStealingJobSystem()
+{
+    {
+        std::lock_guard lock(sleepMutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+        worker->thread.join();
+
+    // Jobs nobody ran still hold the reference QueueJob took
+    for (auto &worker : workers)
+    {
+        for (Job *job : worker->jobs)
+            job->Release();
+    }
+}
+
+WorkStealingJobSystem::JobHandle WorkStealingJobSystem::CreateJob(const char *name, JPH::ColorArg color,
+                                                                  const JobFunction &function,
+                                                                  JPH::uint32 numDependencies)
+{
+    JPH::uint32 index;
+    // A full pool only happens when jobs are not being freed fast enough, wait for some
+    while ((index = jobPool.ConstructObject(name, color, this, function, numDependencies)) ==
+           JPH::FixedSizeFreeList<Job>::cInvalidObjectIndex)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+    Job *job = &jobPool.Get(index);
+    JobHandle handle(job);
+    if (numDependencies == 0)
+        QueueJob(job);
+    return handle;
+}
+
+void WorkStealingJobSystem::QueueJob(Job *job)
+{
+    job->AddRef();
+    Push(job);
+}
+
+void WorkStealingJobSystem::QueueJobs(Job **jobs, JPH::uint count)
+{
+    for (JPH::uint i = 0; i < count; ++i)
+    {
+        jobs[i]->AddRef();
+        Push(jobs[i]);
+    }
+}
+
+void WorkStealingJobSystem::FreeJob(Job *job)
+{
+    jobPool.DestroyObject(job);
+}
+
+void WorkStealingJobSystem::Push(Job *job)
+{
+    // Workers keep what they spawn, that work is usually hot in their cache
+    const uint32_t target = currentSystem == this ? currentWorker
+                                                  : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    {
+        std::lock_guard lock(workers[target]->mutex);
+        workers[target]->jobs.push_back(job);
+    }
+    queued.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock orders this push with a worker about to sleep
+    {
+        std::lock_guard lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+WorkStealingJobSystem::Job *WorkStealingJobSystem::Pop(uint32_t self)
+{
+    const auto count = static_cast<uint32_t>(workers.size());
+    for (uint32_t offset = 0; offset < count; ++offset)
+    {
+        Worker &worker = *workers[(self + offset) % count];
+        std::lock_guard lock(worker.mutex);
+        if (worker.jobs.empty())
+            continue;
+
+        Job *job;
+        if (offset == 0)
+        {
+            job = worker.jobs.back();
+            worker.jobs.pop_back();
+        }
+        else
+        {
+            job = worker.jobs.front();
+            worker.jobs.pop_front();
+        }
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+    return nullptr;
+}
+
+void WorkStealingJobSystem::Run(uint32_t self)
+{
+    currentSystem = this;
+    currentWorker = self;
+    AllocationStats::MarkJobWorkerThread();
+
+    while (!quit)
+    {
+        if (Job *job = Pop(self))
+        {
+            // A barrier may have run it already, Execute is then a no-op
+            job->Execute();
+            job->Release();
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex);
+        wake.wait(lock, [this] { return quit || queued.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+uint32_t TaskScheduler::GetDefaultThreadCount()
+{
+    // 0 when the count is unknown
+    const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    return std::max(2u, hardwareThreads) - 1;
+}
+
+TaskScheduler::TaskScheduler(uint32_t threadCount)
+    : jobSystem(std::make_unique<WorkStealingJobSystem>(MAX_JOBS, MAX_BARRIERS, threadCount))
+{
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Jolt job system with one deque per worker. Workers pop their own newest job first
+// and steal the oldest job of another worker when they run dry, jobs queued from a
+// thread outside the pool are dealt round-robin.
+class WorkStealingJobSystem final : public JPH::JobSystemWithBarrier
+{
+  public:
+    WorkStealingJobSystem(uint32_t maxJobs, uint32_t maxBarriers, uint32_t threadCount);
+    ~WorkStealingJobSystem() override;
+
+    WorkStealingJobSystem(const WorkStealingJobSystem &) = delete;
+    WorkStealingJobSystem &operator=(const WorkStealingJobSystem &) = delete;
+
+    // Workers plus the thread waiting on a barrier, which runs jobs too
+    int GetMaxConcurrency() const override { return static_cast<int>(workers.size()) + 1; }
+
+    JobHandle CreateJob(const char *name, JPH::ColorArg color, const JobFunction &function,
+                        JPH::uint32 numDependencies = 0) override;
+
+  protected:
+    void QueueJob(Job *job) override;
+    void QueueJobs(Job **jobs, JPH::uint count) override;
+    void FreeJob(Job *job) override;
+
+  private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job *> jobs;
+        std::thread thread;
+    };
+
+    void Push(Job *job);
+    Job *Pop(uint32_t self);
+    void Run(uint32_t self);
+
+    JPH::FixedSizeFreeList<Job> jobPool;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<uint32_t> nextWorker = 0;
+    // Jobs sitting in the deques, briefly negative while a pop overtakes its push
+    std::atomic<int32_t> queued = 0;
+    std::atomic<bool> quit = false;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+};
+
+// Owns the job system shared by the demo's parallel work: AI, physics queries and
+// the ParallelSystems groups. PhysicsSystem::Update does not run on it: the physics
+// plugin steps the world on its own JobSystemThreadPool, and nothing overlaps the step.
+class TaskScheduler
+{
+  public:
+    static constexpr uint32_t MAX_JOBS = 2048;
+    static constexpr uint32_t MAX_BARRIERS = 16;
+
+    explicit TaskScheduler(uint32_t threadCount = GetDefaultThreadCount());
+
+    // One worker per core besides the main thread. The physics plugin's pool never has
+    // work at the same time: the step and the systems using this pool take turns on the
+    // main thread, and the idle pool's workers sleep.
+    static uint32_t GetDefaultThreadCount();
+
+    TaskScheduler(TaskScheduler &&) = default;
+    TaskScheduler &operator=(TaskScheduler &&) = default;
+
+    inline JPH::JobSystem &GetJobSystem() { return *jobSystem; }
+    inline uint32_t GetThreadCount() const { return static_cast<uint32_t>(jobSystem->GetMaxConcurrency() - 1); }
+
+  private:
+    std::unique_ptr<WorkStealingJobSystem> jobSystem;
+};
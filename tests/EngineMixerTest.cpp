@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include "audio/EngineMixer.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+constexpr uint32_t SAMPLE_RATE = 48000;
+// One callback's worth of frames at 48 kHz
+constexpr uint32_t BLOCK = 480;
+
+static EngineMixer::Voice MakeVoice(uint32_t id, float rpm)
+{
+    EngineMixer::Voice voice;
+    voice.id = id;
+    voice.rpm = rpm;
+    voice.load = 1.0f;
+    voice.gear = 2;
+    voice.gain = 1.0f;
+    return voice;
+}
+
+// Mixes one block and returns its RMS over both channels
+static float MixBlock(EngineMixer &mixer, uint32_t frames = BLOCK)
+{
+    std::vector<float> output(frames * 2, 0.0f);
+    mixer.Mix(output.data(), frames);
+    double sum = 0.0;
+    for (float sample : output)
+        sum += static_cast<double>(sample) * sample;
+    return static_cast<float>(std::sqrt(sum / output.size()));
+}
+
+TEST(EngineMixer, SilentWithoutVoices)
+{
+    EngineMixer mixer(SAMPLE_RATE, 0.5f);
+
+    EXPECT_EQ(MixBlock(mixer), 0.0f);
+    EXPECT_EQ(mixer.GetFramesRendered(), BLOCK);
+}
+
+TEST(EngineMixer, PlaysPublishedVoicesWithinRange)
+{
+    EngineMixer mixer(SAMPLE_RATE, 0.5f);
+    mixer.GetWriteFrame().voices[0] = MakeVoice(1, 3000.0f);
+    mixer.Publish();
+
+    std::vector<float> output(BLOCK * 2, 0.0f);
+    float peak = 0.0f;
+    for (int block = 0; block < 20; ++block)
+    {
+        std::fill(output.begin(), output.end(), 0.0f);
+        mixer.Mix(output.data(), BLOCK);
+        for (float sample : output)
+            peak = std::max(peak, std::abs(sample));
+    }
+    EXPECT_GT(peak, 0.01f);
+    EXPECT_LT(peak, 1.0f);
+}
+
+TEST(EngineMixer, ReusedSlotFadesThePreviousCarOut)
+{
+    EngineMixer mixer(SAMPLE_RATE, 0.5f);
+    mixer.GetWriteFrame().voices[0] = MakeVoice(1, 3000.0f);
+    mixer.Publish();
+    // Let the first car reach its gain
+    float steady = 0.0f;
+    for (int block = 0; block < 20; ++block)
+        steady = MixBlock(mixer);
+    ASSERT_GT(steady, 0.0f);
+
+    // Another car takes the slot
+    mixer.GetWriteFrame().voices[0] = MakeVoice(2, 6000.0f);
+    mixer.Publish();
+
+    // The previous car does not stop dead: the start of the next block still plays
+    // it at close to its level, and it dies away over a few blocks
+    const float start = MixBlock(mixer, 24);
+    EXPECT_GT(start, steady * 0.5f);
+    float level = start;
+    for (int block = 0; block < 10 && level > 1e-4f; ++block)
+        level = MixBlock(mixer);
+    EXPECT_LT(level, start);
+
+    // Then the new car fades in
+    float late = 0.0f;
+    for (int block = 0; block < 20; ++block)
+        late = MixBlock(mixer);
+    EXPECT_GT(late, steady * 0.5f);
+}
+
+TEST(EngineMixer, RunsOnTheNullBackend)
+{
+    EngineMixer mixer(SAMPLE_RATE, 0.5f);
+    ASSERT_TRUE(mixer.Start(EngineMixer::Backend::NULL_DEVICE));
+    EXPECT_TRUE(mixer.IsRunning());
+
+    for (uint32_t voice = 0; voice < EngineMixer::MAX_VOICES; ++voice)
+        mixer.GetWriteFrame().voices[voice] = MakeVoice(voice + 1, 1000.0f + 800.0f * voice);
+    mixer.Publish();
+
+    // The null device pulls at its sample rate on its own thread, while this one
+    // keeps publishing like the game tick does
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    uint32_t tick = 0;
+    while (mixer.GetFramesRendered() < SAMPLE_RATE / 4 && std::chrono::steady_clock::now() < deadline)
+    {
+        EngineMixer::Frame &frame = mixer.GetWriteFrame();
+        for (uint32_t voice = 0; voice < EngineMixer::MAX_VOICES; ++voice)
+            frame.voices[voice] = MakeVoice(voice + 1 + (tick / 50) % 2 * EngineMixer::MAX_VOICES, 2000.0f + tick);
+        mixer.Publish();
+        tick++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(4));
+    }
+    EXPECT_GE(mixer.GetFramesRendered(), SAMPLE_RATE / 4);
+
+    mixer.Stop();
+    EXPECT_FALSE(mixer.IsRunning());
+    const uint64_t stopped = mixer.GetFramesRendered();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(mixer.GetFramesRendered(), stopped);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "input/InputService.hpp"
+
+#include <chrono>
+#include <thread>
+
+constexpr double TICK_SECONDS = 1.0 / 240.0;
+
+struct TickTotals {
+    uint32_t ticks = 0;
+    uint32_t presses = 0;
+    // Sum of GetKey over the ticks, in ticks held
+    double held = 0.0;
+};
+
+// Runs fixed ticks against the wall clock for that long, like the FixedTimeUpdate
+// scheduler does, without a window or the engine
+static TickTotals RunTicks(InputService &input, int key, double seconds)
+{
+    TickTotals totals;
+    auto next = std::chrono::steady_clock::now();
+    const auto end = next + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(seconds));
+    while (next < end)
+    {
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(TICK_SECONDS));
+        std::this_thread::sleep_until(next);
+        input.Consume(TICK_SECONDS);
+        totals.ticks++;
+        totals.presses += input.WasKeyPressed(key);
+        totals.held += input.GetKey(key);
+    }
+    return totals;
+}
+
+TEST(InputService, ReadsNothingWithoutDevices)
+{
+    InputService input;
+    const TickTotals totals = RunTicks(input, GLFW_KEY_W, 0.05);
+
+    EXPECT_EQ(totals.presses, 0u);
+    EXPECT_EQ(totals.held, 0.0);
+    EXPECT_EQ(input.GetStats().events, 0u);
+}
+
+TEST(InputService, TapsShorterThanATickAreNeverLost)
+{
+    SimulatedInputSettings settings;
+    settings.period = 0.1f;
+    // A quarter of a tick
+    settings.pressDuration = 0.001f;
+
+    InputService input;
+    input.StartSimulatedDevice(settings);
+    const TickTotals totals = RunTicks(input, settings.key, 1.0);
+
+    // One press per period, give or take the ones cut by the start and end of the run
+    EXPECT_GE(totals.presses, 9u);
+    EXPECT_LE(totals.presses, 11u);
+    EXPECT_EQ(input.GetStats().dropped, 0u);
+
+    // Every tap reads as held for the minimum press duration
+    const double heldSeconds = totals.held * TICK_SECONDS;
+    EXPECT_NEAR(heldSeconds / totals.presses, InputService::MIN_PRESS_SECONDS, 0.25 * InputService::MIN_PRESS_SECONDS);
+}
+
+TEST(InputService, LongPressesKeepTheirLength)
+{
+    SimulatedInputSettings settings;
+    settings.period = 0.25f;
+    settings.pressDuration = 0.1f;
+
+    InputService input;
+    input.StartSimulatedDevice(settings);
+    const TickTotals totals = RunTicks(input, settings.key, 1.0);
+
+    ASSERT_GT(totals.presses, 0u);
+    const double heldSeconds = totals.held * TICK_SECONDS;
+    EXPECT_NEAR(heldSeconds / totals.presses, settings.pressDuration, 0.25 * settings.pressDuration);
+}
+
+TEST(InputService, EventsReachTheNextTick)
+{
+    SimulatedInputSettings settings;
+    settings.period = 0.02f;
+    settings.pressDuration = 0.01f;
+
+    InputService input;
+    input.StartSimulatedDevice(settings);
+    RunTicks(input, settings.key, 1.0);
+
+    // From the device's timestamp to the tick that consumed it: within one tick on
+    // average, with room for the sleep granularity of a loaded machine at worst
+    const InputService::Stats &stats = input.GetStats();
+    EXPECT_LT(stats.averageLatencyMs, 2.0f * TICK_SECONDS * 1000.0f);
+    EXPECT_LT(stats.maxLatencyMs, 25.0f);
+    EXPECT_EQ(stats.dropped, 0u);
+}
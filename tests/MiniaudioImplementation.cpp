@@ -0,0 +1,3 @@
+// The demo gets miniaudio's implementation from the engine, the tests build their own
+#define MINIAUDIO_IMPLEMENTATION
+#include <miniaudio.h>
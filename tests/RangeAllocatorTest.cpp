@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include "render/RangeAllocator.hpp"
+
+TEST(RangeAllocator, AllocatesFromTheStart)
+{
+    RangeAllocator allocator(100);
+
+    EXPECT_EQ(allocator.Allocate(10), 0u);
+    EXPECT_EQ(allocator.Allocate(20), 10u);
+    EXPECT_EQ(allocator.GetUsed(), 30u);
+    EXPECT_EQ(allocator.GetFreeRangeCount(), 1u);
+    EXPECT_EQ(allocator.GetLargestFreeRange(), 70u);
+}
+
+TEST(RangeAllocator, RejectsEmptyAndOversizedRanges)
+{
+    RangeAllocator allocator(100);
+
+    EXPECT_EQ(allocator.Allocate(0), RangeAllocator::INVALID);
+    EXPECT_EQ(allocator.Allocate(101), RangeAllocator::INVALID);
+    EXPECT_EQ(allocator.Allocate(100), 0u);
+    EXPECT_EQ(allocator.Allocate(1), RangeAllocator::INVALID);
+    EXPECT_EQ(allocator.GetUsed(), 100u);
+}
+
+TEST(RangeAllocator, TakesTheSmallestRangeThatFits)
+{
+    RangeAllocator allocator(100);
+    const uint32_t a = allocator.Allocate(30);
+    allocator.Allocate(10);
+    const uint32_t c = allocator.Allocate(15);
+    allocator.Allocate(10);
+    allocator.Free(a, 30);
+    allocator.Free(c, 15);
+
+    // Free: [0, 30), [40, 55) and [65, 100)
+    EXPECT_EQ(allocator.Allocate(12), 40u);
+    EXPECT_EQ(allocator.Allocate(33), 65u);
+    EXPECT_EQ(allocator.Allocate(30), 0u);
+}
+
+TEST(RangeAllocator, FreeMergesWithBothNeighbours)
+{
+    RangeAllocator allocator(100);
+    const uint32_t a = allocator.Allocate(10);
+    const uint32_t b = allocator.Allocate(10);
+    const uint32_t c = allocator.Allocate(10);
+    allocator.Allocate(70);
+
+    allocator.Free(a, 10);
+    allocator.Free(c, 10);
+    EXPECT_EQ(allocator.GetFreeRangeCount(), 2u);
+    EXPECT_GT(allocator.GetFragmentation(), 0.0f);
+
+    allocator.Free(b, 10);
+    EXPECT_EQ(allocator.GetFreeRangeCount(), 1u);
+    EXPECT_EQ(allocator.GetLargestFreeRange(), 30u);
+    EXPECT_EQ(allocator.GetFragmentation(), 0.0f);
+    EXPECT_EQ(allocator.Allocate(30), 0u);
+}
+
+TEST(RangeAllocator, FreeingEverythingLeavesOneRange)
+{
+    RangeAllocator allocator(64);
+    uint32_t offsets[8];
+    for (uint32_t &offset : offsets)
+        offset = allocator.Allocate(8);
+    for (uint32_t i = 0; i < 8; i += 2)
+        allocator.Free(offsets[i], 8);
+    for (uint32_t i = 1; i < 8; i += 2)
+        allocator.Free(offsets[i], 8);
+
+    EXPECT_EQ(allocator.GetUsed(), 0u);
+    EXPECT_EQ(allocator.GetFreeRangeCount(), 1u);
+    EXPECT_EQ(allocator.GetLargestFreeRange(), 64u);
+}
+
+TEST(RangeAllocator, GrowAppendsFreeSpace)
+{
+    RangeAllocator allocator(100);
+    allocator.Allocate(100);
+
+    allocator.Grow(150);
+    EXPECT_EQ(allocator.GetCapacity(), 150u);
+    EXPECT_EQ(allocator.GetUsed(), 100u);
+    EXPECT_EQ(allocator.Allocate(50), 100u);
+
+    // Growing never shrinks
+    allocator.Grow(120);
+    EXPECT_EQ(allocator.GetCapacity(), 150u);
+}
+
+TEST(RangeAllocator, GrowMergesWithAFreeRangeAtTheEnd)
+{
+    RangeAllocator allocator(100);
+    allocator.Allocate(60);
+
+    allocator.Grow(200);
+    EXPECT_EQ(allocator.GetFreeRangeCount(), 1u);
+    EXPECT_EQ(allocator.Allocate(140), 60u);
+}
+
+TEST(RangeAllocator, EmptyAllocatorGrowsFromZero)
+{
+    RangeAllocator allocator;
+    EXPECT_EQ(allocator.Allocate(1), RangeAllocator::INVALID);
+
+    allocator.Grow(16);
+    EXPECT_EQ(allocator.Allocate(16), 0u);
+}
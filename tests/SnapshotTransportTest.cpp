@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include "net/SnapshotTransport.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Stands between a SnapshotClient and a SnapshotServer on loopback: the client's
+// packets go straight through, the server's are held until the test delivers them
+struct LoopbackRelay {
+    UdpSocket socket;
+    NetAddress server;
+    NetAddress client;
+    std::vector<std::vector<uint8_t>> held;
+
+    bool Open(uint16_t serverPort) { return NetAddress::Resolve("127.0.0.1", serverPort, server) && socket.Open(); }
+
+    void Pump()
+    {
+        uint8_t buffer[2048];
+        NetAddress from;
+        std::size_t size;
+        while ((size = socket.ReceiveFrom(from, buffer, sizeof(buffer))) > 0)
+        {
+            if (from == server)
+            {
+                held.emplace_back(buffer, buffer + size);
+                continue;
+            }
+            client = from;
+            socket.SendTo(server, buffer, size);
+        }
+    }
+
+    void Deliver(std::size_t index) { socket.SendTo(client, held[index].data(), held[index].size()); }
+};
+
+// Polls until done returns true, loopback delivery is quick but not synchronous
+template <typename Done> static bool WaitFor(Done done)
+{
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!done())
+    {
+        if (std::chrono::steady_clock::now() > end)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Far from the empty baseline, so a full snapshot sends every field at full width;
+// step moves every field by a small delta
+static QuantizedVehicleState MakeVehicle(uint16_t netId, int32_t step)
+{
+    const int32_t base = 1000 + netId * 37;
+    QuantizedVehicleState state;
+    state.netId = netId;
+    state.position = {base * 1024 + step, 2000 + base + step, -base * 512 + step};
+    state.rotationLargest = netId % 4;
+    state.rotation = {base + step, -base + step, 300 + base + step};
+    state.linearVelocity = {base + step, -base + step, 500 + base + step};
+    state.angularVelocity = {-base + step, base + step, 200 + step};
+    for (uint32_t i = 0; i < REPLICATED_WHEEL_COUNT; ++i)
+    {
+        state.wheelRotation[i] = (base + static_cast<int32_t>(i) * 500 + step) % 4096;
+        state.wheelSteer[i] = 200 + static_cast<int32_t>(i) + step;
+        state.suspensionLength[i] = 300 + static_cast<int32_t>(i) * 10 + step;
+    }
+    return state;
+}
+
+class SnapshotTransportTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(server.Start(0));
+        ASSERT_TRUE(relay.Open(server.GetPort()));
+        ASSERT_TRUE(client.Connect("127.0.0.1", relay.socket.GetPort()));
+        ASSERT_TRUE(WaitFor([this] {
+            relay.Pump();
+            server.ReceiveAcks();
+            return server.GetClientCount() == 1;
+        }));
+    }
+
+    // Sends MAX_REPLICATED_VEHICLES vehicles and returns the packets it took
+    std::size_t SendSnapshot(int32_t step)
+    {
+        const std::size_t before = server.GetPacketsSent();
+        ReplicationSnapshot &snapshot = server.NextSnapshot();
+        for (uint16_t netId = 1; netId <= MAX_REPLICATED_VEHICLES; ++netId)
+            snapshot.vehicles[snapshot.vehicleCount++] = MakeVehicle(netId, step);
+        relay.held.clear();
+        server.Send();
+
+        const std::size_t packets = server.GetPacketsSent() - before;
+        EXPECT_TRUE(WaitFor([&] {
+            relay.Pump();
+            return relay.held.size() == packets;
+        }));
+        return packets;
+    }
+
+    bool ReceiveSequence(uint32_t sequence)
+    {
+        return WaitFor([&] {
+            client.Receive();
+            return client.HasSnapshot() && client.GetLatestSequence() == sequence;
+        });
+    }
+
+    void ExpectVehicles(uint32_t sequence, int32_t step)
+    {
+        const ReplicationSnapshot *snapshot = client.FindSnapshot(sequence);
+        ASSERT_NE(snapshot, nullptr);
+        ASSERT_EQ(snapshot->vehicleCount, MAX_REPLICATED_VEHICLES);
+        for (uint16_t netId = 1; netId <= MAX_REPLICATED_VEHICLES; ++netId)
+            EXPECT_EQ(snapshot->vehicles[netId - 1], MakeVehicle(netId, step)) << "netId " << netId;
+    }
+
+    SnapshotServer server;
+    SnapshotClient client;
+    LoopbackRelay relay;
+};
+
+TEST_F(SnapshotTransportTest, SplitsFullSnapshotsUnderTheMaximumPacket)
+{
+    const std::size_t packets = SendSnapshot(0);
+
+    EXPECT_GT(packets, 1u);
+    EXPECT_GT(server.GetBytesSent(), REPLICATION_MAX_PACKET);
+    for (const auto &packet : relay.held)
+        EXPECT_LE(packet.size(), REPLICATION_MAX_PACKET);
+
+    for (std::size_t i = 0; i < relay.held.size(); ++i)
+        relay.Deliver(i);
+    ASSERT_TRUE(ReceiveSequence(1));
+    ExpectVehicles(1, 0);
+}
+
+TEST_F(SnapshotTransportTest, ReassemblesFragmentsInAnyOrderThenSendsDeltas)
+{
+    const std::size_t fullPackets = SendSnapshot(0);
+    for (std::size_t i = relay.held.size(); i-- > 0;)
+        relay.Deliver(i);
+    ASSERT_TRUE(ReceiveSequence(1));
+    ExpectVehicles(1, 0);
+
+    ASSERT_TRUE(WaitFor([this] {
+        relay.Pump();
+        server.ReceiveAcks();
+        return server.GetAckedSequence(0) == 1;
+    }));
+
+    // Against the acknowledged baseline every field is a small delta
+    const std::size_t deltaPackets = SendSnapshot(3);
+    EXPECT_LT(deltaPackets, fullPackets);
+    for (std::size_t i = 0; i < relay.held.size(); ++i)
+        relay.Deliver(i);
+    ASSERT_TRUE(ReceiveSequence(2));
+    ExpectVehicles(2, 3);
+}
+
+TEST_F(SnapshotTransportTest, NeverAcknowledgesAnIncompleteSnapshot)
+{
+    ASSERT_GT(SendSnapshot(0), 1u);
+    for (std::size_t i = 0; i + 1 < relay.held.size(); ++i)
+        relay.Deliver(i);
+    for (int i = 0; i < 20; ++i)
+    {
+        client.Receive();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_FALSE(client.HasSnapshot());
+    EXPECT_EQ(client.FindSnapshot(1), nullptr);
+
+    // Without an ack the server keeps sending full snapshots, the next one completes
+    relay.Pump();
+    server.ReceiveAcks();
+    EXPECT_EQ(server.GetAckedSequence(0), 0u);
+    SendSnapshot(1);
+    for (std::size_t i = 0; i < relay.held.size(); ++i)
+        relay.Deliver(i);
+    ASSERT_TRUE(ReceiveSequence(2));
+    ExpectVehicles(2, 1);
+    EXPECT_EQ(client.FindSnapshot(1), nullptr);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "audio/TripleBuffer.hpp"
+
+#include <cstdint>
+#include <thread>
+
+TEST(TripleBuffer, ReaderSeesNothingBeforeThePublish)
+{
+    TripleBuffer<int> buffer;
+    buffer.GetWriteBuffer() = 1;
+
+    EXPECT_FALSE(buffer.Update());
+    EXPECT_EQ(buffer.GetReadBuffer(), 0);
+}
+
+TEST(TripleBuffer, ReaderGetsTheNewestPublishedValue)
+{
+    TripleBuffer<int> buffer;
+    for (int value = 1; value <= 3; ++value)
+    {
+        buffer.GetWriteBuffer() = value;
+        buffer.Publish();
+    }
+
+    EXPECT_TRUE(buffer.Update());
+    EXPECT_EQ(buffer.GetReadBuffer(), 3);
+    // Nothing new since
+    EXPECT_FALSE(buffer.Update());
+    EXPECT_EQ(buffer.GetReadBuffer(), 3);
+}
+
+TEST(TripleBuffer, WriterNeverWritesTheSlotBeingRead)
+{
+    TripleBuffer<int> buffer;
+    buffer.GetWriteBuffer() = 1;
+    buffer.Publish();
+    ASSERT_TRUE(buffer.Update());
+
+    for (int value = 2; value < 10; ++value)
+    {
+        buffer.GetWriteBuffer() = value;
+        buffer.Publish();
+        EXPECT_EQ(buffer.GetReadBuffer(), 1);
+    }
+}
+
+// A value whose fields must never be seen from two different publishes
+struct Stamped {
+    uint64_t first = 0;
+    uint64_t payload[13] = {};
+    uint64_t last = 0;
+};
+
+TEST(TripleBuffer, ReaderOnlyEverSeesCompleteValues)
+{
+    constexpr uint64_t PUBLISHES = 200000;
+    TripleBuffer<Stamped> buffer;
+
+    std::thread writer([&buffer] {
+        for (uint64_t stamp = 1; stamp <= PUBLISHES; ++stamp)
+        {
+            Stamped &value = buffer.GetWriteBuffer();
+            value.first = stamp;
+            for (uint64_t &word : value.payload)
+                word = stamp;
+            value.last = stamp;
+            buffer.Publish();
+        }
+    });
+
+    uint64_t previous = 0;
+    uint64_t torn = 0;
+    uint64_t backwards = 0;
+    while (previous < PUBLISHES)
+    {
+        if (!buffer.Update())
+            continue;
+        const Stamped &value = buffer.GetReadBuffer();
+        for (uint64_t word : value.payload)
+            torn += word != value.first;
+        torn += value.last != value.first;
+        backwards += value.first <= previous;
+        previous = value.first;
+    }
+    writer.join();
+
+    EXPECT_EQ(torn, 0u);
+    EXPECT_EQ(backwards, 0u);
+}
@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+
+#include "net/VehicleStateCodec.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+constexpr float TWO_PI = 6.28318530718f;
+
+// Half a grid step of each field, plus float rounding of the inputs
+constexpr float POSITION_ERROR = 0.5f / 1024.0f + 1e-4f;
+constexpr float VELOCITY_ERROR = 0.5f / 100.0f + 1e-5f;
+constexpr float WHEEL_ANGLE_ERROR = 0.5f / 1000.0f + 1e-6f;
+constexpr float SUSPENSION_ERROR = 0.5f / 1000.0f + 1e-6f;
+// Wheel rotation is truncated to 4096 steps per turn
+constexpr float WHEEL_ROTATION_ERROR = TWO_PI / 4096.0f + 1e-5f;
+// 15 bits over +-1/sqrt(2) for each of the smallest three components, about 5e-5 at worst
+constexpr float ROTATION_ERROR = 1e-4f;
+
+static glm::quat RandomRotation(std::mt19937 &random)
+{
+    std::normal_distribution<float> normal;
+    return glm::normalize(glm::quat(normal(random), normal(random), normal(random), normal(random)));
+}
+
+static VehicleState RandomState(std::mt19937 &random)
+{
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> velocity(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> wheelRotation(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> wheelSteer(-0.6f, 0.6f);
+    std::uniform_real_distribution<float> suspension(0.0f, 0.5f);
+
+    VehicleState state;
+    state.position = glm::vec3(position(random), position(random) * 0.1f, position(random));
+    state.rotation = RandomRotation(random);
+    state.linearVelocity = glm::vec3(velocity(random), velocity(random), velocity(random));
+    state.angularVelocity = glm::vec3(velocity(random), velocity(random), velocity(random)) * 0.1f;
+    for (uint32_t i = 0; i < REPLICATED_WHEEL_COUNT; ++i)
+    {
+        state.wheelRotation[i] = wheelRotation(random);
+        state.wheelSteer[i] = wheelSteer(random);
+        state.suspensionLength[i] = suspension(random);
+    }
+    return state;
+}
+
+// Angle between two rotations, q and -q being the same one. Taken from the chord
+// between the quaternions: acos of their dot cannot resolve such small angles.
+static float RotationError(const glm::quat &a, const glm::quat &b)
+{
+    const double sign = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f ? -1.0 : 1.0;
+    const double dx = a.x - sign * b.x;
+    const double dy = a.y - sign * b.y;
+    const double dz = a.z - sign * b.z;
+    const double dw = a.w - sign * b.w;
+    const double chord = std::sqrt(dx * dx + dy * dy + dz * dz + dw * dw);
+    return static_cast<float>(4.0 * std::asin(std::min(1.0, chord * 0.5)));
+}
+
+static void ExpectWithinBounds(const VehicleState &expected, const VehicleState &actual)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_NEAR(actual.position[i], expected.position[i], POSITION_ERROR);
+        EXPECT_NEAR(actual.linearVelocity[i], expected.linearVelocity[i], VELOCITY_ERROR);
+        EXPECT_NEAR(actual.angularVelocity[i], expected.angularVelocity[i], VELOCITY_ERROR);
+    }
+    EXPECT_LE(RotationError(actual.rotation, expected.rotation), ROTATION_ERROR);
+    for (uint32_t i = 0; i < REPLICATED_WHEEL_COUNT; ++i)
+    {
+        EXPECT_LE(std::abs(std::remainder(actual.wheelRotation[i] - expected.wheelRotation[i], TWO_PI)),
+                  WHEEL_ROTATION_ERROR);
+        EXPECT_NEAR(actual.wheelSteer[i], expected.wheelSteer[i], WHEEL_ANGLE_ERROR);
+        EXPECT_NEAR(actual.suspensionLength[i], expected.suspensionLength[i], SUSPENSION_ERROR);
+    }
+}
+
+// Writes state against baseline and reads it back
+static QuantizedVehicleState RoundTrip(const QuantizedVehicleState &state, const QuantizedVehicleState &baseline,
+                                       std::size_t *bits = nullptr)
+{
+    uint8_t buffer[256];
+    BitWriter writer(buffer, sizeof(buffer));
+    WriteVehicleDelta(writer, state, baseline);
+    EXPECT_FALSE(writer.HasOverflowed());
+    if (bits != nullptr)
+        *bits = writer.GetBitsWritten();
+
+    BitReader reader(buffer, writer.GetBytesWritten());
+    QuantizedVehicleState read = ReadVehicleDelta(reader, state.netId, baseline);
+    EXPECT_FALSE(reader.HasOverflowed());
+    return read;
+}
+
+TEST(VehicleStateCodec, FullStatesSurviveTheWireWithinOneStep)
+{
+    std::mt19937 random(31);
+    const QuantizedVehicleState empty;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const VehicleState state = RandomState(random);
+        const QuantizedVehicleState quantized = QuantizeVehicleState(7, state);
+        const QuantizedVehicleState read = RoundTrip(quantized, empty);
+
+        ASSERT_EQ(read, quantized);
+        ExpectWithinBounds(state, DequantizeVehicleState(read));
+    }
+}
+
+TEST(VehicleStateCodec, SmallestThreeKeepsEdgeRotations)
+{
+    const float half = 0.70710678f;
+    const glm::quat rotations[] = {
+        glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+        glm::quat(-1.0f, 0.0f, 0.0f, 0.0f),
+        glm::quat(0.0f, 1.0f, 0.0f, 0.0f),
+        glm::quat(0.0f, 0.0f, 0.0f, -1.0f),
+        // Two components tie for the largest
+        glm::quat(half, half, 0.0f, 0.0f),
+        glm::quat(0.0f, half, -half, 0.0f),
+        glm::quat(0.5f, -0.5f, 0.5f, -0.5f),
+        glm::normalize(glm::quat(-0.2f, 0.9f, 0.1f, -0.3f)),
+    };
+    for (const glm::quat &rotation : rotations)
+    {
+        VehicleState state;
+        state.rotation = rotation;
+        const QuantizedVehicleState quantized = QuantizeVehicleState(1, state);
+        EXPECT_LE(RotationError(DequantizeVehicleState(quantized).rotation, rotation), ROTATION_ERROR)
+            << rotation.w << " " << rotation.x << " " << rotation.y << " " << rotation.z;
+    }
+}
+
+TEST(VehicleStateCodec, ClampsValuesOutsideTheirRange)
+{
+    VehicleState state;
+    state.linearVelocity = glm::vec3(1e6f, -1e6f, 0.0f);
+    state.wheelSteer[0] = 100.0f;
+    const QuantizedVehicleState quantized = QuantizeVehicleState(1, state);
+    const QuantizedVehicleState read = RoundTrip(quantized, QuantizedVehicleState());
+    ASSERT_EQ(read, quantized);
+
+    const VehicleState decoded = DequantizeVehicleState(read);
+    // Saturated at the full width of the field, with the sign kept
+    EXPECT_NEAR(decoded.linearVelocity.x, ((1 << 19) - 1) / 100.0f, VELOCITY_ERROR);
+    EXPECT_NEAR(decoded.linearVelocity.y, -((1 << 19) - 1) / 100.0f, VELOCITY_ERROR);
+    EXPECT_NEAR(decoded.wheelSteer[0], ((1 << 11) - 1) / 1000.0f, WHEEL_ANGLE_ERROR);
+}
+
+TEST(VehicleStateCodec, UnchangedVehicleCostsOneBit)
+{
+    std::mt19937 random(5);
+    const QuantizedVehicleState baseline = QuantizeVehicleState(3, RandomState(random));
+    QuantizedVehicleState state = baseline;
+    std::size_t bits = 0;
+    EXPECT_EQ(RoundTrip(state, baseline, &bits), state);
+    EXPECT_EQ(bits, 1u);
+
+    // A baseline found under another netId still compares on the state alone
+    QuantizedVehicleState renamed = baseline;
+    renamed.netId = 9;
+    state.netId = 4;
+    EXPECT_EQ(RoundTrip(state, renamed, &bits), state);
+    EXPECT_EQ(bits, 1u);
+}
+
+TEST(VehicleStateCodec, DeltasAreExactOnBothSidesOfTheSmallRange)
+{
+    std::mt19937 random(11);
+    const QuantizedVehicleState baseline = QuantizeVehicleState(3, RandomState(random));
+    // SMALL_DELTA_BITS is 8: [-128, 127] is sent as a delta, anything else in full
+    for (const int32_t delta : {-129, -128, -1, 1, 127, 128, 5000})
+    {
+        QuantizedVehicleState state = baseline;
+        state.position[0] += delta;
+        state.rotation[1] += delta;
+        state.linearVelocity[2] -= delta;
+        state.wheelSteer[3] = std::clamp(state.wheelSteer[3] + delta, -2047, 2047);
+        EXPECT_EQ(RoundTrip(state, baseline), state) << "delta " << delta;
+    }
+
+    QuantizedVehicleState extremes = baseline;
+    extremes.position = {INT32_MAX, INT32_MIN + 1, 0};
+    extremes.linearVelocity = {(1 << 19) - 1, -((1 << 19) - 1), 0};
+    EXPECT_EQ(RoundTrip(extremes, baseline), extremes);
+}
+
+TEST(VehicleStateCodec, RotationDroppingAnotherComponentIgnoresTheBaseline)
+{
+    // A component close to 0 goes out as a small delta against zero, which only reads
+    // back right if the reader ignores the baseline's non-zero components too
+    VehicleState from;
+    from.rotation = glm::normalize(glm::quat(0.8f, 0.3f, -0.4f, 0.3f));
+    VehicleState to;
+    to.rotation = glm::normalize(glm::quat(0.1f, 0.9f, 0.2f, 0.002f));
+
+    const QuantizedVehicleState baseline = QuantizeVehicleState(1, from);
+    const QuantizedVehicleState state = QuantizeVehicleState(1, to);
+    ASSERT_NE(state.rotationLargest, baseline.rotationLargest);
+
+    const QuantizedVehicleState read = RoundTrip(state, baseline);
+    EXPECT_EQ(read, state);
+    EXPECT_LE(RotationError(DequantizeVehicleState(read).rotation, to.rotation), ROTATION_ERROR);
+}
+
+TEST(VehicleStateCodec, RandomDeltaChainsStayExact)
+{
+    // What a client sees: every snapshot a delta against the previous one it holds
+    std::mt19937 random(47);
+    std::uniform_int_distribution<int32_t> small(-200, 200);
+    std::bernoulli_distribution changes(0.3);
+
+    VehicleState state = RandomState(random);
+    QuantizedVehicleState server = QuantizeVehicleState(2, state);
+    QuantizedVehicleState client = RoundTrip(server, QuantizedVehicleState());
+    for (int i = 0; i < 500; ++i)
+    {
+        QuantizedVehicleState next = changes(random) ? QuantizeVehicleState(2, RandomState(random)) : server;
+        for (auto &value : next.position)
+            value += small(random);
+        for (auto &value : next.wheelRotation)
+            value = std::clamp(value + small(random), 0, 4095);
+
+        client = RoundTrip(next, client);
+        ASSERT_EQ(client, next) << "step " << i;
+        server = next;
+    }
+}
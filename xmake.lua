@@ -1,4 +1,5 @@
-add_requires("entt", "gtest", "glm >=1.0.1", "glfw >=3.4", "glew", "spdlog", "fmt", "stb", "joltphysics", "miniaudio")
+add_requires("entt", "glm >=1.0.1", "glfw >=3.4", "glew", "spdlog", "fmt", "stb", "joltphysics", "miniaudio")
+add_requires("gtest", {configs = {main = true}})
 
 includes("../EngineSquared/xmake.lua")
 
@@ -25,6 +26,24 @@ target("VehicleDemo")
 
     set_rundir("$(projectdir)")
 
+-- Engine-free parts of the demo, run with xmake test
+target("VehicleDemoTests")
+    set_kind("binary")
+    set_default(false)
+
+    add_files("tests/**.cpp")
+    add_files("src/audio/EngineMixer.cpp")
+    add_files("src/input/InputService.cpp")
+    add_files("src/net/SnapshotTransport.cpp")
+    add_files("src/net/UdpSocket.cpp")
+    add_files("src/net/VehicleStateCodec.cpp")
+    add_files("src/render/RangeAllocator.cpp")
+    add_includedirs("$(projectdir)/src/")
+
+    add_packages("gtest", "glm", "glfw", "miniaudio")
+    add_tests("default")
+
+    set_rundir("$(projectdir)")
 
 if is_mode("debug") then
     add_defines("ES_DEBUG")